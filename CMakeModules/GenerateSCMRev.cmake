@@ -87,4 +87,17 @@ foreach (F IN LISTS HASH_FILES)
     set(COMBINED "${COMBINED}${TMP}")
 endforeach()
 string(MD5 SHADER_CACHE_VERSION "${COMBINED}")
+
+# The x64 shader JIT disk cache stores native code, which only depends on the JIT itself
+set(JIT_HASH_FILES
+    "${VIDEO_CORE}/shader/shader.h"
+    "${VIDEO_CORE}/shader/shader_jit_x64_compiler.cpp"
+    "${VIDEO_CORE}/shader/shader_jit_x64_compiler.h"
+)
+set(COMBINED "")
+foreach (F IN LISTS JIT_HASH_FILES)
+    file(READ ${F} TMP)
+    set(COMBINED "${COMBINED}${TMP}")
+endforeach()
+string(MD5 SHADER_JIT_CACHE_VERSION "${COMBINED}")
 configure_file("${SRC_DIR}/src/common/scm_rev.cpp.in" "scm_rev.cpp" @ONLY)
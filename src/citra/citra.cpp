@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <regex>
@@ -19,6 +20,7 @@
 #endif
 
 #include "citra/config.h"
+#include "citra/emu_window/emu_window_headless.h"
 #include "citra/emu_window/emu_window_sdl2.h"
 #include "citra/lodepng_image_interface.h"
 #include "common/common_paths.h"
@@ -31,6 +33,7 @@
 #include "common/scope_exit.h"
 #include "common/string_util.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/dumping/backend.h"
 #include "core/file_sys/cia_container.h"
 #include "core/frontend/applets/default_applets.h"
@@ -68,6 +71,9 @@ static void PrintHelp(const char* argv0) {
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
+                 "-n, --headless       Run without a window, using the software rasterizer\n"
+                 "-b, --benchmark=FRAMES     Run FRAMES emulated frames headless and without frame"
+                 " limiting, then print the results as JSON\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
@@ -169,6 +175,91 @@ static void OnStatusMessageReceived(const Network::StatusMessageEntry& msg) {
         std::cout << std::endl << "* " << message << std::endl << std::endl;
 }
 
+#if MICROPROFILE_ENABLED
+/// Enables all MicroProfile groups and starts accumulating their timers from zero
+static void ResetProfileTotals() {
+    MicroProfileSetForceEnable(true);
+    MicroProfileSetEnableAllGroups(true);
+    MicroProfileSetAggregateFrames(0);
+    MicroProfileFlip();
+}
+
+/// Formats the MicroProfile timers accumulated since ResetProfileTotals as a JSON object
+static std::string GetProfileTotals() {
+    MicroProfileFlip();
+
+    std::lock_guard lock{MicroProfileGetMutex()};
+    const MicroProfile& profile = *MicroProfileGet();
+    const float to_ms = MicroProfileTickToMsMultiplier(MicroProfileTicksPerSecondCpu());
+
+    std::string result;
+    for (u32 i = 0; i < profile.nTotalTimers; ++i) {
+        const MicroProfileTimer& timer = profile.Aggregate[i];
+        if (timer.nCount == 0) {
+            continue;
+        }
+        const MicroProfileTimerInfo& info = profile.TimerInfo[i];
+        const MicroProfileGroupInfo& group = profile.GroupInfo[info.nGroupIndex];
+        if (!result.empty()) {
+            result += ",\n";
+        }
+        result += fmt::format("    \"{}/{}\": {{\"total_ms\": {:.3f}, \"count\": {}}}",
+                              group.pName, info.pName, timer.nTicks * to_ms, timer.nCount);
+    }
+    return fmt::format("{{\n{}\n  }}", result);
+}
+#else
+static void ResetProfileTotals() {}
+
+static std::string GetProfileTotals() {
+    return "{}";
+}
+#endif
+
+/**
+ * Runs the loaded application for the given number of emulated frames as fast as possible and
+ * prints the measured throughput and the per-subsystem profile totals as JSON to stdout.
+ */
+static void RunBenchmark(Core::System& system, u32 num_frames) {
+    const RendererBase& renderer = system.Renderer();
+
+    ResetProfileTotals();
+    system.GetAndResetPerfStats();
+
+    const int start_frame = renderer.GetCurrentFrame();
+    const auto start_emulated_us = system.CoreTiming().GetGlobalTimeUs();
+    const auto start_wall = std::chrono::steady_clock::now();
+
+    while (static_cast<u32>(renderer.GetCurrentFrame() - start_frame) < num_frames) {
+        if (system.RunLoop() == Core::System::ResultStatus::ShutdownRequested) {
+            LOG_WARNING(Frontend, "Application requested shutdown during the benchmark");
+            break;
+        }
+    }
+
+    const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - start_wall;
+    const std::chrono::duration<double> emulated_time =
+        system.CoreTiming().GetGlobalTimeUs() - start_emulated_us;
+    const u32 frames = static_cast<u32>(renderer.GetCurrentFrame() - start_frame);
+    const auto perf_results = system.GetAndResetPerfStats();
+
+    std::cout << fmt::format("{{\n"
+                             "  \"frames\": {},\n"
+                             "  \"wall_time_s\": {:.6f},\n"
+                             "  \"emulated_time_s\": {:.6f},\n"
+                             "  \"fps\": {:.3f},\n"
+                             "  \"game_fps\": {:.3f},\n"
+                             "  \"emulation_speed\": {:.4f},\n"
+                             "  \"idle_ratio\": {:.4f},\n"
+                             "  \"profile\": {}\n"
+                             "}}",
+                             frames, wall_time.count(), emulated_time.count(),
+                             frames / wall_time.count(), perf_results.game_fps,
+                             emulated_time.count() / wall_time.count(), perf_results.idle_ratio,
+                             GetProfileTotals())
+              << std::endl;
+}
+
 static void InitializeLogging() {
     Log::Filter log_filter(Log::Level::Debug);
     log_filter.ParseFilterString(Settings::values.log_filter);
@@ -211,6 +302,8 @@ int main(int argc, char** argv) {
 
     bool use_multiplayer = false;
     bool fullscreen = false;
+    bool headless = false;
+    u32 benchmark_frames = 0;
     std::string nickname{};
     std::string password{};
     std::string address{};
@@ -220,12 +313,13 @@ int main(int argc, char** argv) {
         {"gdbport", required_argument, 0, 'g'},     {"install", required_argument, 0, 'i'},
         {"multiplayer", required_argument, 0, 'm'}, {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},  {"dump-video", required_argument, 0, 'd'},
+        {"headless", no_argument, 0, 'n'},          {"benchmark", required_argument, 0, 'b'},
         {"fullscreen", no_argument, 0, 'f'},        {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},           {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:d:nb:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -291,6 +385,20 @@ int main(int argc, char** argv) {
             case 'd':
                 dump_video = optarg;
                 break;
+            case 'n':
+                headless = true;
+                break;
+            case 'b':
+                errno = 0;
+                benchmark_frames = strtoul(optarg, &endarg, 0);
+                headless = true;
+                if (endarg == optarg || benchmark_frames == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--benchmark");
+                    exit(1);
+                }
+                break;
             case 'f':
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -339,6 +447,14 @@ int main(int argc, char** argv) {
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    if (headless) {
+        Settings::values.use_null_renderer = true;
+        Settings::values.use_hw_renderer = false;
+        Settings::values.sink_id = "null";
+    }
+    if (benchmark_frames != 0) {
+        Settings::values.use_frame_limit = false;
+    }
     Settings::Apply();
 
     // Register frontend applets
@@ -347,11 +463,19 @@ int main(int argc, char** argv) {
     // Register generic image interface
     Core::System::GetInstance().RegisterImageInterface(std::make_shared<LodePNGImageInterface>());
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>(fullscreen)};
-    Frontend::ScopeAcquireContext scope(*emu_window);
+    std::unique_ptr<EmuWindow_Headless> headless_window;
+    std::unique_ptr<EmuWindow_SDL2> sdl_window;
+    if (headless) {
+        headless_window = std::make_unique<EmuWindow_Headless>();
+    } else {
+        sdl_window = std::make_unique<EmuWindow_SDL2>(fullscreen);
+    }
+    Frontend::EmuWindow& emu_window = headless ? static_cast<Frontend::EmuWindow&>(*headless_window)
+                                               : static_cast<Frontend::EmuWindow&>(*sdl_window);
+    Frontend::ScopeAcquireContext scope(emu_window);
     Core::System& system{Core::System::GetInstance()};
 
-    const Core::System::ResultStatus load_result{system.Load(*emu_window, filepath)};
+    const Core::System::ResultStatus load_result{system.Load(emu_window, filepath)};
 
     switch (load_result) {
     case Core::System::ResultStatus::ErrorGetLoader:
@@ -382,7 +506,8 @@ int main(int argc, char** argv) {
         break; // Expected case
     }
 
-    system.TelemetrySession().AddField(Telemetry::FieldType::App, "Frontend", "SDL");
+    system.TelemetrySession().AddField(Telemetry::FieldType::App, "Frontend",
+                                       headless ? "Headless" : "SDL");
 
     if (use_multiplayer) {
         if (auto member = Network::GetRoomMember().lock()) {
@@ -412,7 +537,10 @@ int main(int argc, char** argv) {
         system.VideoDumper().StartDumping(dump_video, layout);
     }
 
-    std::thread render_thread([&emu_window] { emu_window->Present(); });
+    std::thread render_thread;
+    if (sdl_window) {
+        render_thread = std::thread([&sdl_window] { sdl_window->Present(); });
+    }
 
     std::atomic_bool stop_run;
     Core::System::GetInstance().Renderer().Rasterizer()->LoadDiskResources(
@@ -421,10 +549,17 @@ int main(int argc, char** argv) {
                       total);
         });
 
-    while (emu_window->IsOpen()) {
-        system.RunLoop();
+    if (benchmark_frames != 0) {
+        RunBenchmark(system, benchmark_frames);
+    } else if (headless) {
+        while (system.RunLoop() != Core::System::ResultStatus::ShutdownRequested) {
+        }
+    } else {
+        while (sdl_window->IsOpen()) {
+            system.RunLoop();
+        }
+        render_thread.join();
     }
-    render_thread.join();
 
     Core::Movie::GetInstance().Shutdown();
     if (system.VideoDumper().IsDumping()) {
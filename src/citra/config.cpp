@@ -106,6 +106,12 @@ void Config::ReadValues() {
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
     Settings::values.cpu_clock_percentage =
         sdl2_config->GetInteger("Core", "cpu_clock_percentage", 100);
+    Settings::values.use_fastmem = sdl2_config->GetBoolean("Core", "use_fastmem", false);
+    Settings::values.use_multi_core = sdl2_config->GetBoolean("Core", "use_multi_core", false);
+    Settings::values.enable_rewind = sdl2_config->GetBoolean("Core", "enable_rewind", false);
+    Settings::values.rewind_interval = sdl2_config->GetInteger("Core", "rewind_interval", 60);
+    Settings::values.rewind_buffer_size =
+        sdl2_config->GetInteger("Core", "rewind_buffer_size", 768);
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
@@ -121,6 +127,14 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", false);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.use_asynchronous_gpu_emulation =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_gpu_emulation", false);
+    Settings::values.use_multithreaded_sw_rasterizer =
+        sdl2_config->GetBoolean("Renderer", "use_multithreaded_sw_rasterizer", false);
+    Settings::values.use_multithreaded_vertex_shading =
+        sdl2_config->GetBoolean("Renderer", "use_multithreaded_vertex_shading", false);
+    Settings::values.vertex_cache_size =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "vertex_cache_size", 512));
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
     Settings::values.use_frame_limit = sdl2_config->GetBoolean("Renderer", "use_frame_limit", true);
@@ -197,6 +211,12 @@ void Config::ReadValues() {
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.romfs_cache_size =
+        sdl2_config->GetInteger("Data Storage", "romfs_cache_size", 16);
+    Settings::values.use_async_file_io =
+        sdl2_config->GetBoolean("Data Storage", "use_async_file_io", true);
+    Settings::values.incremental_savestates =
+        sdl2_config->GetBoolean("Data Storage", "incremental_savestates", false);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", true);
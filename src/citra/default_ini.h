@@ -97,6 +97,29 @@ use_cpu_jit =
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Whether to mirror each emulated address space in a reserved 4 GiB range of host memory, which
+# guest memory can be accessed through directly. Only supported on Linux hosts.
+# 0 (default): Off, 1: On
+use_fastmem =
+
+# Whether to run each emulated CPU core on its own host thread. Requires the JIT, and is ignored
+# while the GDB stub is enabled. Experimental, games relying on exclusive accesses between cores
+# may be unstable.
+# 0 (default): Off, 1: On
+use_multi_core =
+
+# Whether to keep recent savestates in memory, so emulation can be rewound with a hotkey
+# 0 (default): Off, 1: On
+enable_rewind =
+
+# Number of frames between rewind snapshots. Default is 60
+rewind_interval =
+
+# Memory the rewind snapshots may use, in MiB. This includes the uncompressed snapshot kept for
+# taking the next one, which is about the size of the emulated memory. The oldest ones are dropped
+# first. Default is 768
+rewind_buffer_size =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -122,6 +145,24 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to process GPU command lists, display transfers and memory fills on a separate thread.
+# Only used with the software renderer.
+# 0 (default): Off, 1: On
+use_asynchronous_gpu_emulation =
+
+# Whether the software renderer splits the screen into tiles and rasterizes them on all CPU cores.
+# 0 (default): Off, 1: On
+use_multithreaded_sw_rasterizer =
+
+# Whether vertices of large draws are shaded on all CPU cores when shaders run on the CPU.
+# 0 (default): Off, 1: On
+use_multithreaded_vertex_shading =
+
+# Number of shaded vertices kept for reuse by indexed draws when shaders run on the CPU. Larger
+# caches shade fewer vertices again but use more memory. Takes effect after a restart.
+# Must be a power of two from 4 to 32768, default: 512
+vertex_cache_size =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
@@ -245,6 +286,18 @@ volume =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Size of the cache of decrypted RomFS data for encrypted games, in MiB.
+# 0: Disabled, 16 (default)
+romfs_cache_size =
+
+# Whether to read game files on a separate thread while the game waits for the data.
+# 0: No, 1 (default): Yes
+use_async_file_io =
+
+# Whether save states only store the memory that changed since a base state kept next to them.
+# 0 (default): No, 1: Yes
+incremental_savestates =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS, 1: New 3DS (default)
@@ -0,0 +1,42 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "citra/emu_window/emu_window_headless.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "core/3ds.h"
+#include "core/settings.h"
+#include "input_common/main.h"
+#include "network/network.h"
+
+namespace {
+
+class DummyContext : public Frontend::GraphicsContext {
+public:
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+} // namespace
+
+EmuWindow_Headless::EmuWindow_Headless() {
+    InputCommon::Init();
+    Network::Init();
+
+    UpdateCurrentFramebufferLayout(Core::kScreenTopWidth,
+                                   Core::kScreenTopHeight + Core::kScreenBottomHeight);
+
+    LOG_INFO(Frontend, "Citra Version: {} | {}-{} (headless)", Common::g_build_fullname,
+             Common::g_scm_branch, Common::g_scm_desc);
+    Settings::LogSettings();
+}
+
+EmuWindow_Headless::~EmuWindow_Headless() {
+    Network::Shutdown();
+    InputCommon::Shutdown();
+}
+
+std::unique_ptr<Frontend::GraphicsContext> EmuWindow_Headless::CreateSharedContext() const {
+    return std::make_unique<DummyContext>();
+}
@@ -0,0 +1,30 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include "core/frontend/emu_window.h"
+
+/**
+ * Window without any on-screen representation or graphics context. Used together with the null
+ * renderer to run emulation on hosts without a display or GPU.
+ */
+class EmuWindow_Headless : public Frontend::EmuWindow {
+public:
+    EmuWindow_Headless();
+    ~EmuWindow_Headless();
+
+    /// There are no window events to poll
+    void PollEvents() override {}
+
+    /// There is no graphics context to make current
+    void MakeCurrent() override {}
+
+    /// There is no graphics context to release
+    void DoneCurrent() override {}
+
+    /// Creates a stub context, as there is nothing to share
+    std::unique_ptr<GraphicsContext> CreateSharedContext() const override;
+};
@@ -57,7 +57,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
 // clang-format off
-const std::array<UISettings::Shortcut, 23> default_hotkeys{
+const std::array<UISettings::Shortcut, 24> default_hotkeys{
     {{QStringLiteral("Advance Frame"),            QStringLiteral("Main Window"), {QStringLiteral("\\"), Qt::ApplicationShortcut}},
      {QStringLiteral("Capture Screenshot"),       QStringLiteral("Main Window"), {QStringLiteral("Ctrl+P"), Qt::ApplicationShortcut}},
      {QStringLiteral("Continue/Pause Emulation"), QStringLiteral("Main Window"), {QStringLiteral("F4"), Qt::WindowShortcut}},
@@ -70,6 +70,7 @@ const std::array<UISettings::Shortcut, 23> default_hotkeys{
      {QStringLiteral("Load File"),                QStringLiteral("Main Window"), {QStringLiteral("Ctrl+O"), Qt::WindowShortcut}},
      {QStringLiteral("Remove Amiibo"),            QStringLiteral("Main Window"), {QStringLiteral("F3"), Qt::ApplicationShortcut}},
      {QStringLiteral("Restart Emulation"),        QStringLiteral("Main Window"), {QStringLiteral("F6"), Qt::WindowShortcut}},
+     {QStringLiteral("Rewind"),                   QStringLiteral("Main Window"), {QStringLiteral("Backspace"), Qt::ApplicationShortcut}},
      {QStringLiteral("Rotate Screens Upright"),   QStringLiteral("Main Window"), {QStringLiteral("F8"), Qt::WindowShortcut}},
      {QStringLiteral("Stop Emulation"),           QStringLiteral("Main Window"), {QStringLiteral("F5"), Qt::WindowShortcut}},
      {QStringLiteral("Swap Screens"),             QStringLiteral("Main Window"), {QStringLiteral("F9"), Qt::WindowShortcut}},
@@ -258,6 +259,13 @@ void Config::ReadCoreValues() {
     Settings::values.use_cpu_jit = ReadSetting(QStringLiteral("use_cpu_jit"), true).toBool();
     Settings::values.cpu_clock_percentage =
         ReadSetting(QStringLiteral("cpu_clock_percentage"), 100).toInt();
+    Settings::values.use_fastmem = ReadSetting(QStringLiteral("use_fastmem"), false).toBool();
+    Settings::values.use_multi_core =
+        ReadSetting(QStringLiteral("use_multi_core"), false).toBool();
+    Settings::values.enable_rewind = ReadSetting(QStringLiteral("enable_rewind"), false).toBool();
+    Settings::values.rewind_interval = ReadSetting(QStringLiteral("rewind_interval"), 60).toInt();
+    Settings::values.rewind_buffer_size =
+        ReadSetting(QStringLiteral("rewind_buffer_size"), 768).toInt();
 
     qt_config->endGroup();
 }
@@ -266,6 +274,12 @@ void Config::ReadDataStorageValues() {
     qt_config->beginGroup(QStringLiteral("Data Storage"));
 
     Settings::values.use_virtual_sd = ReadSetting(QStringLiteral("use_virtual_sd"), true).toBool();
+    Settings::values.romfs_cache_size =
+        ReadSetting(QStringLiteral("romfs_cache_size"), 16).toInt();
+    Settings::values.use_async_file_io =
+        ReadSetting(QStringLiteral("use_async_file_io"), true).toBool();
+    Settings::values.incremental_savestates =
+        ReadSetting(QStringLiteral("incremental_savestates"), false).toBool();
 
     qt_config->endGroup();
 }
@@ -442,6 +456,14 @@ void Config::ReadRendererValues() {
     Settings::values.shaders_accurate_mul =
         ReadSetting(QStringLiteral("shaders_accurate_mul"), false).toBool();
     Settings::values.use_shader_jit = ReadSetting(QStringLiteral("use_shader_jit"), true).toBool();
+    Settings::values.use_asynchronous_gpu_emulation =
+        ReadSetting(QStringLiteral("use_asynchronous_gpu_emulation"), false).toBool();
+    Settings::values.use_multithreaded_sw_rasterizer =
+        ReadSetting(QStringLiteral("use_multithreaded_sw_rasterizer"), false).toBool();
+    Settings::values.use_multithreaded_vertex_shading =
+        ReadSetting(QStringLiteral("use_multithreaded_vertex_shading"), false).toBool();
+    Settings::values.vertex_cache_size =
+        static_cast<u16>(ReadSetting(QStringLiteral("vertex_cache_size"), 512).toUInt());
     Settings::values.use_vsync_new = ReadSetting(QStringLiteral("use_vsync_new"), true).toBool();
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting(QStringLiteral("resolution_factor"), 1).toInt());
@@ -788,6 +810,11 @@ void Config::SaveCoreValues() {
     WriteSetting(QStringLiteral("use_cpu_jit"), Settings::values.use_cpu_jit, true);
     WriteSetting(QStringLiteral("cpu_clock_percentage"), Settings::values.cpu_clock_percentage,
                  100);
+    WriteSetting(QStringLiteral("use_fastmem"), Settings::values.use_fastmem, false);
+    WriteSetting(QStringLiteral("use_multi_core"), Settings::values.use_multi_core, false);
+    WriteSetting(QStringLiteral("enable_rewind"), Settings::values.enable_rewind, false);
+    WriteSetting(QStringLiteral("rewind_interval"), Settings::values.rewind_interval, 60);
+    WriteSetting(QStringLiteral("rewind_buffer_size"), Settings::values.rewind_buffer_size, 768);
 
     qt_config->endGroup();
 }
@@ -796,6 +823,10 @@ void Config::SaveDataStorageValues() {
     qt_config->beginGroup(QStringLiteral("Data Storage"));
 
     WriteSetting(QStringLiteral("use_virtual_sd"), Settings::values.use_virtual_sd, true);
+    WriteSetting(QStringLiteral("romfs_cache_size"), Settings::values.romfs_cache_size, 16);
+    WriteSetting(QStringLiteral("use_async_file_io"), Settings::values.use_async_file_io, true);
+    WriteSetting(QStringLiteral("incremental_savestates"), Settings::values.incremental_savestates,
+                 false);
 
     qt_config->endGroup();
 }
@@ -925,6 +956,13 @@ void Config::SaveRendererValues() {
     WriteSetting(QStringLiteral("shaders_accurate_mul"), Settings::values.shaders_accurate_mul,
                  false);
     WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit, true);
+    WriteSetting(QStringLiteral("use_asynchronous_gpu_emulation"),
+                 Settings::values.use_asynchronous_gpu_emulation, false);
+    WriteSetting(QStringLiteral("use_multithreaded_sw_rasterizer"),
+                 Settings::values.use_multithreaded_sw_rasterizer, false);
+    WriteSetting(QStringLiteral("use_multithreaded_vertex_shading"),
+                 Settings::values.use_multithreaded_vertex_shading, false);
+    WriteSetting(QStringLiteral("vertex_cache_size"), Settings::values.vertex_cache_size, 512);
     WriteSetting(QStringLiteral("use_vsync_new"), Settings::values.use_vsync_new, true);
     WriteSetting(QStringLiteral("resolution_factor"), Settings::values.resolution_factor, 1);
     WriteSetting(QStringLiteral("use_frame_limit"), Settings::values.use_frame_limit, true);
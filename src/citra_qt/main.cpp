@@ -472,6 +472,12 @@ void GMainWindow::InitializeHotkeys() {
                     return;
                 BootGame(QString(game_path));
             });
+    connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Rewind"), this),
+            &QShortcut::activated, this, [&] {
+                if (emulation_running && emu_thread->IsRunning()) {
+                    Core::System::GetInstance().SendSignal(Core::System::Signal::Rewind);
+                }
+            });
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Swap Screens"), render_window),
             &QShortcut::activated, ui.action_Screen_Layout_Swap_Screens, &QAction::trigger);
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Rotate Screens Upright"),
@@ -43,7 +43,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -344,6 +346,33 @@ u64 GetSize(const std::string& filename) {
     return 0;
 }
 
+bool GetStatus(const std::string& filename, FileStatus& status) {
+    struct stat buf;
+
+    std::string copy(filename);
+    StripTailDirSlashes(copy);
+
+#ifdef _WIN32
+    // Windows needs a slash to identify a driver root
+    if (copy.size() != 0 && copy.back() == ':')
+        copy += DIR_SEP_CHR;
+
+    int result = _wstat64(Common::UTF8ToUTF16W(copy).c_str(), &buf);
+#else
+    int result = stat(copy.c_str(), &buf);
+#endif
+
+    if (result < 0) {
+        LOG_DEBUG(Common_Filesystem, "stat failed on {}: {}", filename, GetLastErrorMsg());
+        return false;
+    }
+
+    status.is_directory = S_ISDIR(buf.st_mode);
+    status.size = status.is_directory ? 0 : static_cast<u64>(buf.st_size);
+    status.modification_time = static_cast<s64>(buf.st_mtime);
+    return true;
+}
+
 u64 GetSize(const int fd) {
     struct stat buf;
     if (fstat(fd, &buf) != 0) {
@@ -1038,4 +1067,70 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Common::UTF8ToUTF16W(path).c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR(Common_Filesystem, "Failed to open {}: {}", path, GetLastErrorMsg());
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 &&
+        static_cast<u64>(file_size.QuadPart) <= std::numeric_limits<std::size_t>::max()) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        LOG_ERROR(Common_Filesystem, "Failed to map {}: {}", path, GetLastErrorMsg());
+        return;
+    }
+
+    // The view keeps the mapping alive
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        LOG_ERROR(Common_Filesystem, "Failed to map {}: {}", path, GetLastErrorMsg());
+        return;
+    }
+    data = static_cast<const u8*>(view);
+    size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        LOG_ERROR(Common_Filesystem, "Failed to open {}: {}", path, GetLastErrorMsg());
+        return;
+    }
+
+    struct stat file_info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &file_info) == 0 && file_info.st_size > 0 &&
+        static_cast<u64>(file_info.st_size) <= std::numeric_limits<std::size_t>::max()) {
+        view = mmap(nullptr, static_cast<std::size_t>(file_info.st_size), PROT_READ, MAP_SHARED,
+                    fd, 0);
+    }
+    // The mapping keeps the file alive
+    close(fd);
+    if (view == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "Failed to map {}: {}", path, GetLastErrorMsg());
+        return;
+    }
+    data = static_cast<const u8*>(view);
+    size = static_cast<std::size_t>(file_info.st_size);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    if (data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<u8*>(data), size);
+#endif
+}
+
 } // namespace FileUtil
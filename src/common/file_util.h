@@ -99,6 +99,16 @@ bool IsDirectory(const std::string& filename);
 // Returns the size of filename (64bit)
 u64 GetSize(const std::string& filename);
 
+// Type, size and modification time of a file or directory
+struct FileStatus {
+    bool is_directory{};
+    u64 size{};              // 0 for directories
+    s64 modification_time{}; // seconds since the epoch
+};
+
+// Fills status from a single stat of filename. Returns false if filename does not exist
+bool GetStatus(const std::string& filename, FileStatus& status);
+
 // Overloaded GetSize, accepts file descriptor
 u64 GetSize(const int fd);
 
@@ -318,6 +328,10 @@ public:
         return nullptr != m_file;
     }
 
+    const std::string& GetFilename() const {
+        return filename;
+    }
+
     // m_good is set to false when a read, write or other function fails
     bool IsGood() const {
         return m_good;
@@ -369,6 +383,42 @@ private:
     friend class boost::serialization::access;
 };
 
+/**
+ * A read-only memory mapping of a whole file. Reading through it is served straight from the
+ * page cache, without copies or seeks, and the pages can be shared with other processes mapping
+ * the same file. The file must not be truncated while it is mapped.
+ */
+class MappedFile : public NonCopyable {
+public:
+    /// Maps the file at path. Check IsOpen to find out whether it succeeded.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    bool IsOpen() const {
+        return data != nullptr;
+    }
+
+    const u8* GetData() const {
+        return data;
+    }
+
+    std::size_t GetSize() const {
+        return size;
+    }
+
+    /// Returns a pointer to length bytes of the file at offset, or nullptr if they're outside it.
+    const u8* GetSpan(u64 offset, std::size_t length) const {
+        if (offset > size || length > size - offset) {
+            return nullptr;
+        }
+        return data + offset;
+    }
+
+private:
+    const u8* data = nullptr;
+    std::size_t size = 0;
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
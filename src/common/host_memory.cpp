@@ -0,0 +1,122 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include "common/assert.h"
+#include "common/host_memory.h"
+#include "common/logging/log.h"
+
+namespace Common {
+
+#ifdef __linux__
+
+HostMemory::HostMemory(std::size_t backing_size_) : backing_size(backing_size_) {
+    fd = memfd_create("HostMemory", MFD_CLOEXEC);
+    if (fd == -1) {
+        LOG_ERROR(Common_Memory, "memfd_create failed: {}", GetLastErrorMsg());
+    } else if (ftruncate(fd, static_cast<off_t>(backing_size)) != 0) {
+        LOG_ERROR(Common_Memory, "ftruncate failed: {}", GetLastErrorMsg());
+        close(fd);
+        fd = -1;
+    } else {
+        void* base = mmap(nullptr, backing_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            LOG_ERROR(Common_Memory, "mmap of backing memory failed: {}", GetLastErrorMsg());
+            close(fd);
+            fd = -1;
+        } else {
+            backing_base = static_cast<u8*>(base);
+            return;
+        }
+    }
+
+    fallback = std::make_unique<u8[]>(backing_size);
+    backing_base = fallback.get();
+}
+
+HostMemory::~HostMemory() {
+    if (fd != -1) {
+        munmap(backing_base, backing_size);
+        close(fd);
+    }
+}
+
+std::size_t HostMemory::GetPageSize() {
+    return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+std::unique_ptr<HostMemory::View> HostMemory::CreateView(std::size_t virtual_size) {
+    if (fd == -1) {
+        return nullptr;
+    }
+
+    void* base =
+        mmap(nullptr, virtual_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERROR(Common_Memory, "Failed to reserve 0x{:X} bytes for a view: {}", virtual_size,
+                  GetLastErrorMsg());
+        return nullptr;
+    }
+    return std::unique_ptr<View>(new View(fd, static_cast<u8*>(base), virtual_size));
+}
+
+HostMemory::View::View(int fd_, u8* base_, std::size_t size_) : fd(fd_), base(base_), size(size_) {}
+
+HostMemory::View::~View() {
+    munmap(base, size);
+}
+
+void HostMemory::View::Map(std::size_t virtual_offset, std::size_t backing_offset,
+                           std::size_t length) {
+    ASSERT(virtual_offset + length <= size);
+    void* result = mmap(base + virtual_offset, length, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_FIXED, fd, static_cast<off_t>(backing_offset));
+    ASSERT_MSG(result != MAP_FAILED, "View mapping failed: {}", GetLastErrorMsg());
+}
+
+void HostMemory::View::Unmap(std::size_t virtual_offset, std::size_t length) {
+    ASSERT(virtual_offset + length <= size);
+    // Replacing the range keeps it reserved, so nothing else can be mapped there
+    void* result = mmap(base + virtual_offset, length, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    ASSERT_MSG(result != MAP_FAILED, "View unmapping failed: {}", GetLastErrorMsg());
+}
+
+#else
+
+HostMemory::HostMemory(std::size_t backing_size_)
+    : backing_size(backing_size_), fallback(std::make_unique<u8[]>(backing_size_)) {
+    backing_base = fallback.get();
+}
+
+HostMemory::~HostMemory() = default;
+
+std::size_t HostMemory::GetPageSize() {
+    return 0x1000;
+}
+
+std::unique_ptr<HostMemory::View> HostMemory::CreateView(std::size_t virtual_size) {
+    return nullptr;
+}
+
+HostMemory::View::View(int fd_, u8* base_, std::size_t size_) : fd(fd_), base(base_), size(size_) {}
+
+HostMemory::View::~View() = default;
+
+void HostMemory::View::Map(std::size_t virtual_offset, std::size_t backing_offset,
+                           std::size_t length) {
+    UNREACHABLE();
+}
+
+void HostMemory::View::Unmap(std::size_t virtual_offset, std::size_t length) {
+    UNREACHABLE();
+}
+
+#endif
+
+} // namespace Common
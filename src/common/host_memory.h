@@ -0,0 +1,89 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A block of host memory which, where the host supports it, is backed by a shared memory object.
+ * Parts of the block can then be mapped again at arbitrary places of a View, so that a view can
+ * mirror a guest address space and guest memory can be accessed at view base + guest address.
+ *
+ * When aliasing is not supported, the memory is an ordinary allocation and no views can be made.
+ */
+class HostMemory : NonCopyable {
+public:
+    /// A reserved range of the host address space, which parts of the backing memory are mapped in.
+    class View : NonCopyable {
+    public:
+        ~View();
+
+        /// Returns the host address corresponding to offset 0 of the view.
+        u8* BasePointer() const {
+            return base;
+        }
+
+        std::size_t Size() const {
+            return size;
+        }
+
+        /// Makes length bytes at virtual_offset alias the backing memory at backing_offset.
+        void Map(std::size_t virtual_offset, std::size_t backing_offset, std::size_t length);
+
+        /// Makes length bytes at virtual_offset inaccessible again.
+        void Unmap(std::size_t virtual_offset, std::size_t length);
+
+    private:
+        friend class HostMemory;
+        View(int fd, u8* base, std::size_t size);
+
+        int fd;
+        u8* base;
+        std::size_t size;
+    };
+
+    explicit HostMemory(std::size_t backing_size);
+    ~HostMemory();
+
+    /// Returns the granularity in which memory can be mapped into a view.
+    static std::size_t GetPageSize();
+
+    u8* BackingBasePointer() {
+        return backing_base;
+    }
+
+    const u8* BackingBasePointer() const {
+        return backing_base;
+    }
+
+    std::size_t BackingSize() const {
+        return backing_size;
+    }
+
+    /// Returns whether the backing memory can be mapped into views.
+    bool SupportsViews() const {
+        return fd != -1;
+    }
+
+    /**
+     * Reserves virtual_size bytes of host address space, initially with nothing mapped.
+     * @returns The view, or nullptr if views are unsupported or the space could not be reserved
+     */
+    std::unique_ptr<View> CreateView(std::size_t virtual_size);
+
+private:
+    int fd = -1;
+    u8* backing_base = nullptr;
+    std::size_t backing_size;
+    /// Used instead of a shared memory object when aliasing is not supported
+    std::unique_ptr<u8[]> fallback;
+};
+
+} // namespace Common
@@ -0,0 +1,49 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <streambuf>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Stream buffer that appends everything written to it to a vector. Unlike std::ostringstream, the
+ * data can be used in place afterwards, and the capacity of the vector is reused when it is
+ * cleared and written to again.
+ */
+class VectorOutputStreamBuf : public std::streambuf {
+public:
+    explicit VectorOutputStreamBuf(std::vector<u8>& buffer) : buffer(buffer) {}
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            buffer.push_back(static_cast<u8>(traits_type::to_char_type(ch)));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        buffer.insert(buffer.end(), reinterpret_cast<const u8*>(data),
+                      reinterpret_cast<const u8*>(data) + count);
+        return count;
+    }
+
+private:
+    std::vector<u8>& buffer;
+};
+
+/// Stream buffer that reads from a block of memory, without copying it like std::istringstream.
+class MemoryInputStreamBuf : public std::streambuf {
+public:
+    MemoryInputStreamBuf(const u8* data, std::size_t size) {
+        char* begin = reinterpret_cast<char*>(const_cast<u8*>(data));
+        setg(begin, begin, begin + size);
+    }
+};
+
+} // namespace Common
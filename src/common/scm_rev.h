@@ -14,5 +14,6 @@ extern const char g_build_date[];
 extern const char g_build_fullname[];
 extern const char g_build_version[];
 extern const char g_shader_cache_version[];
+extern const char g_shader_jit_cache_version[];
 
 } // namespace Common
@@ -0,0 +1,92 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(std::size_t num_threads) {
+    const std::size_t num_workers = num_threads > 1 ? num_threads - 1 : 0;
+    workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back([this, i] {
+            Common::SetCurrentThreadName(("ThreadPool" + std::to_string(i)).c_str());
+            MicroProfileOnThreadCreate("ThreadPool");
+            WorkerLoop();
+            MicroProfileOnThreadExit();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func) {
+    if (count == 0) {
+        return;
+    }
+    if (workers.empty() || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        job = &func;
+        job_count = count;
+        next_index = 0;
+        busy_workers = workers.size();
+        ++generation;
+    }
+    work_cv.notify_all();
+
+    RunJob(func, count);
+
+    std::unique_lock lock{mutex};
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+    u64 last_generation = 0;
+    std::unique_lock lock{mutex};
+    while (true) {
+        work_cv.wait(lock, [&] { return stop || generation != last_generation; });
+        if (stop) {
+            return;
+        }
+        last_generation = generation;
+
+        const auto& func = *job;
+        const std::size_t count = job_count;
+        lock.unlock();
+        RunJob(func, count);
+        lock.lock();
+
+        if (--busy_workers == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunJob(const std::function<void(std::size_t)>& func, std::size_t count) {
+    for (std::size_t i = next_index++; i < count; i = next_index++) {
+        func(i);
+    }
+}
+
+} // namespace Common
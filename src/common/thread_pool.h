@@ -0,0 +1,58 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A fixed set of worker threads used to split data-parallel work. The thread that submits the
+ * work takes part in it too, so a pool created with N threads only spawns N - 1 workers.
+ * Work must only be submitted from one thread at a time.
+ */
+class ThreadPool : NonCopyable {
+public:
+    explicit ThreadPool(std::size_t num_threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    /// Returns the number of threads taking part in the work, including the calling thread.
+    std::size_t GetThreadCount() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Calls func(i) for every i in [0, count), spreading the calls over the pool. Returns once
+     * all calls have completed. There is no guarantee about which thread makes which call, or
+     * in which order the calls are made.
+     */
+    void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func);
+
+private:
+    void WorkerLoop();
+    void RunJob(const std::function<void(std::size_t)>& func, std::size_t count);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+
+    const std::function<void(std::size_t)>* job = nullptr;
+    std::size_t job_count = 0;
+    std::atomic<std::size_t> next_index{0};
+    std::size_t busy_workers = 0;
+    u64 generation = 0;
+    bool stop = false;
+};
+
+} // namespace Common
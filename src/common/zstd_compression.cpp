@@ -6,6 +6,7 @@
 #include <zstd.h>
 
 #include "common/assert.h"
+#include "common/file_util.h"
 #include "common/zstd_compression.h"
 
 namespace Common::Compression {
@@ -48,4 +49,158 @@ std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed) {
     return decompressed;
 }
 
+struct ZSTDOutputStreamBuf::Impl {
+    explicit Impl(FileUtil::IOFile& file) : file(file) {}
+
+    ~Impl() {
+        ZSTD_freeCCtx(context);
+    }
+
+    /// Feeds data to the compressor and writes out what it produces. With ZSTD_e_end, this also
+    /// waits for the background workers and ends the frame.
+    bool Compress(const char* data, std::size_t size, ZSTD_EndDirective mode) {
+        if (failed) {
+            return false;
+        }
+        ZSTD_inBuffer input{data, size, 0};
+        std::size_t remaining;
+        do {
+            ZSTD_outBuffer output{out_buffer.data(), out_buffer.size(), 0};
+            remaining = ZSTD_compressStream2(context, &output, &input, mode);
+            if (ZSTD_isError(remaining) ||
+                file.WriteBytes(out_buffer.data(), output.pos) != output.pos) {
+                failed = true;
+                return false;
+            }
+        } while (mode == ZSTD_e_end ? remaining != 0 : input.pos != input.size);
+        return true;
+    }
+
+    FileUtil::IOFile& file;
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    std::vector<char> in_buffer = std::vector<char>(ZSTD_CStreamInSize());
+    std::vector<u8> out_buffer = std::vector<u8>(ZSTD_CStreamOutSize());
+    bool failed = false;
+};
+
+ZSTDOutputStreamBuf::ZSTDOutputStreamBuf(FileUtil::IOFile& file, u32 worker_count,
+                                         s32 compression_level)
+    : impl(std::make_unique<Impl>(file)) {
+    if (compression_level != 0) {
+        compression_level = std::clamp(compression_level, ZSTD_minCLevel(), ZSTD_maxCLevel());
+    }
+    ZSTD_CCtx_setParameter(impl->context, ZSTD_c_compressionLevel, compression_level);
+    ZSTD_CCtx_setParameter(impl->context, ZSTD_c_checksumFlag, 1);
+    // Fails without effect if zstd is built without multithreading support, which just means the
+    // data is compressed on the writing thread
+    ZSTD_CCtx_setParameter(impl->context, ZSTD_c_nbWorkers, static_cast<int>(worker_count));
+    setp(impl->in_buffer.data(), impl->in_buffer.data() + impl->in_buffer.size());
+}
+
+ZSTDOutputStreamBuf::~ZSTDOutputStreamBuf() = default;
+
+bool ZSTDOutputStreamBuf::Finish() {
+    const bool result = impl->Compress(pbase(), pptr() - pbase(), ZSTD_e_end);
+    setp(nullptr, nullptr);
+    return result;
+}
+
+ZSTDOutputStreamBuf::int_type ZSTDOutputStreamBuf::overflow(int_type ch) {
+    if (sync() != 0) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize ZSTDOutputStreamBuf::xsputn(const char* data, std::streamsize count) {
+    if (count <= epptr() - pptr()) {
+        std::copy_n(data, count, pptr());
+        pbump(static_cast<int>(count));
+        return count;
+    }
+    if (sync() != 0 || !impl->Compress(data, count, ZSTD_e_continue)) {
+        return 0;
+    }
+    return count;
+}
+
+int ZSTDOutputStreamBuf::sync() {
+    if (!pbase()) {
+        return -1;
+    }
+    const bool result = impl->Compress(pbase(), pptr() - pbase(), ZSTD_e_continue);
+    setp(pbase(), epptr());
+    return result ? 0 : -1;
+}
+
+struct ZSTDInputStreamBuf::Impl {
+    explicit Impl(FileUtil::IOFile& file) : file(file) {}
+
+    ~Impl() {
+        ZSTD_freeDCtx(context);
+    }
+
+    /// Decompresses up to size bytes to data, reading more of the file as needed. Returns the
+    /// number of bytes decompressed, which is only 0 at the end of the file or on errors.
+    std::size_t Decompress(char* data, std::size_t size) {
+        ZSTD_outBuffer output{data, size, 0};
+        while (output.pos == 0 && !failed) {
+            if (input.pos == input.size) {
+                input.size = file.ReadBytes(in_buffer.data(), in_buffer.size());
+                input.pos = 0;
+                if (input.size == 0) {
+                    break;
+                }
+            }
+            const std::size_t result = ZSTD_decompressStream(context, &output, &input);
+            failed = ZSTD_isError(result);
+        }
+        return output.pos;
+    }
+
+    FileUtil::IOFile& file;
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    std::vector<u8> in_buffer = std::vector<u8>(ZSTD_DStreamInSize());
+    ZSTD_inBuffer input{in_buffer.data(), 0, 0};
+    std::vector<char> out_buffer = std::vector<char>(ZSTD_DStreamOutSize());
+    bool failed = false;
+};
+
+ZSTDInputStreamBuf::ZSTDInputStreamBuf(FileUtil::IOFile& file)
+    : impl(std::make_unique<Impl>(file)) {}
+
+ZSTDInputStreamBuf::~ZSTDInputStreamBuf() = default;
+
+ZSTDInputStreamBuf::int_type ZSTDInputStreamBuf::underflow() {
+    if (gptr() == egptr()) {
+        char* begin = impl->out_buffer.data();
+        setg(begin, begin, begin + impl->Decompress(begin, impl->out_buffer.size()));
+        if (gptr() == egptr()) {
+            return traits_type::eof();
+        }
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize ZSTDInputStreamBuf::xsgetn(char* data, std::streamsize count) {
+    // Hand out what is already decompressed, then decompress the rest in place
+    const auto buffered = std::min<std::streamsize>(count, egptr() - gptr());
+    std::copy_n(gptr(), buffered, data);
+    gbump(static_cast<int>(buffered));
+
+    std::streamsize read = buffered;
+    while (read < count) {
+        const std::size_t result = impl->Decompress(data + read, count - read);
+        if (result == 0) {
+            break;
+        }
+        read += result;
+    }
+    return read;
+}
+
 } // namespace Common::Compression
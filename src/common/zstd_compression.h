@@ -4,10 +4,16 @@
 
 #pragma once
 
+#include <memory>
+#include <streambuf>
 #include <vector>
 
 #include "common/common_types.h"
 
+namespace FileUtil {
+class IOFile;
+}
+
 namespace Common::Compression {
 
 /**
@@ -41,4 +47,57 @@ std::vector<u8> CompressDataZSTDDefault(const u8* source, std::size_t source_siz
  */
 std::vector<u8> DecompressDataZSTD(const std::vector<u8>& compressed);
 
+/**
+ * Stream buffer that compresses everything written to it into a single Zstandard frame, which is
+ * appended to a file as it is produced. Large writes are passed to the compressor without being
+ * copied into the buffer first.
+ */
+class ZSTDOutputStreamBuf : public std::streambuf {
+public:
+    /**
+     * @param file the file the compressed data is written to, at its current position.
+     * @param worker_count the number of threads compressing in the background. With 0, the data
+     * is compressed on the writing thread.
+     * @param compression_level the used compression level, or 0 for the default.
+     */
+    explicit ZSTDOutputStreamBuf(FileUtil::IOFile& file, u32 worker_count = 0,
+                                 s32 compression_level = 0);
+    ~ZSTDOutputStreamBuf() override;
+
+    /**
+     * Compresses the remaining data and ends the frame. Nothing may be written afterwards.
+     *
+     * @return whether all the compressed data could be written to the file.
+     */
+    bool Finish();
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+/**
+ * Stream buffer that decompresses Zstandard frames read from a file on demand. Large reads are
+ * decompressed directly into the destination.
+ */
+class ZSTDInputStreamBuf : public std::streambuf {
+public:
+    /// @param file the file the compressed data is read from, starting at its current position.
+    explicit ZSTDInputStreamBuf(FileUtil::IOFile& file);
+    ~ZSTDInputStreamBuf() override;
+
+protected:
+    int_type underflow() override;
+    std::streamsize xsgetn(char* data, std::streamsize count) override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
 } // namespace Common::Compression
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <dynarmic/A32/a32.h>
 #include <dynarmic/A32/context.h>
@@ -74,30 +75,52 @@ public:
         : parent(parent), svc_context(parent.system), memory(parent.memory) {}
     ~DynarmicUserCallbacks() = default;
 
+    /// Accesses that miss the page table reach I/O or the rasterizer cache, and SVCs reach the
+    /// kernel, which only the emulation thread may enter when the cores run in parallel.
+    template <typename Func>
+    void OnEmuThread(Func&& func) {
+        if (!parent.system.RunsCoresInParallel()) {
+            func();
+            return;
+        }
+        // While this core waits, the emulation thread may invalidate its JIT directly
+        parent.SetWaitingOnEmuThread(true);
+        parent.system.CallOnEmuThread(parent, std::forward<Func>(func));
+        parent.SetWaitingOnEmuThread(false);
+    }
+
     std::uint8_t MemoryRead8(VAddr vaddr) override {
-        return memory.Read8(vaddr);
+        std::uint8_t value;
+        OnEmuThread([&] { value = memory.Read8(vaddr); });
+        return value;
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
-        return memory.Read16(vaddr);
+        std::uint16_t value;
+        OnEmuThread([&] { value = memory.Read16(vaddr); });
+        return value;
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
-        return memory.Read32(vaddr);
+        std::uint32_t value;
+        OnEmuThread([&] { value = memory.Read32(vaddr); });
+        return value;
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
-        return memory.Read64(vaddr);
+        std::uint64_t value;
+        OnEmuThread([&] { value = memory.Read64(vaddr); });
+        return value;
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
-        memory.Write8(vaddr, value);
+        OnEmuThread([&] { memory.Write8(vaddr, value); });
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
-        memory.Write16(vaddr, value);
+        OnEmuThread([&] { memory.Write16(vaddr, value); });
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
-        memory.Write32(vaddr, value);
+        OnEmuThread([&] { memory.Write32(vaddr, value); });
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
-        memory.Write64(vaddr, value);
+        OnEmuThread([&] { memory.Write64(vaddr, value); });
     }
 
     void InterpreterFallback(VAddr pc, std::size_t num_instructions) override {
@@ -107,7 +130,7 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
-        svc_context.CallSVC(swi);
+        OnEmuThread([&] { svc_context.CallSVC(swi); });
     }
 
     void ExceptionRaised(VAddr pc, Dynarmic::A32::Exception exception) override {
@@ -156,15 +179,38 @@ ARM_Dynarmic::ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory, u
     SetPageTable(memory.GetCurrentPageTable());
 }
 
-ARM_Dynarmic::~ARM_Dynarmic() = default;
+ARM_Dynarmic::~ARM_Dynarmic() {
+    LOG_INFO(Core_ARM11, "Core {} JIT cache: {} created, {} reused, {} released, {} evicted",
+             GetID(), jit_cache_stats.created, jit_cache_stats.reused, jit_cache_stats.released,
+             jit_cache_stats.evicted);
+}
 
 MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
 
+// Every JIT reserves its own code cache, so this bounds the host memory used for JIT code. Only a
+// few processes run guest code at a time, the game and an applet or system module.
+constexpr std::size_t MaxJitsPerCore = 4;
+
 void ARM_Dynarmic::Run() {
-    ASSERT(memory.GetCurrentPageTable() == current_page_table);
+    // In parallel, the current page table is the one of the core that last entered the kernel
+    ASSERT(system.RunsCoresInParallel() || memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
+    {
+        std::lock_guard lock{invalidation_mutex};
+        ApplyPendingInvalidations();
+        executing_thread = std::this_thread::get_id();
+    }
+
     jit->Run();
+
+    std::lock_guard lock{invalidation_mutex};
+    executing_thread = {};
+}
+
+void ARM_Dynarmic::SetWaitingOnEmuThread(bool waiting) {
+    std::lock_guard lock{invalidation_mutex};
+    executing_thread = waiting ? std::thread::id{} : std::this_thread::get_id();
 }
 
 void ARM_Dynarmic::Step() {
@@ -277,21 +323,57 @@ void ARM_Dynarmic::PrepareReschedule() {
     }
 }
 
+bool ARM_Dynarmic::RunsOnAnotherThread() const {
+    return executing_thread != std::thread::id{} && executing_thread != std::this_thread::get_id();
+}
+
 void ARM_Dynarmic::ClearInstructionCache() {
+    std::lock_guard lock{invalidation_mutex};
+    if (RunsOnAnotherThread()) {
+        // The JITs are cleared before the next run, as in InvalidateCacheRange
+        pending_clear = true;
+        return;
+    }
     for (const auto& j : jits) {
-        j.second->ClearCache();
+        j.second.jit->ClearCache();
     }
 }
 
 void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    std::lock_guard lock{invalidation_mutex};
+    if (RunsOnAnotherThread()) {
+        // The JIT is running guest code on another host thread, which must not be touched. It is
+        // invalidated before its next run, even if the core has switched to another JIT by then.
+        pending_invalidations.emplace_back(jit, start_address, length);
+        return;
+    }
     jit->InvalidateCacheRange(start_address, length);
 }
 
+void ARM_Dynarmic::ApplyPendingInvalidations() {
+    if (pending_clear) {
+        for (const auto& j : jits) {
+            j.second.jit->ClearCache();
+        }
+        pending_clear = false;
+    } else {
+        for (const auto& [target, start_address, length] : pending_invalidations) {
+            target->InvalidateCacheRange(start_address, length);
+        }
+    }
+    pending_invalidations.clear();
+}
+
 std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
     return current_page_table;
 }
 
 void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
+    // The kernel sets the page table again whenever a core enters it while running in parallel,
+    // which must not reload the context of the JIT it is called from
+    if (jit && page_table == current_page_table) {
+        return;
+    }
     current_page_table = page_table;
     Dynarmic::A32::Context ctx{};
     if (jit) {
@@ -300,15 +382,62 @@ void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_t
 
     auto iter = jits.find(current_page_table);
     if (iter != jits.end()) {
-        jit = iter->second.get();
+        ++jit_cache_stats.reused;
+        iter->second.last_used = ++jit_use_counter;
+        jit = iter->second.jit.get();
         jit->LoadContext(ctx);
         return;
     }
 
+    // The previous JIT may still be running further up the stack
+    EvictJits(jit);
+
+    ++jit_cache_stats.created;
     auto new_jit = MakeJit();
     jit = new_jit.get();
     jit->LoadContext(ctx);
-    jits.emplace(current_page_table, std::move(new_jit));
+    jits.emplace(current_page_table, CachedJit{std::move(new_jit), ++jit_use_counter});
+}
+
+void ARM_Dynarmic::EvictJits(const Dynarmic::A32::Jit* keep) {
+    std::lock_guard lock{invalidation_mutex};
+    const auto erase_jit = [this](auto iter) {
+        const Dynarmic::A32::Jit* erased = iter->second.jit.get();
+        const auto targets_erased = [erased](const auto& pending) {
+            return std::get<0>(pending) == erased;
+        };
+        pending_invalidations.erase(std::remove_if(pending_invalidations.begin(),
+                                                   pending_invalidations.end(), targets_erased),
+                                    pending_invalidations.end());
+        return jits.erase(iter);
+    };
+
+    for (auto iter = jits.begin(); iter != jits.end();) {
+        if (iter->first.expired() && iter->second.jit.get() != keep) {
+            ++jit_cache_stats.released;
+            iter = erase_jit(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    // Leave room for the JIT about to be created
+    while (jits.size() >= MaxJitsPerCore) {
+        auto oldest = jits.end();
+        for (auto iter = jits.begin(); iter != jits.end(); ++iter) {
+            if (iter->second.jit.get() != keep &&
+                (oldest == jits.end() || iter->second.last_used < oldest->second.last_used)) {
+                oldest = iter;
+            }
+        }
+        if (oldest == jits.end()) {
+            break;
+        }
+        LOG_DEBUG(Core_ARM11, "Core {} evicting the JIT of a page table unused for {} switches",
+                  GetID(), jit_use_counter - oldest->second.last_used);
+        ++jit_cache_stats.evicted;
+        erase_jit(oldest);
+    }
 }
 
 void ARM_Dynarmic::ServeBreak() {
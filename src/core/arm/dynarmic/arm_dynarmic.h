@@ -4,8 +4,13 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
 #include <dynarmic/A32/a32.h>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
@@ -61,16 +66,56 @@ protected:
 private:
     void ServeBreak();
 
+    /// Marks this core as blocked while the emulation thread handles a call for it.
+    void SetWaitingOnEmuThread(bool waiting);
+
     friend class DynarmicUserCallbacks;
     Core::System& system;
     Memory::MemorySystem& memory;
     std::unique_ptr<DynarmicUserCallbacks> cb;
     std::unique_ptr<Dynarmic::A32::Jit> MakeJit();
 
+    /// Destroys the JITs of page tables that no longer exist, and the least recently used ones
+    /// beyond the limit, except for the given one.
+    void EvictJits(const Dynarmic::A32::Jit* keep);
+
     u32 fpexc = 0;
     CP15State cp15_state;
 
+    struct CachedJit {
+        std::unique_ptr<Dynarmic::A32::Jit> jit;
+        u64 last_used;
+    };
+
+    struct JitCacheStats {
+        u64 created = 0;
+        u64 reused = 0;
+        /// JITs destroyed because their process exited
+        u64 released = 0;
+        /// JITs destroyed to stay within the limit
+        u64 evicted = 0;
+    };
+
     Dynarmic::A32::Jit* jit = nullptr;
     std::shared_ptr<Memory::PageTable> current_page_table = nullptr;
-    std::map<std::shared_ptr<Memory::PageTable>, std::unique_ptr<Dynarmic::A32::Jit>> jits;
+    // The page tables aren't kept alive by their JIT, so that the JIT can be released along with
+    // its process
+    std::map<std::weak_ptr<Memory::PageTable>, CachedJit, std::owner_less<>> jits;
+    u64 jit_use_counter = 0;
+    JitCacheStats jit_cache_stats;
+
+    /// Whether this core is running guest code on another host thread. Must be called with
+    /// invalidation_mutex held, as must ApplyPendingInvalidations.
+    bool RunsOnAnotherThread() const;
+    /// Applies the invalidations requested by other host threads while this core was running
+    void ApplyPendingInvalidations();
+
+    /// Guards the invalidations requested by other host threads while this core is running
+    std::mutex invalidation_mutex;
+    /// Thread executing guest code on this core, if it is running and not waiting on a call
+    std::thread::id executing_thread;
+    /// Ranges to invalidate, along with the JIT that was current when they were requested
+    std::vector<std::tuple<Dynarmic::A32::Jit*, u32, std::size_t>> pending_invalidations;
+    /// Whether every JIT must be cleared before the next run
+    bool pending_clear = false;
 };
@@ -6,6 +6,7 @@
 #include <cstring>
 #include <memory>
 #include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/arm/dyncom/arm_dyncom_trans.h"
 #include "core/arm/skyeye_common/armstate.h"
@@ -87,12 +88,12 @@ void ARM_DynCom::Step() {
 }
 
 void ARM_DynCom::ClearInstructionCache() {
-    state->instruction_cache.clear();
-    trans_cache_buf_top = 0;
+    ResetTranslationCache();
+    state->block_cache.Clear();
 }
 
-void ARM_DynCom::InvalidateCacheRange(u32, std::size_t) {
-    ClearInstructionCache();
+void ARM_DynCom::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    state->block_cache.InvalidateRange(start_address, length);
 }
 
 void ARM_DynCom::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
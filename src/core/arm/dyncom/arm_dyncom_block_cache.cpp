@@ -0,0 +1,86 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+#include "core/arm/dyncom/arm_dyncom_trans.h"
+
+u32 trans_cache_generation = 0;
+
+void ResetTranslationCache() {
+    trans_cache_buf_top = 0;
+    ++trans_cache_generation;
+}
+
+BlockCache::BlockCache() : generation(trans_cache_generation) {}
+
+std::size_t BlockCache::FindSlow(u32 pc) {
+    const auto itr = blocks.find(pc);
+    if (itr == blocks.end()) {
+        return NotFound;
+    }
+    lookup_table[(pc >> 1) & LookupMask] = {pc, itr->second};
+    return itr->second;
+}
+
+void BlockCache::Insert(u32 pc, std::size_t offset) {
+    if (generation != trans_cache_generation) {
+        Clear();
+    }
+    if (blocks.insert_or_assign(pc, offset).second) {
+        page_blocks[pc >> Memory::PAGE_BITS].push_back(pc);
+    }
+    lookup_table[(pc >> 1) & LookupMask] = {pc, offset};
+}
+
+void BlockCache::InvalidateRange(u32 start_address, std::size_t length) {
+    if (length == 0 || blocks.empty()) {
+        return;
+    }
+    const u64 first_page = start_address >> Memory::PAGE_BITS;
+    const u64 last_page = (start_address + length - 1) >> Memory::PAGE_BITS;
+
+    // Large ranges are cheaper to check against the pages that have blocks
+    if (last_page - first_page >= page_blocks.size()) {
+        std::vector<u32> pages;
+        for (const auto& [page, page_pcs] : page_blocks) {
+            if (page >= first_page && page <= last_page) {
+                pages.push_back(page);
+            }
+        }
+        for (const u32 page : pages) {
+            InvalidatePage(page);
+        }
+    } else {
+        for (u64 page = first_page; page <= last_page; ++page) {
+            InvalidatePage(static_cast<u32>(page));
+        }
+    }
+}
+
+void BlockCache::InvalidatePage(u32 page) {
+    const auto itr = page_blocks.find(page);
+    if (itr == page_blocks.end()) {
+        return;
+    }
+    for (const u32 pc : itr->second) {
+        blocks.erase(pc);
+        LookupEntry& entry = lookup_table[(pc >> 1) & LookupMask];
+        if (entry.pc == pc) {
+            entry = {};
+        }
+    }
+    page_blocks.erase(itr);
+    // Break the links to the discarded blocks
+    ++page_epochs[page & PageEpochMask];
+}
+
+void BlockCache::Clear() {
+    generation = trans_cache_generation;
+    lookup_table.fill({});
+    blocks.clear();
+    page_blocks.clear();
+    for (u32& epoch : page_epochs) {
+        ++epoch;
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "core/memory.h"
+
+/// Incremented whenever the translation buffer is reset, which discards the blocks of every core
+extern u32 trans_cache_generation;
+
+/// Discards every translated block and starts filling the translation buffer from the beginning
+void ResetTranslationCache();
+
+/**
+ * Index of the blocks a core has translated, from their guest address to their offset in the
+ * translation buffer. Lookups go through a small direct-mapped table before the hash map, and the
+ * blocks are grouped by guest page so that a range of them can be discarded when code changes.
+ * A block never crosses a page, as translation stops at the end of one.
+ *
+ * Each page also has an epoch that is incremented when its blocks are discarded. A link from one
+ * block to the next records the epoch of the page it goes to, so invalidating a page only breaks
+ * the links into it.
+ */
+class BlockCache {
+public:
+    static constexpr std::size_t NotFound = std::numeric_limits<std::size_t>::max();
+
+    BlockCache();
+
+    /// Returns the offset of the block starting at pc, or NotFound if it isn't translated.
+    std::size_t Find(u32 pc) {
+        if (generation != trans_cache_generation) {
+            Clear();
+            return NotFound;
+        }
+        const LookupEntry& entry = lookup_table[(pc >> 1) & LookupMask];
+        if (entry.pc == pc) {
+            return entry.offset;
+        }
+        return FindSlow(pc);
+    }
+
+    void Insert(u32 pc, std::size_t offset);
+
+    /// Returns the epoch of the page containing pc. Pages may share an epoch.
+    u32 PageEpoch(u32 pc) const {
+        return page_epochs[(pc >> Memory::PAGE_BITS) & PageEpochMask];
+    }
+
+    /// Discards the blocks in the pages overlapping the given range.
+    void InvalidateRange(u32 start_address, std::size_t length);
+
+    void Clear();
+
+private:
+    static constexpr std::size_t LookupSize = 4096;
+    static constexpr u32 LookupMask = LookupSize - 1;
+    /// No instruction is at an odd address, so this never matches
+    static constexpr u32 InvalidPC = 0xFFFFFFFF;
+    static constexpr std::size_t PageEpochCount = 4096;
+    static constexpr u32 PageEpochMask = PageEpochCount - 1;
+
+    struct LookupEntry {
+        u32 pc = InvalidPC;
+        std::size_t offset = 0;
+    };
+
+    std::size_t FindSlow(u32 pc);
+    void InvalidatePage(u32 page);
+
+    u32 generation;
+    std::array<LookupEntry, LookupSize> lookup_table{};
+    std::array<u32, PageEpochCount> page_epochs{};
+    std::unordered_map<u32, std::size_t> blocks;
+    /// Start addresses of the blocks in each page
+    std::unordered_map<u32, std::vector<u32>> page_blocks;
+};
@@ -10,6 +10,7 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
 #include "core/arm/dyncom/arm_dyncom_dec.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/arm/dyncom/arm_dyncom_run.h"
@@ -840,6 +841,13 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     return inst_size;
 }
 
+static void MakeRoomForBlock() {
+    if (trans_cache_buf_top + TRANS_CACHE_BLOCK_RESERVE > TRANS_CACHE_SIZE) {
+        LOG_DEBUG(Core_ARM11, "Translation cache is full, discarding all blocks");
+        ResetTranslationCache();
+    }
+}
+
 static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
@@ -850,6 +858,7 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
     ARM_INST_PTR inst_base = nullptr;
     TransExtData ret = TransExtData::NON_BRANCH;
     int size = 0; // instruction size of basic block
+    MakeRoomForBlock();
     bb_start = trans_cache_buf_top;
 
     u32 phys_addr = addr;
@@ -868,7 +877,7 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
         ret = inst_base->br;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->block_cache.Insert(pc_start, bb_start);
 
     return KEEP_GOING;
 }
@@ -877,6 +886,7 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     ARM_INST_PTR inst_base = nullptr;
+    MakeRoomForBlock();
     bb_start = trans_cache_buf_top;
 
     u32 phys_addr = addr;
@@ -888,7 +898,7 @@ static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->block_cache.Insert(pc_start, bb_start);
 
     return KEEP_GOING;
 }
@@ -1621,11 +1631,13 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
                          &&INIT_INST_LENGTH,
                          &&END};
 #endif
-    arm_inst* inst_base;
+    arm_inst* inst_base = nullptr;
     unsigned int addr;
     unsigned int num_instrs = 0;
 
     std::size_t ptr;
+    // Generation of the translation buffer when the current block was entered
+    u32 block_generation = trans_cache_generation;
 
     LOAD_NZCVT;
 DISPATCH : {
@@ -1640,17 +1652,35 @@ DISPATCH : {
     else
         cpu->Reg[15] &= 0xfffffffc;
 
-    // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
-    } else if (cpu->NumInstrsToExecute != 1) {
-        if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+    // The instruction that ended the previous block remembers where it went last time, which
+    // saves looking the next block up when it goes to the same place again. It is only followed
+    // if the page it goes to hasn't been invalidated since, and only written if the previous
+    // block hasn't been overwritten by a reset of the translation buffer.
+    const bool can_link = inst_base != nullptr && block_generation == trans_cache_generation;
+    if (can_link && inst_base->link_pc == cpu->Reg[15] &&
+        inst_base->link_epoch == cpu->block_cache.PageEpoch(cpu->Reg[15])) {
+        ptr = inst_base->link_offset;
     } else {
-        if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+        // Find the cached instruction cream, otherwise translate it...
+        ptr = cpu->block_cache.Find(cpu->Reg[15]);
+        if (ptr != BlockCache::NotFound) {
+            // Already translated
+        } else if (cpu->NumInstrsToExecute != 1) {
+            if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        } else {
+            if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        }
+
+        // Translating may have reset the cache, and overwritten the previous block
+        if (can_link && block_generation == trans_cache_generation) {
+            inst_base->link_pc = cpu->Reg[15];
+            inst_base->link_epoch = cpu->block_cache.PageEpoch(cpu->Reg[15]);
+            inst_base->link_offset = static_cast<u32>(ptr);
+        }
     }
+    block_generation = trans_cache_generation;
 
     // Find breakpoint if one exists within the block
     if (GDBStub::IsConnected()) {
@@ -13,6 +13,8 @@ static void* AllocBuffer(std::size_t size) {
     std::size_t start = trans_cache_buf_top;
     trans_cache_buf_top += size;
     ASSERT_MSG(trans_cache_buf_top <= TRANS_CACHE_SIZE, "Translation cache is full!");
+    // Instructions start unlinked, no instruction is at an odd address
+    reinterpret_cast<arm_inst*>(&trans_cache_buf[start])->link_pc = 0xFFFFFFFF;
     return static_cast<void*>(&trans_cache_buf[start]);
 }
 
@@ -26,6 +26,11 @@ struct arm_inst {
     unsigned int idx;
     unsigned int cond;
     TransExtData br;
+    // When this instruction ends a block, the block that was dispatched to after it. The link is
+    // only followed while the epoch of the page it goes to is still link_epoch.
+    u32 link_pc;
+    u32 link_epoch;
+    u32 link_offset;
     char component[0];
 };
 
@@ -494,5 +499,8 @@ extern const transop_fp_t arm_instruction_trans[];
 extern const std::size_t arm_instruction_trans_len;
 
 #define TRANS_CACHE_SIZE (64 * 1024 * 2000)
+// Space that must be left in the translation cache before translating a block. A block is at most
+// a page of Thumb instructions, and no instruction takes more than 256 bytes to store.
+#define TRANS_CACHE_BLOCK_RESERVE (2048 * 256)
 extern char trans_cache_buf[TRANS_CACHE_SIZE];
 extern std::size_t trans_cache_buf_top;
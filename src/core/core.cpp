@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <stdexcept>
@@ -19,6 +20,7 @@
 #include "core/arm/dyncom/arm_dyncom.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
+#include "core/core_thread_pool.h"
 #include "core/core_timing.h"
 #include "core/dumping/backend.h"
 #ifdef ENABLE_FFMPEG_VIDEO_DUMPER
@@ -41,6 +43,7 @@
 #include "core/hw/lcd.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/rewind_buffer.h"
 #include "core/rpc/rpc_server.h"
 #include "core/settings.h"
 #include "network/network.h"
@@ -122,6 +125,19 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::Rewind: {
+        try {
+            if (!Rewind()) {
+                LOG_WARNING(Core, "There is no rewind snapshot to go back to");
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error rewinding: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        frame_limiter.WaitOnce();
+        return ResultStatus::Success;
+    }
     case Signal::Save: {
         LOG_INFO(Core, "Begin save");
         try {
@@ -139,6 +155,10 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         break;
     }
 
+    if (rewind_buffer) {
+        UpdateRewindBuffer();
+    }
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -186,36 +206,46 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     } else {
         // Now all cores are at the same global time. So we will run them one after the other
         // with a max slice that is the minimum of all max slices of all cores
-        // TODO: Make special check for idle since we can easily revert the time of idle cores
         s64 max_slice = Timing::MAX_SLICE_LENGTH;
+        bool all_cores_idle = true;
         for (const auto& cpu_core : cpu_cores) {
             kernel->SetRunningCPU(cpu_core.get());
             cpu_core->GetTimer().Advance();
             cpu_core->PrepareReschedule();
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
+            if (kernel->GetThreadManager(cpu_core->GetID()).GetCurrentThread() != nullptr) {
+                all_cores_idle = false;
+            }
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        if (all_cores_idle) {
+            // Only an event can wake a thread up, so nothing would run before the earliest one
+            SkipIdleTime();
+        } else if (cpu_thread_pool && tight_loop) {
+            RunCoresInParallel(max_slice);
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        cpu_core->Run();
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -229,6 +259,65 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
     return status;
 }
 
+void System::SkipIdleTime() {
+    // Skipping more than a frame at once would delay handling signals such as shutdown
+    constexpr s64 max_idle_ticks = BASE_CLOCK_RATE_ARM11 / 60;
+    const s64 skipped = timing->SkipIdleTime(max_idle_ticks, [this] {
+        bool all_cores_idle = true;
+        for (const auto& cpu_core : cpu_cores) {
+            kernel->SetRunningCPU(cpu_core.get());
+            cpu_core->GetTimer().Advance();
+            cpu_core->PrepareReschedule();
+            kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
+            if (kernel->GetThreadManager(cpu_core->GetID()).GetCurrentThread() != nullptr) {
+                all_cores_idle = false;
+            }
+        }
+        return all_cores_idle;
+    });
+    LOG_TRACE(Core_ARM11, "All cores idled for {} ticks", skipped);
+    perf_stats->AddIdleTicks(skipped);
+}
+
+void System::RunCoresInParallel(s64 max_slice) {
+    // Unlike in sequence, every core gets the whole slice even if another one stops early. The
+    // cores that fall behind catch up alone before the next parallel slice.
+    cpu_thread_pool->RunSlice([this, max_slice](std::size_t i) {
+        ARM_Interface& cpu_core = *cpu_cores[i];
+        bool idle = false;
+        // The emulation thread may be cancelling events of any core, so the event queue is only
+        // looked at from there
+        CallOnEmuThread(cpu_core, [&] {
+            cpu_core.GetTimer().SetNextSlice(max_slice);
+            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core.GetID(),
+                      cpu_core.GetTimer().GetDowncount());
+            idle = kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr;
+            if (idle) {
+                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core.GetID());
+                cpu_core.GetTimer().Idle();
+                PrepareReschedule();
+            }
+        });
+        if (!idle) {
+            cpu_core.Run();
+        }
+    });
+}
+
+void System::SendToEmuThread(ARM_Interface& core, const std::function<void()>& func) {
+    if (!CoreThreadPool::IsCoreThread()) {
+        func();
+        return;
+    }
+    cpu_thread_pool->CallOnEmuThread([this, &core, &func] {
+        if (kernel->GetRunningCPU() != &core) {
+            kernel->SetRunningCPU(&core);
+        }
+        running_core = &core;
+        func();
+    });
+}
+
 bool System::SendSignal(System::Signal signal, u32 param) {
     std::lock_guard lock{signal_mutex};
     if (current_signal != signal && current_signal != Signal::None) {
@@ -307,6 +396,12 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                   static_cast<u32>(load_result));
     }
     perf_stats = std::make_unique<PerfStats>(title_id);
+    if (Settings::values.enable_rewind) {
+        const auto budget_mb = std::max(Settings::values.rewind_buffer_size, 0);
+        rewind_buffer =
+            std::make_unique<RewindBuffer>(static_cast<std::size_t>(budget_mb) * 1024 * 1024);
+        next_rewind_snapshot_ticks = 0;
+    }
     custom_tex_cache = std::make_unique<Core::CustomTexCache>();
 
     if (Settings::values.custom_textures) {
@@ -368,6 +463,13 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
             cpu_cores.push_back(
                 std::make_shared<ARM_Dynarmic>(this, *memory, i, timing->GetTimer(i)));
         }
+        if (Settings::values.use_multi_core && num_cores > 1) {
+            if (Settings::values.use_gdbstub) {
+                LOG_WARNING(Core, "Cores can't run in parallel while the GDB stub is enabled");
+            } else {
+                cpu_thread_pool = std::make_unique<CoreThreadPool>(num_cores);
+            }
+        }
 #else
         for (u32 i = 0; i < num_cores; ++i) {
             cpu_cores.push_back(
@@ -532,6 +634,7 @@ void System::Shutdown(bool is_deserializing) {
     if (!is_deserializing) {
         GDBStub::Shutdown();
         perf_stats.reset();
+        rewind_buffer.reset();
         cheat_engine.reset();
         app_loader.reset();
     }
@@ -540,6 +643,7 @@ void System::Shutdown(bool is_deserializing) {
     archive_manager.reset();
     service_manager.reset();
     dsp_core.reset();
+    cpu_thread_pool.reset();
     cpu_cores.clear();
     kernel.reset();
     timing.reset();
@@ -586,9 +690,15 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
         Init(*m_emu_window, *system_mode.first, *n3ds_mode.first, num_cores);
     }
 
-    // flush on save, don't flush on load
-    bool should_flush = !Archive::is_loading::value;
-    Memory::RasterizerClearAll(should_flush);
+    if (taking_rewind_snapshot) {
+        // Snapshots are taken every few seconds, and recreating every surface after each would
+        // stall rendering. Writing the surfaces back to memory is enough to serialize it.
+        Memory::RasterizerFlushAll();
+    } else {
+        // flush on save, don't flush on load
+        bool should_flush = !Archive::is_loading::value;
+        Memory::RasterizerClearAll(should_flush);
+    }
     ar&* timing.get();
     for (u32 i = 0; i < num_cores; i++) {
         ar&* cpu_cores[i].get();
@@ -607,7 +717,15 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
         throw std::runtime_error("LLE audio not supported for save states");
     }
 
+    // Incremental savestates only contain the pages that changed since their base
+    if (Archive::is_loading::value && loading_savestate_base) {
+        memory->LoadSaveStateBase(*loading_savestate_base);
+    }
     ar&* memory.get();
+    if (Archive::is_loading::value) {
+        // Rewind snapshots keep the pages cached by the rasterizer marked, but its cache is empty
+        memory->RasterizerUnmarkAll();
+    }
     ar&* kernel.get();
     VideoCore::serialize(ar, file_version);
     if (file_version >= 1) {
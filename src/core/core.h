@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <boost/serialization/version.hpp>
 #include "common/common_types.h"
 #include "core/custom_tex_cache.h"
@@ -61,6 +63,8 @@ class RendererBase;
 
 namespace Core {
 
+class CoreThreadPool;
+class RewindBuffer;
 class Timing;
 
 class System {
@@ -120,7 +124,7 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, Rewind };
 
     bool SendSignal(Signal signal, u32 param = 0);
 
@@ -191,6 +195,25 @@ public:
         return static_cast<u32>(cpu_cores.size());
     }
 
+    /// Returns whether each core runs its slices on its own host thread.
+    bool RunsCoresInParallel() const {
+        return cpu_thread_pool != nullptr;
+    }
+
+    /**
+     * Runs func, which may enter the kernel, HLE, I/O or the rasterizer, on behalf of core. When
+     * the cores run in parallel and this is called from a core thread, func is sent to the
+     * emulation thread with core as the running core, and this waits for it to complete.
+     */
+    template <typename Func>
+    void CallOnEmuThread(ARM_Interface& core, Func&& func) {
+        if (!cpu_thread_pool) {
+            func();
+            return;
+        }
+        SendToEmuThread(core, std::forward<Func>(func));
+    }
+
     void InvalidateCacheRange(u32 start_address, std::size_t length) {
         for (const auto& cpu : cpu_cores) {
             cpu->InvalidateCacheRange(start_address, length);
@@ -304,10 +327,13 @@ public:
         return registered_image_interface;
     }
 
-    void SaveState(u32 slot) const;
+    void SaveState(u32 slot);
 
     void LoadState(u32 slot);
 
+    /// Goes back to the newest rewind snapshot. Returns false if there is none.
+    bool Rewind();
+
 private:
     /**
      * Initialize the emulated system.
@@ -329,6 +355,17 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads running the cores in parallel, if enabled
+    std::unique_ptr<CoreThreadPool> cpu_thread_pool;
+
+    /// Moves every core ahead from event to event without running them, while all cores are idle
+    void SkipIdleTime();
+
+    /// Runs a slice of every core in parallel, with all cores at the same global time
+    void RunCoresInParallel(s64 max_slice);
+
+    void SendToEmuThread(ARM_Interface& core, const std::function<void()>& func);
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -382,6 +419,22 @@ private:
     Signal current_signal;
     u32 signal_param;
 
+    /// Slot and identifier of the base the incremental savestates are currently written against
+    u32 savestate_base_slot{};
+    u64 savestate_base_id{};
+    /// Memory to restore before the pages of the incremental savestate being loaded
+    const std::vector<u8>* loading_savestate_base = nullptr;
+
+    /// Takes a rewind snapshot if enough frames have passed since the last one
+    void UpdateRewindBuffer();
+
+    /// Snapshots to rewind to, when rewinding is enabled
+    std::unique_ptr<RewindBuffer> rewind_buffer;
+    /// Global tick count at which the next rewind snapshot is taken
+    u64 next_rewind_snapshot_ticks{};
+    /// Whether the state being serialized is a rewind snapshot, which keeps the rasterizer cache
+    bool taking_rewind_snapshot = false;
+
     friend class boost::serialization::access;
     template <typename Archive>
     void serialize(Archive& ar, const unsigned int file_version);
@@ -0,0 +1,105 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/core_thread_pool.h"
+
+MICROPROFILE_DEFINE(Core_EmuThreadCall, "Core", "Calls from Core Threads", MP_RGB(200, 100, 50));
+
+namespace Core {
+
+static thread_local bool is_core_thread = false;
+
+CoreThreadPool::CoreThreadPool(std::size_t num_cores) {
+    workers.reserve(num_cores);
+    for (std::size_t i = 0; i < num_cores; ++i) {
+        workers.emplace_back([this, i] {
+            Common::SetCurrentThreadName(("CPUCore" + std::to_string(i)).c_str());
+            MicroProfileOnThreadCreate("CPUCore");
+            is_core_thread = true;
+            WorkerLoop(i);
+            MicroProfileOnThreadExit();
+        });
+    }
+}
+
+CoreThreadPool::~CoreThreadPool() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void CoreThreadPool::RunSlice(const std::function<void(std::size_t)>& run_core) {
+    ASSERT(!is_core_thread);
+
+    std::unique_lock lock{mutex};
+    job = &run_core;
+    running_cores = workers.size();
+    ++generation;
+    work_cv.notify_all();
+
+    while (true) {
+        emu_cv.wait(lock, [this] { return !calls.empty() || running_cores == 0; });
+        if (calls.empty()) {
+            break;
+        }
+
+        Call* call = calls.front();
+        calls.pop_front();
+        lock.unlock();
+        {
+            MICROPROFILE_SCOPE(Core_EmuThreadCall);
+            (*call->func)();
+        }
+        lock.lock();
+        call->done = true;
+        calls_cv.notify_all();
+    }
+    job = nullptr;
+}
+
+void CoreThreadPool::CallOnEmuThread(const std::function<void()>& func) {
+    ASSERT(is_core_thread);
+
+    Call call{&func};
+    std::unique_lock lock{mutex};
+    calls.push_back(&call);
+    emu_cv.notify_one();
+    calls_cv.wait(lock, [&call] { return call.done; });
+}
+
+bool CoreThreadPool::IsCoreThread() {
+    return is_core_thread;
+}
+
+void CoreThreadPool::WorkerLoop(std::size_t core_id) {
+    u64 last_generation = 0;
+    std::unique_lock lock{mutex};
+    while (true) {
+        work_cv.wait(lock, [&] { return stop || generation != last_generation; });
+        if (stop) {
+            return;
+        }
+        last_generation = generation;
+
+        const auto& run_core = *job;
+        lock.unlock();
+        run_core(core_id);
+        lock.lock();
+
+        if (--running_cores == 0) {
+            emu_cv.notify_one();
+        }
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,63 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Host threads that run the slices of the emulated cores in parallel, one thread per core. The
+ * kernel, HLE services, I/O and the rasterizer are only ever entered from the emulation thread,
+ * so core threads send such calls to it, and it executes them one at a time while it waits for
+ * the slice to end.
+ */
+class CoreThreadPool : NonCopyable {
+public:
+    explicit CoreThreadPool(std::size_t num_cores);
+    ~CoreThreadPool();
+
+    /**
+     * Calls run_core(i) on the thread of every core i, and executes the calls they send to the
+     * emulation thread until all of them have returned. Must be called from the emulation thread.
+     */
+    void RunSlice(const std::function<void(std::size_t)>& run_core);
+
+    /// Runs func on the emulation thread and waits for it. Must be called from a core thread.
+    void CallOnEmuThread(const std::function<void()>& func);
+
+    /// Returns whether the calling thread is one of the core threads.
+    static bool IsCoreThread();
+
+private:
+    struct Call {
+        const std::function<void()>* func;
+        bool done = false;
+    };
+
+    void WorkerLoop(std::size_t core_id);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;  ///< Wakes the core threads for a slice
+    std::condition_variable emu_cv;   ///< Wakes the emulation thread for calls or the slice end
+    std::condition_variable calls_cv; ///< Wakes the core threads once their call is done
+
+    const std::function<void(std::size_t)>* job = nullptr;
+    std::deque<Call*> calls;
+    std::size_t running_cores = 0;
+    u64 generation = 0;
+    bool stop = false;
+};
+
+} // namespace Core
@@ -64,9 +64,7 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
         if (!timer->is_timer_sane)
             timer->ForceExceptionCheck(cycles_into_future);
 
-        timer->event_queue.emplace_back(
-            Event{timeout, timer->event_fifo_id++, userdata, event_type});
-        std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        timer->event_queue.Push(Event{timeout, timer->event_fifo_id++, userdata, event_type});
     } else {
         timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
                                    userdata, event_type});
@@ -74,32 +72,18 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
 }
 
 void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
-    for (auto timer : timers) {
-        auto itr = std::remove_if(
-            timer->event_queue.begin(), timer->event_queue.end(),
-            [&](const Event& e) { return e.type == event_type && e.userdata == userdata; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+    for (auto& timer : timers) {
+        // Events scheduled from other threads must be in the queue to be found
+        timer->MoveEvents();
+        timer->event_queue.Remove(event_type, userdata);
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
-    for (auto timer : timers) {
-        auto itr = std::remove_if(timer->event_queue.begin(), timer->event_queue.end(),
-                                  [&](const Event& e) { return e.type == event_type; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
-        }
+    for (auto& timer : timers) {
+        timer->MoveEvents();
+        timer->event_queue.RemoveAll(event_type);
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::SetCurrentTimer(std::size_t core_id) {
@@ -126,6 +110,166 @@ std::shared_ptr<Timing::Timer> Timing::GetTimer(std::size_t cpu_id) {
     return timers[cpu_id];
 }
 
+s64 Timing::SkipIdleTime(s64 max_ticks, const std::function<bool()>& advance_while_idle) {
+    s64 skipped = 0;
+    do {
+        s64 ticks = max_ticks - skipped;
+        for (auto& timer : timers) {
+            // Events scheduled from other threads may come first
+            timer->MoveEvents();
+            ticks = std::min(ticks, timer->GetMaxSliceLength());
+        }
+        for (auto& timer : timers) {
+            timer->SetNextSlice(ticks);
+            timer->Idle();
+        }
+        skipped += ticks;
+    } while (skipped < max_ticks && advance_while_idle());
+    return skipped;
+}
+
+void Timing::EventQueue::Push(const Event& event) {
+    u32 slot;
+    if (free_slots.empty()) {
+        slot = static_cast<u32>(slots.size());
+        slots.emplace_back();
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+
+    // Link the event in front of the others with the same type and userdata
+    const auto [first, inserted] = first_slots.try_emplace({event.type, event.userdata}, slot);
+    const u32 next_with_key = inserted ? InvalidSlot : first->second;
+    if (!inserted) {
+        slots[next_with_key].previous_with_key = slot;
+        first->second = slot;
+    }
+    slots[slot] = Slot{event, heap.size(), InvalidSlot, next_with_key};
+
+    heap.push_back(Entry{event.time, event.fifo_order, slot});
+    SiftUp(heap.size() - 1);
+}
+
+Timing::Event Timing::EventQueue::Pop() {
+    const u32 slot = heap.front().slot;
+    Event event = slots[slot].event;
+    RemoveSlot(slot);
+    return event;
+}
+
+void Timing::EventQueue::Remove(const TimingEventType* event_type, u64 userdata) {
+    const auto first = first_slots.find({event_type, userdata});
+    if (first == first_slots.end()) {
+        return;
+    }
+    u32 slot = first->second;
+    first_slots.erase(first);
+    while (slot != InvalidSlot) {
+        const u32 next_with_key = slots[slot].next_with_key;
+        // The key is already gone, so only unlink the event from the heap
+        slots[slot].previous_with_key = InvalidSlot;
+        slots[slot].next_with_key = InvalidSlot;
+        RemoveSlot(slot);
+        slot = next_with_key;
+    }
+}
+
+void Timing::EventQueue::RemoveAll(const TimingEventType* event_type) {
+    std::vector<u64> userdatas;
+    for (const auto& [key, slot] : first_slots) {
+        if (key.first == event_type) {
+            userdatas.push_back(key.second);
+        }
+    }
+    for (const u64 userdata : userdatas) {
+        Remove(event_type, userdata);
+    }
+}
+
+std::vector<Timing::Event> Timing::EventQueue::GetEvents() const {
+    std::vector<Event> events;
+    events.reserve(heap.size());
+    for (const auto& entry : heap) {
+        events.push_back(slots[entry.slot].event);
+    }
+    return events;
+}
+
+void Timing::EventQueue::Clear() {
+    heap.clear();
+    slots.clear();
+    free_slots.clear();
+    first_slots.clear();
+}
+
+void Timing::EventQueue::Place(std::size_t index, const Entry& entry) {
+    heap[index] = entry;
+    slots[entry.slot].heap_index = index;
+}
+
+void Timing::EventQueue::SiftUp(std::size_t index) {
+    const Entry entry = heap[index];
+    while (index > 0) {
+        const std::size_t parent = (index - 1) / 2;
+        if (!(entry < heap[parent])) {
+            break;
+        }
+        Place(index, heap[parent]);
+        index = parent;
+    }
+    Place(index, entry);
+}
+
+void Timing::EventQueue::SiftDown(std::size_t index) {
+    const Entry entry = heap[index];
+    while (true) {
+        std::size_t child = index * 2 + 1;
+        if (child >= heap.size()) {
+            break;
+        }
+        if (child + 1 < heap.size() && heap[child + 1] < heap[child]) {
+            ++child;
+        }
+        if (!(heap[child] < entry)) {
+            break;
+        }
+        Place(index, heap[child]);
+        index = child;
+    }
+    Place(index, entry);
+}
+
+void Timing::EventQueue::RemoveSlot(u32 slot) {
+    Slot& removed = slots[slot];
+
+    // Unlink the event from the others with the same type and userdata
+    if (removed.previous_with_key != InvalidSlot) {
+        slots[removed.previous_with_key].next_with_key = removed.next_with_key;
+    } else if (removed.next_with_key != InvalidSlot) {
+        first_slots[{removed.event.type, removed.event.userdata}] = removed.next_with_key;
+    } else {
+        first_slots.erase({removed.event.type, removed.event.userdata});
+    }
+    if (removed.next_with_key != InvalidSlot) {
+        slots[removed.next_with_key].previous_with_key = removed.previous_with_key;
+    }
+
+    // Fill the hole with the last entry of the heap, which may belong above or below it
+    const std::size_t index = removed.heap_index;
+    const Entry last = heap.back();
+    heap.pop_back();
+    if (index < heap.size()) {
+        Place(index, last);
+        if (index > 0 && last < heap[(index - 1) / 2]) {
+            SiftUp(index);
+        } else {
+            SiftDown(index);
+        }
+    }
+    free_slots.push_back(slot);
+}
+
 Timing::Timer::Timer() = default;
 
 Timing::Timer::~Timer() {
@@ -159,16 +303,15 @@ void Timing::Timer::ForceExceptionCheck(s64 cycles) {
 void Timing::Timer::MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+        event_queue.Push(ev);
     }
 }
 
 s64 Timing::Timer::GetMaxSliceLength() const {
-    const auto& next_event = event_queue.begin();
-    if (next_event != event_queue.end()) {
-        ASSERT(next_event->time - executed_ticks > 0);
-        return next_event->time - executed_ticks;
+    if (!event_queue.Empty()) {
+        const Event& next_event = event_queue.Top();
+        ASSERT(next_event.time - executed_ticks > 0);
+        return next_event.time - executed_ticks;
     }
     return MAX_SLICE_LENGTH;
 }
@@ -184,10 +327,8 @@ void Timing::Timer::Advance() {
 
     is_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= executed_ticks) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    while (!event_queue.Empty() && event_queue.Top().time <= executed_ticks) {
+        Event evt = event_queue.Pop();
         if (evt.type->callback != nullptr) {
             evt.type->callback(evt.userdata, executed_ticks - evt.time);
         } else {
@@ -202,9 +343,9 @@ void Timing::Timer::SetNextSlice(s64 max_slice_length) {
     slice_length = max_slice_length;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
+    if (!event_queue.Empty()) {
         slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - executed_ticks, max_slice_length));
+            std::min<s64>(event_queue.Top().time - executed_ticks, max_slice_length));
     }
 
     downcount = slice_length;
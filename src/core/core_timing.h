@@ -22,6 +22,7 @@
 #include <limits>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <boost/serialization/split_member.hpp>
 #include <boost/serialization/vector.hpp>
@@ -171,6 +172,83 @@ public:
         BOOST_SERIALIZATION_SPLIT_MEMBER()
     };
 
+    /**
+     * Min-heap of events, ordered by time and then by the order they were scheduled in. It keeps
+     * track of where every event is, so that events can be cancelled by type and userdata in
+     * O(log n) rather than by searching and re-heapifying the whole queue.
+     */
+    class EventQueue {
+    public:
+        bool Empty() const {
+            return heap.empty();
+        }
+
+        std::size_t Size() const {
+            return heap.size();
+        }
+
+        /// Returns the earliest event. The queue must not be empty.
+        const Event& Top() const {
+            return slots[heap.front().slot].event;
+        }
+
+        void Push(const Event& event);
+
+        /// Removes and returns the earliest event. The queue must not be empty.
+        Event Pop();
+
+        /// Removes all events of the given type with the given userdata.
+        void Remove(const TimingEventType* event_type, u64 userdata);
+
+        /// Removes all events of the given type.
+        void RemoveAll(const TimingEventType* event_type);
+
+        /// Returns the queued events, in no particular order.
+        std::vector<Event> GetEvents() const;
+
+        void Clear();
+
+    private:
+        static constexpr u32 InvalidSlot = std::numeric_limits<u32>::max();
+
+        /// Heap entries repeat the ordering of their event, so sifting stays within the heap
+        struct Entry {
+            s64 time;
+            u64 fifo_order;
+            u32 slot;
+
+            bool operator<(const Entry& right) const {
+                return time != right.time ? time < right.time : fifo_order < right.fifo_order;
+            }
+        };
+
+        /// Storage of an event, which also links the events sharing its type and userdata
+        struct Slot {
+            Event event;
+            std::size_t heap_index;
+            u32 previous_with_key;
+            u32 next_with_key;
+        };
+
+        using Key = std::pair<const TimingEventType*, u64>;
+        struct KeyHash {
+            std::size_t operator()(const Key& key) const {
+                return std::hash<const void*>{}(key.first) ^ std::hash<u64>{}(key.second) * 31;
+            }
+        };
+
+        void Place(std::size_t index, const Entry& entry);
+        void SiftUp(std::size_t index);
+        void SiftDown(std::size_t index);
+        void RemoveSlot(u32 slot);
+
+        std::vector<Entry> heap;
+        std::vector<Slot> slots;
+        std::vector<u32> free_slots;
+        /// First slot of the events with each type and userdata
+        std::unordered_map<Key, u32, KeyHash> first_slots;
+    };
+
     // currently Service::HID::pad_update_ticks is the smallest interval for an event that gets
     // always scheduled. Therfore we use this as orientation for the MAX_SLICE_LENGTH
     // For performance bigger slice length are desired, though this will lead to cores desync
@@ -205,11 +283,7 @@ public:
 
     private:
         friend class Timing;
-        // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-        // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-        // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-        // accomodated by the standard adaptor class.
-        std::vector<Event> event_queue;
+        EventQueue event_queue;
         u64 event_fifo_id = 0;
         // the queue for storing the events from other threads threadsafe until they will be added
         // to the event_queue by the emu thread
@@ -238,7 +312,18 @@ public:
             // TODO(SaveState): Remove the next two lines when we break compatibility
             s64 x;
             ar& x; // to keep compatibility with old save states that stored global_timer
-            ar& event_queue;
+            // Stored as a plain vector of events, as it was before the queue was indexed
+            std::vector<Event> events;
+            if (Archive::is_saving::value) {
+                events = event_queue.GetEvents();
+            }
+            ar& events;
+            if (Archive::is_loading::value) {
+                event_queue.Clear();
+                for (const auto& event : events) {
+                    event_queue.Push(event);
+                }
+            }
             ar& event_fifo_id;
             ar& slice_length;
             ar& downcount;
@@ -260,9 +345,11 @@ public:
     void ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_type, u64 userdata = 0,
                        std::size_t core_id = std::numeric_limits<std::size_t>::max());
 
+    /// Cancels the events of the given type with the given userdata, including those scheduled
+    /// from other threads that have not been moved to their timer's queue yet.
     void UnscheduleEvent(const TimingEventType* event_type, u64 userdata);
 
-    /// We only permit one event of each type in the queue at a time.
+    /// Cancels all events of the given type.
     void RemoveEvent(const TimingEventType* event_type);
 
     void SetCurrentTimer(std::size_t core_id);
@@ -280,6 +367,17 @@ public:
 
     std::shared_ptr<Timer> GetTimer(std::size_t cpu_id);
 
+    /**
+     * Moves every timer from one event to the next without executing anything in between, for
+     * when all cores are idle. This isn't limited by MAX_SLICE_LENGTH, which only exists to keep
+     * running cores in sync.
+     * @param max_ticks Most ticks to skip in total
+     * @param advance_while_idle Called after each skip to advance the timers, which runs the
+     *        events that are due. Returns whether all cores are still idle afterwards.
+     * @returns The number of ticks skipped
+     */
+    s64 SkipIdleTime(s64 max_ticks, const std::function<bool()>& advance_while_idle);
+
 private:
     // unordered_map stores each element separately as a linked list node so pointers to
     // elements remain stable regardless of rehashes/resizing.
@@ -42,6 +42,14 @@ public:
     virtual ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                          const u8* buffer) = 0;
 
+    /**
+     * Whether Read may be called from another thread while the other methods are in use, which
+     * allows reads of this file to be serviced asynchronously.
+     */
+    virtual bool AllowsAsyncRead() const {
+        return false;
+    }
+
     /**
      * Get the amount of time a 3ds needs to read those data
      * @param length Length in bytes of data read from file
@@ -127,6 +127,10 @@ public:
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
+    bool AllowsAsyncRead() const override {
+        // RomFS is read-only and its size never changes
+        return true;
+    }
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
     bool Close() const override {
@@ -4,13 +4,16 @@
 
 #include <algorithm>
 #include <cstring>
+#include <fmt/format.h>
 #include "common/alignment.h"
 #include "common/archives.h"
 #include "common/assert.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/string_util.h"
 #include "common/swap.h"
+#include "common/thread_pool.h"
 #include "core/file_sys/layered_fs.h"
 #include "core/file_sys/patch.h"
 
@@ -54,6 +57,15 @@ struct FileMetadata {
 };
 static_assert(sizeof(FileMetadata) == 0x20, "Size of FileMetadata is not correct");
 
+/// Version of the metadata cache format, bump when it changes
+constexpr u32 CacheVersion = 1;
+
+static void AppendTrailingSeparator(std::string& path) {
+    if (!path.empty() && path.back() != '/' && path.back() != '\\') {
+        path += DIR_SEP;
+    }
+}
+
 LayeredFS::LayeredFS() = default;
 
 LayeredFS::LayeredFS(std::shared_ptr<RomFSReader> romfs_, std::string patch_path_,
@@ -68,16 +80,34 @@ void LayeredFS::Load() {
 
     ASSERT_MSG(header.header_length == sizeof(header), "Header size is incorrect");
 
+    if (!load_relocations) {
+        root.parent = &root;
+        LoadDirectory(root, 0);
+        RebuildMetadata();
+        return;
+    }
+
+    AppendTrailingSeparator(patch_path);
+    AppendTrailingSeparator(patch_ext_path);
+
+    Common::ThreadPool pool;
+    const auto patch_tree = ScanPatchDirectory(pool, patch_path);
+    const auto patch_ext_tree = ScanPatchDirectory(pool, patch_ext_path);
+
+    const u64 cache_key = GetCacheKey(patch_tree, patch_ext_tree);
+    if (LoadCache(cache_key)) {
+        return;
+    }
+
     // TODO: is root always the first directory in table?
     root.parent = &root;
     LoadDirectory(root, 0);
 
-    if (load_relocations) {
-        LoadRelocations();
-        LoadExtRelocations();
-    }
+    LoadRelocations(patch_tree);
+    LoadExtRelocations(pool, patch_ext_tree);
 
     RebuildMetadata();
+    SaveCache(cache_key);
 }
 
 LayeredFS::~LayeredFS() = default;
@@ -145,36 +175,86 @@ std::string LayeredFS::ReadName(u32 offset, u32 name_length) {
     return Common::UTF16ToUTF8(name);
 }
 
-void LayeredFS::LoadRelocations() {
-    if (!FileUtil::Exists(patch_path)) {
+LayeredFS::PatchTree LayeredFS::ScanPatchDirectory(Common::ThreadPool& pool,
+                                                   const std::string& path) {
+    PatchTree tree;
+    if (path.empty() || !FileUtil::IsDirectory(path)) {
+        return tree;
+    }
+
+    std::string root_path = path;
+    AppendTrailingSeparator(root_path);
+
+    // Scan one level of directories at a time, each directory on its own thread. The entries
+    // keep the order they were listed in, so the tree is the same as a recursive scan would give.
+    tree.push_back({DIR_SEP});
+    std::size_t level_begin = 0;
+    while (level_begin < tree.size()) {
+        const std::size_t level_end = tree.size();
+        pool.ParallelFor(level_end - level_begin, [&tree, &root_path, level_begin](std::size_t i) {
+            auto& directory = tree[level_begin + i];
+            FileUtil::ForeachDirectoryEntry(
+                nullptr, root_path + directory.path.substr(1),
+                [&directory](u64* /*num_entries_out*/, const std::string& physical_directory,
+                             const std::string& virtual_name) {
+                    PatchEntry entry;
+                    entry.name = virtual_name;
+                    if (!FileUtil::GetStatus(physical_directory + virtual_name, entry.status)) {
+                        return true;
+                    }
+                    directory.entries.emplace_back(std::move(entry));
+                    return true;
+                });
+        });
+
+        for (std::size_t i = level_begin; i < level_end; ++i) {
+            for (std::size_t j = 0; j < tree[i].entries.size(); ++j) {
+                auto& entry = tree[i].entries[j];
+                if (!entry.status.is_directory) {
+                    continue;
+                }
+                entry.directory_index = tree.size();
+                auto child_path = tree[i].path + entry.name + DIR_SEP;
+                tree.push_back({std::move(child_path)});
+            }
+        }
+        level_begin = level_end;
+    }
+
+    return tree;
+}
+
+void LayeredFS::LoadRelocations(const PatchTree& patch_tree) {
+    if (patch_tree.empty()) {
         return;
     }
+    LoadRelocations(patch_tree, 0);
+}
 
-    const FileUtil::DirectoryEntryCallable callback = [this,
-                                                       &callback](u64* /*num_entries_out*/,
-                                                                  const std::string& directory,
-                                                                  const std::string& virtual_name) {
-        auto* parent = directory_path_map.at(directory.substr(patch_path.size() - 1));
+void LayeredFS::LoadRelocations(const PatchTree& patch_tree, std::size_t directory_index) {
+    const auto& current = patch_tree[directory_index];
+    auto* parent = directory_path_map.at(current.path);
 
-        if (FileUtil::IsDirectory(directory + virtual_name + DIR_SEP)) {
-            const auto path = (directory + virtual_name + DIR_SEP).substr(patch_path.size() - 1);
+    for (const auto& entry : current.entries) {
+        if (entry.status.is_directory) {
+            const auto path = current.path + entry.name + DIR_SEP;
             if (!directory_path_map.count(path)) { // Add this directory
                 auto directory = std::make_unique<Directory>();
-                directory->name = virtual_name;
+                directory->name = entry.name;
                 directory->path = path;
                 directory->parent = parent;
                 directory_path_map.emplace(path, directory.get());
                 parent->directories.emplace_back(std::move(directory));
                 LOG_INFO(Service_FS, "LayeredFS created directory {}", path);
             }
-            return FileUtil::ForeachDirectoryEntry(nullptr, directory + virtual_name + DIR_SEP,
-                                                   callback);
+            LoadRelocations(patch_tree, entry.directory_index);
+            continue;
         }
 
-        const auto path = (directory + virtual_name).substr(patch_path.size() - 1);
+        const auto path = current.path + entry.name;
         if (!file_path_map.count(path)) { // Newly created file
             auto file = std::make_unique<File>();
-            file->name = virtual_name;
+            file->name = entry.name;
             file->path = path;
             file->parent = parent;
             file_path_map.emplace(path, file.get());
@@ -184,34 +264,33 @@ void LayeredFS::LoadRelocations() {
 
         auto* file = file_path_map.at(path);
         file->relocation.type = 1;
-        file->relocation.replace_file_path = directory + virtual_name;
-        file->relocation.size = FileUtil::GetSize(directory + virtual_name);
+        file->relocation.replace_file_path = patch_path + path.substr(1);
+        file->relocation.size = entry.status.size;
         LOG_INFO(Service_FS, "LayeredFS replacement file in use for {}", path);
-        return true;
-    };
-
-    FileUtil::ForeachDirectoryEntry(nullptr, patch_path, callback);
+    }
 }
 
-void LayeredFS::LoadExtRelocations() {
-    if (!FileUtil::Exists(patch_ext_path)) {
+void LayeredFS::LoadExtRelocations(Common::ThreadPool& pool, const PatchTree& patch_ext_tree) {
+    if (patch_ext_tree.empty()) {
         return;
     }
 
-    if (patch_ext_path.back() == '/' || patch_ext_path.back() == '\\') {
-        // ScanDirectoryTree expects a path without trailing '/'
-        patch_ext_path.erase(patch_ext_path.size() - 1, 1);
-    }
-
-    FileUtil::FSTEntry result;
-    FileUtil::ScanDirectoryTree(patch_ext_path, result, 256);
+    struct PatchJob {
+        File* file;
+        std::string patch_path;
+        bool is_ips;
+        std::vector<u8> buffer;
+        bool success = false;
+    };
+    std::vector<PatchJob> jobs;
 
-    for (const auto& entry : result.children) {
-        if (FileUtil::IsDirectory(entry.physicalName)) {
+    // Only entries directly in the extension directory are considered
+    for (const auto& entry : patch_ext_tree.front().entries) {
+        if (entry.status.is_directory) {
             continue;
         }
 
-        const auto path = entry.physicalName.substr(patch_ext_path.size());
+        const auto path = DIR_SEP + entry.name;
         if (path.size() >= 5 && path.substr(path.size() - 5) == ".stub") {
             // Remove the corresponding file if exists
             const auto file_path = path.substr(0, path.size() - 5);
@@ -236,42 +315,56 @@ void LayeredFS::LoadExtRelocations() {
                 continue;
             }
 
-            FileUtil::IOFile patch_file(entry.physicalName, "rb");
-            if (!patch_file) {
-                LOG_ERROR(Service_FS, "LayeredFS Could not open file {}", entry.physicalName);
-                continue;
-            }
-
-            const auto size = patch_file.GetSize();
-            std::vector<u8> patch(size);
-            if (patch_file.ReadBytes(patch.data(), size) != size) {
-                LOG_ERROR(Service_FS, "LayeredFS Could not read file {}", entry.physicalName);
-                continue;
-            }
+            PatchJob job;
+            job.file = file_path_map[file_path];
+            job.patch_path = patch_ext_path + path.substr(1);
+            job.is_ips = extension == ".ips";
+            jobs.emplace_back(std::move(job));
+        } else {
+            LOG_WARNING(Service_FS, "LayeredFS unknown ext file {}", path);
+        }
+    }
 
-            auto& file = *file_path_map[file_path];
-            std::vector<u8> buffer(file.relocation.size); // Original size
-            romfs->ReadFile(file.relocation.original_offset, buffer.size(), buffer.data());
+    // Reading and applying the patches is independent for each file
+    pool.ParallelFor(jobs.size(), [this, &jobs](std::size_t i) {
+        auto& job = jobs[i];
+        FileUtil::IOFile patch_file(job.patch_path, "rb");
+        if (!patch_file) {
+            LOG_ERROR(Service_FS, "LayeredFS Could not open file {}", job.patch_path);
+            return;
+        }
 
-            bool ret = false;
-            if (extension == ".ips") {
-                ret = Patch::ApplyIpsPatch(patch, buffer);
-            } else {
-                ret = Patch::ApplyBpsPatch(patch, buffer);
-            }
+        const auto size = patch_file.GetSize();
+        std::vector<u8> patch(size);
+        if (patch_file.ReadBytes(patch.data(), size) != size) {
+            LOG_ERROR(Service_FS, "LayeredFS Could not read file {}", job.patch_path);
+            return;
+        }
 
-            if (ret) {
-                LOG_INFO(Service_FS, "LayeredFS patched file {}", file_path);
+        job.buffer.resize(job.file->relocation.size); // Original size
+        romfs->ReadFile(job.file->relocation.original_offset, job.buffer.size(),
+                        job.buffer.data());
 
-                file.relocation.type = 2;
-                file.relocation.size = buffer.size();
-                file.relocation.patched_file = std::move(buffer);
-            } else {
-                LOG_ERROR(Service_FS, "LayeredFS failed to patch file {}", file_path);
-            }
+        if (job.is_ips) {
+            job.success = Patch::ApplyIpsPatch(patch, job.buffer);
         } else {
-            LOG_WARNING(Service_FS, "LayeredFS unknown ext file {}", path);
+            job.success = Patch::ApplyBpsPatch(patch, job.buffer);
+        }
+        if (!job.success) {
+            LOG_ERROR(Service_FS, "LayeredFS failed to patch file {}", job.file->path);
         }
+    });
+
+    for (auto& job : jobs) {
+        // A stub may have removed the file after its patch was found
+        if (!job.success || job.file->relocation.type == 3) {
+            continue;
+        }
+        LOG_INFO(Service_FS, "LayeredFS patched file {}", job.file->path);
+
+        job.file->relocation.type = 2;
+        job.file->relocation.size = job.buffer.size();
+        job.file->relocation.patched_file = std::move(job.buffer);
     }
 }
 
@@ -489,6 +582,141 @@ void LayeredFS::RebuildMetadata() {
                 header.file_metadata_table.length);
 }
 
+u64 LayeredFS::GetCacheKey(const PatchTree& patch_tree, const PatchTree& patch_ext_tree) {
+    // The original metadata identifies the RomFS the layers are applied to
+    std::vector<u8> original_metadata(header.file_data_offset);
+    romfs->ReadFile(0, original_metadata.size(), original_metadata.data());
+
+    const u64 metadata_hash =
+        Common::ComputeHash64(original_metadata.data(), original_metadata.size());
+
+    std::string description = fmt::format("{:016X}|{}|{}|{}\n", metadata_hash, romfs->GetSize(),
+                                          patch_path, patch_ext_path);
+    for (const auto* tree : {&patch_tree, &patch_ext_tree}) {
+        for (const auto& directory : *tree) {
+            description += directory.path + '\n';
+            for (const auto& entry : directory.entries) {
+                description += fmt::format("{}|{}|{}|{}\n", entry.name, entry.status.is_directory,
+                                           entry.status.size, entry.status.modification_time);
+            }
+        }
+        description += '\n';
+    }
+    return Common::ComputeHash64(description.data(), description.size());
+}
+
+std::string LayeredFS::GetCachePath() const {
+    const std::string paths = patch_path + '|' + patch_ext_path;
+    return fmt::format("{}layered_fs" DIR_SEP "{:016X}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+                       Common::ComputeHash64(paths.data(), paths.size()));
+}
+
+template <typename Container>
+static bool WriteCacheBlob(FileUtil::IOFile& file, const Container& data) {
+    return file.WriteObject(static_cast<u64>(data.size())) == 1 &&
+           file.WriteBytes(data.data(), data.size()) == data.size();
+}
+
+template <typename Container>
+static bool ReadCacheBlob(FileUtil::IOFile& file, Container& data) {
+    u64 size;
+    if (file.ReadBytes(&size, sizeof(size)) != sizeof(size) || size > file.GetSize()) {
+        return false;
+    }
+    data.resize(static_cast<std::size_t>(size));
+    return file.ReadBytes(data.data(), data.size()) == data.size();
+}
+
+bool LayeredFS::LoadCache(u64 cache_key) {
+    const auto path = GetCachePath();
+    FileUtil::IOFile file(path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    u32 version{};
+    u64 key{};
+    if (file.ReadBytes(&version, sizeof(version)) != sizeof(version) ||
+        version != CacheVersion || file.ReadBytes(&key, sizeof(key)) != sizeof(key) ||
+        key != cache_key) {
+        LOG_DEBUG(Service_FS, "LayeredFS cache {} is out of date", path);
+        return false;
+    }
+
+    std::vector<u8> cached_metadata;
+    u64 data_size{};
+    u64 num_files{};
+    bool ok = ReadCacheBlob(file, cached_metadata) &&
+              file.ReadBytes(&data_size, sizeof(data_size)) == sizeof(data_size) &&
+              file.ReadBytes(&num_files, sizeof(num_files)) == sizeof(num_files);
+
+    std::vector<std::unique_ptr<File>> files;
+    std::map<u64, File*> offsets;
+    for (u64 i = 0; ok && i < num_files; ++i) {
+        auto cached_file = std::make_unique<File>();
+        auto& relocation = cached_file->relocation;
+        u64 data_offset{};
+        u32 type{};
+        ok = file.ReadBytes(&data_offset, sizeof(data_offset)) == sizeof(data_offset) &&
+             file.ReadBytes(&type, sizeof(type)) == sizeof(type) && type <= 2 &&
+             file.ReadBytes(&relocation.original_offset, sizeof(u64)) == sizeof(u64) &&
+             file.ReadBytes(&relocation.size, sizeof(u64)) == sizeof(u64) &&
+             ReadCacheBlob(file, cached_file->path) &&
+             ReadCacheBlob(file, relocation.replace_file_path) &&
+             (type != 2 || (ReadCacheBlob(file, relocation.patched_file) &&
+                            relocation.patched_file.size() == relocation.size));
+        relocation.type = static_cast<int>(type);
+        offsets.emplace(data_offset, cached_file.get());
+        files.emplace_back(std::move(cached_file));
+    }
+
+    if (!ok) {
+        LOG_WARNING(Service_FS, "LayeredFS cache {} is corrupted", path);
+        return false;
+    }
+
+    metadata = std::move(cached_metadata);
+    current_data_offset = data_size;
+    cached_files = std::move(files);
+    data_offset_map = std::move(offsets);
+    LOG_INFO(Service_FS, "LayeredFS loaded {} files from cache {}", cached_files.size(), path);
+    return true;
+}
+
+void LayeredFS::SaveCache(u64 cache_key) const {
+    const auto path = GetCachePath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_WARNING(Service_FS, "Could not create path for LayeredFS cache {}", path);
+        return;
+    }
+
+    FileUtil::IOFile file(path, "wb");
+    if (!file) {
+        LOG_WARNING(Service_FS, "Could not open LayeredFS cache {}", path);
+        return;
+    }
+
+    bool ok = file.WriteObject(CacheVersion) == 1 && file.WriteObject(cache_key) == 1 &&
+              WriteCacheBlob(file, metadata) && file.WriteObject(current_data_offset) == 1 &&
+              file.WriteObject(static_cast<u64>(data_offset_map.size())) == 1;
+    for (const auto& [data_offset, cached_file] : data_offset_map) {
+        const auto& relocation = cached_file->relocation;
+        ok = ok && file.WriteObject(data_offset) == 1 &&
+             file.WriteObject(static_cast<u32>(relocation.type)) == 1 &&
+             file.WriteObject(relocation.original_offset) == 1 &&
+             file.WriteObject(relocation.size) == 1 && WriteCacheBlob(file, cached_file->path) &&
+             WriteCacheBlob(file, relocation.replace_file_path) &&
+             (relocation.type != 2 || WriteCacheBlob(file, relocation.patched_file));
+    }
+
+    if (!ok) {
+        LOG_WARNING(Service_FS, "Could not write LayeredFS cache {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+}
+
 std::size_t LayeredFS::GetSize() const {
     return metadata.size() + current_data_offset;
 }
@@ -553,6 +781,37 @@ std::size_t LayeredFS::ReadFile(std::size_t offset, std::size_t length, u8* buff
     return read_size;
 }
 
+const u8* LayeredFS::GetSpan(std::size_t offset, std::size_t length) {
+    if (offset > GetSize() || length > GetSize() - offset) {
+        return nullptr;
+    }
+
+    if (offset < metadata.size()) {
+        return offset + length <= metadata.size() ? metadata.data() + offset : nullptr;
+    }
+    offset -= metadata.size();
+
+    // Only data within a single file is contiguous, the padding after it is not stored anywhere
+    auto current = data_offset_map.upper_bound(offset);
+    if (current == data_offset_map.begin()) {
+        return nullptr;
+    }
+    --current;
+    const auto relative_offset = offset - current->first;
+    const auto& relocation = current->second->relocation;
+    if (relative_offset + length > relocation.size) {
+        return nullptr;
+    }
+
+    if (relocation.type == 0) { // none
+        return romfs->GetSpan(relocation.original_offset + relative_offset, length);
+    }
+    if (relocation.type == 2) { // patch
+        return relocation.patched_file.data() + relative_offset;
+    }
+    return nullptr;
+}
+
 bool LayeredFS::ExtractDirectory(Directory& current, const std::string& target_path) {
     if (!FileUtil::CreateFullPath(target_path + current.path)) {
         LOG_ERROR(Service_FS, "Could not create path {}", target_path + current.path);
@@ -572,6 +831,16 @@ bool LayeredFS::ExtractDirectory(Directory& current, const std::string& target_p
             return false;
         }
 
+        // Write the file in one go if it can be accessed in place
+        const auto size = static_cast<std::size_t>(file->relocation.size);
+        if (const u8* data = romfs->GetSpan(file->relocation.original_offset, size)) {
+            if (target_file.WriteBytes(data, size) != size) {
+                LOG_ERROR(Service_FS, "Could not write to file {}", path);
+                return false;
+            }
+            continue;
+        }
+
         std::size_t written = 0;
         while (written < file->relocation.size) {
             const auto to_read =
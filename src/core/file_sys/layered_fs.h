@@ -14,9 +14,14 @@
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/string.hpp>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "common/swap.h"
 #include "core/file_sys/romfs_reader.h"
 
+namespace Common {
+class ThreadPool;
+}
+
 namespace FileSys {
 
 struct RomFSHeader {
@@ -41,6 +46,11 @@ static_assert(sizeof(RomFSHeader) == 0x28, "Size of RomFSHeader is not correct")
  * patch_ext_path: Path for RomFS extensions. Files present in this path:
  *  - When with an extension of ".stub", remove the corresponding file in the RomFS.
  *  - When with an extension of ".ips" or ".bps", patch the file in the RomFS.
+ *
+ * The rebuilt metadata and relocations are cached on disk, keyed by the contents of the original
+ * RomFS metadata and by the names, sizes and modification times of everything in the patch
+ * directories, so that unchanged mods don't need to be rebuilt at every boot. An instance loaded
+ * from the cache has no directory tree, so DumpRomFS is only supported without relocations.
  */
 class LayeredFS : public RomFSReader {
 public:
@@ -50,6 +60,7 @@ public:
 
     std::size_t GetSize() const override;
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer) override;
+    const u8* GetSpan(std::size_t offset, std::size_t length) override;
 
     bool DumpRomFS(const std::string& target_path);
 
@@ -63,6 +74,22 @@ private:
         Directory* parent;
     };
 
+    // A file or directory found while scanning a patch directory
+    struct PatchEntry {
+        std::string name;
+        FileUtil::FileStatus status;
+        std::size_t directory_index{}; // For directories, index of its PatchDirectory
+    };
+    struct PatchDirectory {
+        std::string path; // relative to the patch directory, with leading and trailing '/'
+        std::vector<PatchEntry> entries;
+    };
+    // Patch directory tree, the root directory comes first. Empty if the path does not exist
+    using PatchTree = std::vector<PatchDirectory>;
+
+    // Lists the whole patch directory tree, scanning each level of directories in parallel
+    static PatchTree ScanPatchDirectory(Common::ThreadPool& pool, const std::string& path);
+
     std::string ReadName(u32 offset, u32 name_length);
 
     // Loads the current directory, then its siblings, and then its children.
@@ -72,10 +99,11 @@ private:
     void LoadFile(Directory& parent, u32 offset);
 
     // Load replace/create relocations
-    void LoadRelocations();
+    void LoadRelocations(const PatchTree& patch_tree);
+    void LoadRelocations(const PatchTree& patch_tree, std::size_t directory_index);
 
-    // Load patch/remove relocations
-    void LoadExtRelocations();
+    // Load patch/remove relocations, applying the patches in parallel
+    void LoadExtRelocations(Common::ThreadPool& pool, const PatchTree& patch_ext_tree);
 
     // Calculate the offset of a single directory add it to the map and list of directories
     void PrepareBuildDirectory(Directory& current);
@@ -96,6 +124,14 @@ private:
 
     void RebuildMetadata();
 
+    // Computes the key the metadata cache is valid for
+    u64 GetCacheKey(const PatchTree& patch_tree, const PatchTree& patch_ext_tree);
+    std::string GetCachePath() const;
+
+    // Loads the metadata and relocations from the cache. Returns false if it is missing or stale
+    bool LoadCache(u64 cache_key);
+    void SaveCache(u64 cache_key) const;
+
     void Load();
 
     std::shared_ptr<RomFSReader> romfs;
@@ -108,6 +144,7 @@ private:
     std::unordered_map<std::string, File*> file_path_map;
     std::unordered_map<std::string, Directory*> directory_path_map;
     std::map<u64, File*> data_offset_map; // assigned data offset -> file
+    std::vector<std::unique_ptr<File>> cached_files; // files loaded from the metadata cache
     std::vector<u8> metadata;             // Includes header, hash table and metadata
 
     // Used for rebuilding header
@@ -123,6 +123,8 @@ Loader::ResultStatus NCCHContainer::OpenFile(const std::string& filepath, u32 nc
     this->filepath = filepath;
     this->ncch_offset = ncch_offset;
     file = FileUtil::IOFile(filepath, "rb");
+    image.reset();
+    image_mapping_failed = false;
 
     if (!file.IsOpen()) {
         LOG_WARNING(Service_FS, "Failed to open {}", filepath);
@@ -415,6 +417,7 @@ Loader::ResultStatus NCCHContainer::Load() {
             }
 
             exefs_file = FileUtil::IOFile(filepath, "rb");
+            exefs_in_image = true;
             has_exefs = true;
         }
 
@@ -448,6 +451,7 @@ Loader::ResultStatus NCCHContainer::LoadOverrides() {
         if (exefs_file.ReadBytes(&exefs_header, sizeof(ExeFs_Header)) == sizeof(ExeFs_Header)) {
             LOG_DEBUG(Service_FS, "Loading ExeFS section from {}", exefs_override);
             exefs_offset = 0;
+            exefs_in_image = false;
             is_tainted = true;
             has_exefs = true;
         } else {
@@ -524,27 +528,40 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                                                               exefs_ctr.data());
             dec.Seek(section.offset + sizeof(ExeFs_Header));
 
+            // Unencrypted sections of the container file are used in place, without copying them
+            // into a temporary buffer first
+            const u8* section_data = nullptr;
+            if (exefs_in_image && !is_encrypted) {
+                section_data = GetImageSpan(section_offset, section.size);
+            }
+
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
-                // Section is compressed, read compressed .code section...
                 std::unique_ptr<u8[]> temp_buffer;
-                try {
-                    temp_buffer.reset(new u8[section.size]);
-                } catch (std::bad_alloc&) {
-                    return Loader::ResultStatus::ErrorMemoryAllocationFailed;
-                }
+                const u8* compressed = section_data;
+                if (compressed == nullptr) {
+                    // Section is compressed, read compressed .code section...
+                    try {
+                        temp_buffer.reset(new u8[section.size]);
+                    } catch (std::bad_alloc&) {
+                        return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+                    }
 
-                if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
+                    if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
+                        return Loader::ResultStatus::Error;
 
-                if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                    if (is_encrypted) {
+                        dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                    }
+                    compressed = temp_buffer.get();
                 }
 
                 // Decompress .code section...
-                u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
+                u32 decompressed_size = LZSS_GetDecompressedSize(compressed, section.size);
                 buffer.resize(decompressed_size);
-                if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
+                if (!LZSS_Decompress(compressed, section.size, &buffer[0], decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
+            } else if (section_data != nullptr) {
+                buffer.assign(section_data, section_data + section.size);
             } else {
                 // Section is uncompressed...
                 buffer.resize(section.size);
@@ -561,6 +578,17 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
     return Loader::ResultStatus::ErrorNotUsed;
 }
 
+const u8* NCCHContainer::GetImageSpan(u64 offset, std::size_t length) {
+    if (!image && !image_mapping_failed) {
+        image = std::make_unique<FileUtil::MappedFile>(filepath);
+        if (!image->IsOpen()) {
+            image.reset();
+            image_mapping_failed = true;
+        }
+    }
+    return image ? image->GetSpan(offset, length) : nullptr;
+}
+
 Loader::ResultStatus NCCHContainer::ApplyCodePatch(std::vector<u8>& code) const {
     struct PatchLocation {
         std::string path;
@@ -336,9 +336,17 @@ private:
     u32 ncch_offset = 0; // Offset to NCCH header, can be 0 for NCCHs or non-zero for CIAs/NCSDs
     u32 exefs_offset = 0;
 
+    /// Returns a pointer to part of the container file mapped into memory, mapping it on first
+    /// use. Returns nullptr if the file can't be mapped or the range is outside it.
+    const u8* GetImageSpan(u64 offset, std::size_t length);
+
     std::string filepath;
     FileUtil::IOFile file;
     FileUtil::IOFile exefs_file;
+    bool exefs_in_image = false; // Is the ExeFS read from the container file itself?
+
+    std::unique_ptr<FileUtil::MappedFile> image;
+    bool image_mapping_failed = false;
 };
 
 } // namespace FileSys
@@ -1,20 +1,126 @@
 #include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include "common/archives.h"
+#include "common/logging/log.h"
 #include "core/file_sys/romfs_reader.h"
+#include "core/settings.h"
 
 SERIALIZE_EXPORT_IMPL(FileSys::DirectRomFSReader)
 
 namespace FileSys {
 
+/// Read-ahead window when a sequential stream of reads is first detected, in blocks
+constexpr std::size_t MinReadAheadBlocks = 4;
+/// Largest read-ahead window, in blocks
+constexpr std::size_t MaxReadAheadBlocks = 64;
+
+static std::size_t GetConfiguredCacheCapacity() {
+    const int size_mb = std::max(Settings::values.romfs_cache_size, 0);
+    return static_cast<std::size_t>(size_mb) * 1024 * 1024 / DirectRomFSReader::BlockSize;
+}
+
+DirectRomFSReader::DirectRomFSReader() : cache_capacity(GetConfiguredCacheCapacity()) {}
+
+DirectRomFSReader::DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset,
+                                     std::size_t data_size)
+    : is_encrypted(false), file(std::move(file)), file_offset(file_offset), data_size(data_size),
+      cache_capacity(GetConfiguredCacheCapacity()) {
+    MapFile();
+}
+
+DirectRomFSReader::DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset,
+                                     std::size_t data_size, const std::array<u8, 16>& key,
+                                     const std::array<u8, 16>& ctr, std::size_t crypto_offset)
+    : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
+      crypto_offset(crypto_offset), data_size(data_size),
+      cache_capacity(GetConfiguredCacheCapacity()) {}
+
+DirectRomFSReader::~DirectRomFSReader() {
+    if (cache_stats.hits != 0 || cache_stats.misses != 0) {
+        LOG_DEBUG(Service_FS, "RomFS block cache: {} hits, {} misses", cache_stats.hits,
+                  cache_stats.misses);
+    }
+}
+
+void DirectRomFSReader::MapFile() {
+    mapping.reset();
+    if (is_encrypted || !file.IsOpen()) {
+        return;
+    }
+
+    auto mapped_file = std::make_unique<FileUtil::MappedFile>(file.GetFilename());
+    if (mapped_file->GetSpan(file_offset, static_cast<std::size_t>(data_size)) != nullptr) {
+        mapping = std::move(mapped_file);
+    }
+}
+
+const u8* DirectRomFSReader::GetSpan(std::size_t offset, std::size_t length) {
+    if (!mapping || offset > data_size || length > data_size - offset) {
+        return nullptr;
+    }
+    return mapping->GetData() + file_offset + offset;
+}
+
+void DirectRomFSReader::SetCacheCapacity(std::size_t num_blocks) {
+    std::lock_guard lock{mutex};
+    cache_capacity = num_blocks;
+    while (blocks.size() > cache_capacity) {
+        block_map.erase(blocks.back().index);
+        blocks.pop_back();
+    }
+}
+
 std::size_t DirectRomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
-    if (length == 0)
+    if (length == 0 || offset >= data_size)
         return 0; // Crypto++ does not like zero size buffer
+    const std::size_t read_length = std::min(length, static_cast<std::size_t>(data_size) - offset);
+
+    if (mapping) {
+        std::memcpy(buffer, mapping->GetData() + file_offset + offset, read_length);
+        return read_length;
+    }
+
+    std::lock_guard lock{mutex};
+
+    // Unencrypted data is read straight into the buffer, there is nothing to save by caching it
+    if (!is_encrypted || cache_capacity == 0) {
+        return ReadUncached(offset, read_length, buffer);
+    }
+
+    if (offset == next_sequential_offset) {
+        const std::size_t max_read_ahead = std::min(MaxReadAheadBlocks, cache_capacity / 2);
+        read_ahead_blocks = std::min(std::max(read_ahead_blocks * 2, MinReadAheadBlocks),
+                                     max_read_ahead);
+    } else {
+        read_ahead_blocks = 0;
+    }
+
+    const u64 last_index = (offset + read_length - 1) / BlockSize;
+    std::size_t copied = 0;
+    while (copied < read_length) {
+        const std::size_t position = offset + copied;
+        const Block* block = GetBlock(position / BlockSize, last_index);
+        const std::size_t block_offset = position % BlockSize;
+        if (!block || block->data.size() <= block_offset) {
+            break;
+        }
+        const std::size_t amount =
+            std::min(read_length - copied, block->data.size() - block_offset);
+        std::memcpy(buffer + copied, block->data.data() + block_offset, amount);
+        copied += amount;
+    }
+
+    next_sequential_offset = offset + copied;
+    return copied;
+}
+
+std::size_t DirectRomFSReader::ReadUncached(std::size_t offset, std::size_t length, u8* buffer) {
     file.Seek(file_offset + offset, SEEK_SET);
-    std::size_t read_length = std::min(length, static_cast<std::size_t>(data_size) - offset);
-    read_length = file.ReadBytes(buffer, read_length);
-    if (is_encrypted) {
+    const std::size_t read_length = file.ReadBytes(buffer, length);
+    if (is_encrypted && read_length != 0) {
         CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
         d.Seek(crypto_offset + offset);
         d.ProcessData(buffer, buffer, read_length);
@@ -22,4 +128,63 @@ std::size_t DirectRomFSReader::ReadFile(std::size_t offset, std::size_t length,
     return read_length;
 }
 
+const DirectRomFSReader::Block* DirectRomFSReader::GetBlock(u64 index, u64 last_index) {
+    const auto iter = block_map.find(index);
+    if (iter != block_map.end()) {
+        ++cache_stats.hits;
+        blocks.splice(blocks.begin(), blocks, iter->second);
+        return &*iter->second;
+    }
+
+    // Read the requested blocks that aren't cached yet in one go, continuing into the read-ahead
+    // window, and stopping early at the first block that is already cached.
+    const u64 num_blocks_total = (data_size + BlockSize - 1) / BlockSize;
+    const u64 end_index = std::min<u64>(
+        {std::max(last_index + 1, index + 1) + read_ahead_blocks, num_blocks_total,
+         index + cache_capacity});
+    u64 run_end = index + 1;
+    while (run_end < end_index && block_map.count(run_end) == 0) {
+        ++run_end;
+    }
+
+    const std::size_t run_offset = static_cast<std::size_t>(index * BlockSize);
+    const std::size_t run_length =
+        std::min(static_cast<std::size_t>(run_end - index) * BlockSize,
+                 static_cast<std::size_t>(data_size) - run_offset);
+    read_buffer.resize(run_length);
+    file.Seek(file_offset + run_offset, SEEK_SET);
+    const std::size_t read_length = file.ReadBytes(read_buffer.data(), run_length);
+    if (read_length == 0) {
+        return nullptr;
+    }
+
+    // A single cipher instance decrypts the whole run, since the key stream continues from one
+    // block to the next.
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
+    d.Seek(crypto_offset + run_offset);
+
+    for (std::size_t pos = 0; pos < read_length; pos += BlockSize) {
+        const std::size_t size = std::min(BlockSize, read_length - pos);
+        ++cache_stats.misses;
+
+        // Reuse the storage of the least recently used block once the cache is full
+        if (blocks.size() >= cache_capacity) {
+            block_map.erase(blocks.back().index);
+            blocks.splice(blocks.begin(), blocks, std::prev(blocks.end()));
+        } else {
+            blocks.emplace_front();
+        }
+
+        Block& block = blocks.front();
+        block.index = index + pos / BlockSize;
+        block.data.resize(size);
+        d.ProcessData(block.data.data(), read_buffer.data() + pos, size);
+        block_map.emplace(block.index, blocks.begin());
+    }
+
+    // The requested block was inserted first, and the run is never larger than the cache, so it
+    // is still there.
+    return &*block_map.at(index);
+}
+
 } // namespace FileSys
@@ -1,6 +1,11 @@
 #pragma once
 
 #include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/export.hpp>
@@ -19,6 +24,16 @@ public:
     virtual std::size_t GetSize() const = 0;
     virtual std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer) = 0;
 
+    /**
+     * Returns a pointer through which length bytes of data at offset can be read in place, without
+     * copying them out with ReadFile. Returns nullptr if the data isn't available that way, for
+     * example because it has to be decrypted or is assembled from several sources. The pointer
+     * stays valid as long as the reader does.
+     */
+    virtual const u8* GetSpan(std::size_t offset, std::size_t length) {
+        return nullptr;
+    }
+
 private:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int file_version) {}
@@ -27,20 +42,36 @@ private:
 
 /**
  * A RomFS reader that directly reads the RomFS file.
+ *
+ * Encrypted RomFS data is decrypted in fixed size blocks which are kept in a bounded LRU cache, so
+ * that small scattered reads don't each pay for setting up the cipher and decrypting. Misses that
+ * continue a sequential stream of reads also fetch the following blocks, with a read-ahead window
+ * that grows while the stream continues.
+ *
+ * Unencrypted RomFS data is read through a memory mapping of the file when possible, so it can be
+ * accessed in place with GetSpan.
+ *
+ * Readers are shared by every file opened on an archive, so reads are serialized internally.
  */
 class DirectRomFSReader : public RomFSReader {
 public:
-    DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size)
-        : is_encrypted(false), file(std::move(file)), file_offset(file_offset),
-          data_size(data_size) {}
+    /// Size of a cached block of decrypted data, in bytes
+    static constexpr std::size_t BlockSize = 0x4000;
+
+    struct CacheStats {
+        /// Number of blocks that were served from the cache
+        u64 hits = 0;
+        /// Number of blocks that had to be read and decrypted
+        u64 misses = 0;
+    };
+
+    DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size);
 
     DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
                       const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
-                      std::size_t crypto_offset)
-        : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
-          crypto_offset(crypto_offset), data_size(data_size) {}
+                      std::size_t crypto_offset);
 
-    ~DirectRomFSReader() override = default;
+    ~DirectRomFSReader() override;
 
     std::size_t GetSize() const override {
         return data_size;
@@ -48,7 +79,34 @@ public:
 
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer) override;
 
+    const u8* GetSpan(std::size_t offset, std::size_t length) override;
+
+    /// Sets the maximum number of decrypted blocks to keep, dropping blocks over the new limit.
+    void SetCacheCapacity(std::size_t num_blocks);
+
+    CacheStats GetCacheStats() const {
+        return cache_stats;
+    }
+
 private:
+    struct Block {
+        u64 index;
+        std::vector<u8> data;
+    };
+
+    /// Maps the file into memory, if the data is unencrypted and the host allows it.
+    void MapFile();
+
+    /// Reads data from the file and decrypts it if necessary, bypassing the cache.
+    std::size_t ReadUncached(std::size_t offset, std::size_t length, u8* buffer);
+
+    /**
+     * Returns the cached block with the given index, reading it and any uncached blocks after it
+     * up to last_index (plus the read-ahead window) on a miss. Returns nullptr if the block
+     * couldn't be read.
+     */
+    const Block* GetBlock(u64 index, u64 last_index);
+
     bool is_encrypted;
     FileUtil::IOFile file;
     std::array<u8, 16> key;
@@ -57,7 +115,25 @@ private:
     u64 crypto_offset;
     u64 data_size;
 
-    DirectRomFSReader() = default;
+    std::mutex mutex;
+
+    /// Mapping of the whole file, only used for unencrypted data
+    std::unique_ptr<FileUtil::MappedFile> mapping;
+
+    /// Cached blocks, most recently used first
+    std::list<Block> blocks;
+    std::unordered_map<u64, std::list<Block>::iterator> block_map;
+    std::size_t cache_capacity = 0;
+    CacheStats cache_stats;
+    /// Encrypted data of the blocks being read on a miss
+    std::vector<u8> read_buffer;
+
+    /// Offset right after the end of the previous read, to detect sequential access
+    std::size_t next_sequential_offset = 0;
+    /// Number of blocks to read past the requested ones on a sequential miss
+    std::size_t read_ahead_blocks = 0;
+
+    DirectRomFSReader();
 
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
@@ -69,6 +145,9 @@ private:
         ar& file_offset;
         ar& crypto_offset;
         ar& data_size;
+        if (Archive::is_loading::value) {
+            MapFile();
+        }
     }
     friend class boost::serialization::access;
 };
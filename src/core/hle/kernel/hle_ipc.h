@@ -132,6 +132,14 @@ public:
     // interface for service
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
+
+    /**
+     * Returns a host pointer to part of the buffer, for services that can fill or consume it in
+     * place. Returns nullptr if that part is out of bounds or isn't plain memory laid out
+     * contiguously on the host, in which case Read and Write have to be used instead.
+     */
+    u8* GetContiguousPointer(std::size_t offset, std::size_t size);
+
     std::size_t GetSize() const {
         return size;
     }
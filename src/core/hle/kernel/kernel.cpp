@@ -104,6 +104,10 @@ void KernelSystem::SetRunningCPU(ARM_Interface* cpu) {
     }
 }
 
+ARM_Interface* KernelSystem::GetRunningCPU() const {
+    return current_cpu;
+}
+
 ThreadManager& KernelSystem::GetThreadManager(u32 core_id) {
     return *thread_managers[core_id];
 }
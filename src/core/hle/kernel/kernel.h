@@ -219,6 +219,7 @@ public:
     void SetCPUs(std::vector<std::shared_ptr<ARM_Interface>> cpu);
 
     void SetRunningCPU(ARM_Interface* cpu);
+    ARM_Interface* GetRunningCPU() const;
 
     ThreadManager& GetThreadManager(u32 core_id);
     const ThreadManager& GetThreadManager(u32 core_id) const;
@@ -1138,11 +1138,13 @@ public:
         : file(std::move(file)), file_offset(offset), file_size(size) {}
 
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override {
+        file->WaitForIO();
         return file->backend->Read(offset + file_offset, length, buffer);
     }
 
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override {
+        file->WaitForIO();
         return file->backend->Write(offset + file_offset, length, flush, buffer);
     }
 
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/unique_ptr.hpp>
 #include "common/archives.h"
 #include "common/logging/log.h"
@@ -14,12 +16,84 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/service/fs/file.h"
+#include "core/hle/service/fs/file_io_thread.h"
+#include "core/settings.h"
 
 SERIALIZE_EXPORT_IMPL(Service::FS::File)
 SERIALIZE_EXPORT_IMPL(Service::FS::FileSessionSlot)
+SERIALIZE_EXPORT_IMPL(Service::FS::File::ReadCallback)
 
 namespace Service::FS {
 
+/// Largest bounce buffer kept allocated between requests
+constexpr std::size_t MaxPooledBounceBufferSize = 1024 * 1024;
+
+/// Largest read that is prefetched when a file is read sequentially
+constexpr std::size_t MaxPrefetchLength = 1024 * 1024;
+
+/// Replies to a read that was queued on the I/O thread once the client thread wakes up.
+class File::ReadCallback : public Kernel::HLERequestContext::WakeupCallback {
+public:
+    ReadCallback(std::shared_ptr<File> file, std::shared_ptr<FileIORequest> request, u64 offset,
+                 std::size_t length)
+        : file(std::move(file)), request(std::move(request)), offset(offset), length(length) {}
+
+    void WakeUp(std::shared_ptr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                Kernel::ThreadWakeupReason reason) override {
+        IPC::RequestParser rp(ctx, 0x0802, 3, 2);
+        rp.Skip(3, false);
+        auto& buffer = rp.PopMappedBuffer();
+        IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
+
+        ResultVal<std::size_t> read;
+        if (request) {
+            // Usually the read completed while the client was asleep, so this doesn't block
+            request->Wait();
+            read = request->result;
+            if (read.Succeeded()) {
+                // A prefetched read can be longer than the one that ended up using it
+                const std::size_t read_length = std::min(*read, length);
+                buffer.Write(request->data.data(), 0, read_length);
+                read = MakeResult<std::size_t>(read_length);
+            }
+        } else {
+            // Queued reads don't survive savestates, so the read is redone after loading one
+            file->WaitForIO();
+            std::vector<u8> data(length);
+            read = file->backend->Read(offset, length, data.data());
+            if (read.Succeeded()) {
+                buffer.Write(data.data(), 0, *read);
+            }
+        }
+
+        if (read.Failed()) {
+            rb.Push(read.Code());
+            rb.Push<u32>(0);
+        } else {
+            rb.Push(RESULT_SUCCESS);
+            rb.Push<u32>(static_cast<u32>(*read));
+        }
+        rb.PushMappedBuffer(buffer);
+    }
+
+private:
+    std::shared_ptr<File> file;
+    std::shared_ptr<FileIORequest> request;
+    u64 offset;
+    std::size_t length;
+
+    ReadCallback() = default;
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        ar& boost::serialization::base_object<Kernel::HLERequestContext::WakeupCallback>(*this);
+        ar& file;
+        ar& offset;
+        ar& length;
+    }
+    friend class boost::serialization::access;
+};
+
 template <class Archive>
 void File::serialize(Archive& ar, const unsigned int) {
     ar& boost::serialization::base_object<Kernel::SessionRequestHandler>(*this);
@@ -53,6 +127,10 @@ File::File(Kernel::KernelSystem& kernel)
     RegisterHandlers(functions);
 }
 
+File::~File() {
+    WaitForIO();
+}
+
 void File::Read(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0802, 3, 2);
     u64 offset = rp.Pop<u64>();
@@ -76,21 +154,48 @@ void File::Read(Kernel::HLERequestContext& ctx) {
                   offset, length, backend->GetSize());
     }
 
+    const std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
+
+    if (Settings::values.use_async_file_io && backend->AllowsAsyncRead() &&
+        read_timeout_ns.count() > 0) {
+        // Service the read on the I/O thread while the client sleeps, and reply when it wakes up
+        std::shared_ptr<FileIORequest> request = TakePrefetchedRead(offset, length);
+        if (!request) {
+            request = QueueRead(offset, length);
+        }
+        if (offset == next_sequential_offset && length <= MaxPrefetchLength &&
+            offset + length < backend->GetSize()) {
+            prefetched_read = QueueRead(offset + length, length);
+        }
+        next_sequential_offset = offset + length;
+
+        ctx.SleepClientThread(
+            "file::read", read_timeout_ns,
+            std::make_shared<ReadCallback>(std::static_pointer_cast<File>(shared_from_this()),
+                                           std::move(request), offset, length));
+        return;
+    }
+
+    WaitForIO();
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
+    // Read straight into the client's buffer when possible, to avoid an extra copy
+    u8* const dest = buffer.GetContiguousPointer(0, length);
+    u8* const data = dest ? dest : GetBounceBuffer(length);
+    ResultVal<std::size_t> read = backend->Read(offset, length, data);
     if (read.Failed()) {
         rb.Push(read.Code());
         rb.Push<u32>(0);
     } else {
-        buffer.Write(data.data(), 0, *read);
+        if (!dest) {
+            buffer.Write(data, 0, *read);
+        }
         rb.Push(RESULT_SUCCESS);
         rb.Push<u32>(static_cast<u32>(*read));
     }
     rb.PushMappedBuffer(buffer);
+    TrimBounceBuffer();
 
-    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
     ctx.SleepClientThread("file::read", read_timeout_ns, nullptr);
 }
 
@@ -115,9 +220,17 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    WaitForIO();
+    prefetched_read.reset();
+
+    const u8* data = buffer.GetContiguousPointer(0, length);
+    if (!data) {
+        u8* const bounce = GetBounceBuffer(length);
+        buffer.Read(bounce, 0, length);
+        data = bounce;
+    }
+    ResultVal<std::size_t> written = backend->Write(offset, length, flush != 0, data);
+    TrimBounceBuffer();
 
     // Update file size
     file->size = backend->GetSize();
@@ -132,6 +245,45 @@ void File::Write(Kernel::HLERequestContext& ctx) {
     rb.PushMappedBuffer(buffer);
 }
 
+u8* File::GetBounceBuffer(std::size_t size) {
+    if (bounce_buffer.size() < size) {
+        bounce_buffer.resize(size);
+    }
+    return bounce_buffer.data();
+}
+
+void File::TrimBounceBuffer() {
+    if (bounce_buffer.size() > MaxPooledBounceBufferSize) {
+        bounce_buffer.clear();
+        bounce_buffer.shrink_to_fit();
+    }
+}
+
+void File::WaitForIO() {
+    if (last_queued_read) {
+        last_queued_read->Wait();
+        last_queued_read.reset();
+    }
+}
+
+std::shared_ptr<FileIORequest> File::QueueRead(u64 offset, std::size_t length) {
+    last_queued_read = GetFileIOThread().Read(*backend, offset, length);
+    return last_queued_read;
+}
+
+std::shared_ptr<FileIORequest> File::TakePrefetchedRead(u64 offset, std::size_t length) {
+    std::shared_ptr<FileIORequest> request = std::move(prefetched_read);
+    prefetched_read.reset();
+    if (!request) {
+        return nullptr;
+    }
+    if (request->GetOffset() == offset && request->GetLength() >= length) {
+        return request;
+    }
+    request->Cancel();
+    return nullptr;
+}
+
 void File::GetSize(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0804, 0, 0);
 
@@ -156,6 +308,9 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    WaitForIO();
+    prefetched_read.reset();
+
     file->size = size;
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
@@ -169,6 +324,7 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but {} clients still connected",
                     connected_sessions.size());
 
+    WaitForIO();
     backend->Close();
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -187,6 +343,7 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    WaitForIO();
     backend->Flush();
     rb.Push(RESULT_SUCCESS);
 }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <boost/serialization/base_object.hpp>
 #include "core/file_sys/archive_backend.h"
 #include "core/global.h"
@@ -16,6 +17,8 @@ class System;
 
 namespace Service::FS {
 
+class FileIORequest;
+
 struct FileSessionSlot : public Kernel::SessionRequestHandler::SessionDataBase {
     u32 priority; ///< Priority of the file. TODO(Subv): Find out what this means
     u64 offset;   ///< Offset that this session will start reading from.
@@ -41,7 +44,7 @@ class File final : public ServiceFramework<File, FileSessionSlot> {
 public:
     File(Kernel::KernelSystem& kernel, std::unique_ptr<FileSys::FileBackend>&& backend,
          const FileSys::Path& path);
-    ~File() = default;
+    ~File();
 
     std::string GetName() const {
         return "Path: " + path.DebugStr();
@@ -61,6 +64,12 @@ public:
     // OpenSubFile.
     std::size_t GetSessionFileSize(std::shared_ptr<Kernel::ServerSession> session);
 
+    /// Waits for the reads of this file queued on the I/O thread to complete. The backend must
+    /// not be used directly while any are pending.
+    void WaitForIO();
+
+    class ReadCallback;
+
 private:
     void Read(Kernel::HLERequestContext& ctx);
     void Write(Kernel::HLERequestContext& ctx);
@@ -73,8 +82,31 @@ private:
     void OpenLinkFile(Kernel::HLERequestContext& ctx);
     void OpenSubFile(Kernel::HLERequestContext& ctx);
 
+    /// Returns a scratch buffer of at least the given size, for transfers to client buffers that
+    /// can't be accessed in place.
+    u8* GetBounceBuffer(std::size_t size);
+
+    /// Frees the scratch buffer if a transfer has grown it beyond the size worth keeping around.
+    void TrimBounceBuffer();
+
+    /// Queues a read of the backend on the I/O thread.
+    std::shared_ptr<FileIORequest> QueueRead(u64 offset, std::size_t length);
+
+    /// Returns the prefetched read if it covers the given range, and discards it otherwise.
+    std::shared_ptr<FileIORequest> TakePrefetchedRead(u64 offset, std::size_t length);
+
     Kernel::KernelSystem& kernel;
 
+    std::vector<u8> bounce_buffer;
+
+    /// The most recently queued read. The I/O thread services reads in order, so once this one
+    /// has completed, all of them have.
+    std::shared_ptr<FileIORequest> last_queued_read;
+    /// A read of the data following the last one, queued in anticipation of sequential access
+    std::shared_ptr<FileIORequest> prefetched_read;
+    /// End of the last read, to detect sequential access
+    u64 next_sequential_offset = 0;
+
     File(Kernel::KernelSystem& kernel);
     File();
 
@@ -87,3 +119,4 @@ private:
 
 BOOST_CLASS_EXPORT_KEY(Service::FS::FileSessionSlot)
 BOOST_CLASS_EXPORT_KEY(Service::FS::File)
+BOOST_CLASS_EXPORT_KEY(Service::FS::File::ReadCallback)
@@ -0,0 +1,84 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/file_sys/file_backend.h"
+#include "core/hle/service/fs/file_io_thread.h"
+
+MICROPROFILE_DEFINE(Service_FS_IORead, "Service", "FS I/O Read", MP_RGB(100, 160, 220));
+
+namespace Service::FS {
+
+FileIORequest::FileIORequest(FileSys::FileBackend& backend, u64 offset, std::size_t length)
+    : backend(backend), offset(offset), length(length) {}
+
+void FileIORequest::Wait() {
+    std::unique_lock lock{mutex};
+    done_cv.wait(lock, [this] { return done; });
+}
+
+void FileIORequest::Run() {
+    if (!cancelled) {
+        MICROPROFILE_SCOPE(Service_FS_IORead);
+        data.resize(length);
+        result = backend.Read(offset, length, data.data());
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        done = true;
+    }
+    done_cv.notify_all();
+}
+
+FileIOThread::FileIOThread() : thread([this] { ThreadLoop(); }) {}
+
+FileIOThread::~FileIOThread() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    queue_cv.notify_one();
+    thread.join();
+}
+
+std::shared_ptr<FileIORequest> FileIOThread::Read(FileSys::FileBackend& backend, u64 offset,
+                                                  std::size_t length) {
+    auto request = std::make_shared<FileIORequest>(backend, offset, length);
+    {
+        std::lock_guard lock{mutex};
+        queue.push_back(request);
+    }
+    queue_cv.notify_one();
+    return request;
+}
+
+void FileIOThread::ThreadLoop() {
+    Common::SetCurrentThreadName("FS I/O");
+    MicroProfileOnThreadCreate("FS I/O");
+
+    while (true) {
+        std::shared_ptr<FileIORequest> request;
+        {
+            std::unique_lock lock{mutex};
+            queue_cv.wait(lock, [this] { return stop || !queue.empty(); });
+            if (queue.empty()) {
+                break;
+            }
+            request = std::move(queue.front());
+            queue.pop_front();
+        }
+        request->Run();
+    }
+
+    MicroProfileOnThreadExit();
+}
+
+FileIOThread& GetFileIOThread() {
+    static FileIOThread io_thread;
+    return io_thread;
+}
+
+} // namespace Service::FS
@@ -0,0 +1,92 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/result.h"
+
+namespace FileSys {
+class FileBackend;
+}
+
+namespace Service::FS {
+
+/// A read from a file backend that is serviced on the FS I/O thread.
+class FileIORequest {
+public:
+    FileIORequest(FileSys::FileBackend& backend, u64 offset, std::size_t length);
+
+    u64 GetOffset() const {
+        return offset;
+    }
+
+    std::size_t GetLength() const {
+        return length;
+    }
+
+    /// Blocks until the request has been serviced. Returns immediately if it already has been.
+    void Wait();
+
+    /// Tells the I/O thread to skip the request if it hasn't started servicing it yet.
+    void Cancel() {
+        cancelled = true;
+    }
+
+    /// The result of the backend read. Only valid once Wait has returned.
+    ResultVal<std::size_t> result;
+    /// The data that was read. Only valid once Wait has returned.
+    std::vector<u8> data;
+
+private:
+    friend class FileIOThread;
+
+    void Run();
+
+    FileSys::FileBackend& backend;
+    u64 offset;
+    std::size_t length;
+    std::atomic<bool> cancelled{false};
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    bool done = false;
+};
+
+/**
+ * A host thread that services file reads in the order they are queued, so that the emulation
+ * thread doesn't stall on slow storage. Requests read into their own buffer; copying the data to
+ * guest memory is left to the emulation thread.
+ */
+class FileIOThread : NonCopyable {
+public:
+    FileIOThread();
+    ~FileIOThread();
+
+    /// Queues a read from backend, which must stay alive until the request has completed.
+    std::shared_ptr<FileIORequest> Read(FileSys::FileBackend& backend, u64 offset,
+                                        std::size_t length);
+
+private:
+    void ThreadLoop();
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable queue_cv;
+    std::deque<std::shared_ptr<FileIORequest>> queue;
+    bool stop = false;
+};
+
+/// Returns the I/O thread shared by all files, starting it on first use.
+FileIOThread& GetFileIOThread();
+
+} // namespace Service::FS
@@ -7,12 +7,22 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/video_core.h"
 
 namespace Service::GSP {
 
 static std::weak_ptr<GSP_GPU> gsp_gpu;
 
 void SignalInterrupt(InterruptId interrupt_id) {
+    // Kernel objects may only be touched from the emulation thread, so interrupts raised by the
+    // asynchronous GPU thread are delivered once the emulation thread synchronizes with it
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        VideoCore::g_gpu_thread->DeferToEmuThread(
+            [interrupt_id] { SignalInterrupt(interrupt_id); });
+        return;
+    }
+
     auto gpu = gsp_gpu.lock();
     ASSERT(gpu != nullptr);
     return gpu->SignalInterrupt(interrupt_id);
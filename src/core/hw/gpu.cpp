@@ -20,6 +20,7 @@
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -386,6 +387,37 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
+/**
+ * Executes a GPU operation. When asynchronous GPU emulation is enabled the operation is queued to
+ * the GPU thread, otherwise it runs immediately on the calling thread.
+ */
+template <typename Func>
+static void ExecuteGPUCommand(Func&& func) {
+    auto* gpu_thread = VideoCore::g_gpu_thread.get();
+    // The hardware renderer has to run on the thread owning the graphics context
+    if (gpu_thread && !VideoCore::g_hw_renderer_enabled) {
+        gpu_thread->PushCommand(std::forward<Func>(func));
+        return;
+    }
+    if (gpu_thread) {
+        gpu_thread->WaitIdle();
+    }
+    func();
+}
+
+/**
+ * Updates the registers of a finished GPU operation. The emulation thread accesses the registers
+ * without synchronization, so like interrupts, updates made on the GPU thread are deferred to it.
+ */
+template <typename Func>
+static void UpdateRegsAfterGPUCommand(Func&& update) {
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        VideoCore::g_gpu_thread->DeferToEmuThread(std::forward<Func>(update));
+        return;
+    }
+    update();
+}
+
 template <typename T>
 inline void Write(u32 addr, const T data) {
     addr -= HW::VADDR_GPU;
@@ -408,60 +440,69 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+            ExecuteGPUCommand([config = Regs::MemoryFillConfig{config}, is_second_filler] {
+                MemoryFill(config);
+                LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}",
+                          config.GetStartAddress(), config.GetEndAddress());
+
+                // Reset "trigger" flag and set the "finish" flag once the fill is done
+                // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+                UpdateRegsAfterGPUCommand([is_second_filler] {
+                    auto& fill_config = g_regs.memory_fill_config[is_second_filler];
+                    fill_config.trigger.Assign(0);
+                    fill_config.finished.Assign(1);
+                });
+
+                // It seems that it won't signal interrupt if "address_start" is zero.
+                // TODO: hwtest this
+                if (config.GetStartAddress() != 0) {
+                    if (!is_second_filler) {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                    } else {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                    }
                 }
-            }
-
-            // Reset "trigger" flag and set the "finish" flag
-            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
-            config.trigger.Assign(0);
-            config.finished.Assign(1);
+            });
         }
         break;
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
-
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
+            ExecuteGPUCommand([config = Regs::DisplayTransferConfig{config}] {
+                MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+                if (Pica::g_debug_context)
+                    Pica::g_debug_context->OnEvent(
+                        Pica::DebugContext::Event::IncomingDisplayTransfer, nullptr);
+
+                if (config.is_texture_copy) {
+                    TextureCopy(config);
+                    LOG_TRACE(HW_GPU,
+                              "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                              "{:#010X}({}+{}), flags {:#010X}",
+                              config.texture_copy.size, config.GetPhysicalInputAddress(),
+                              config.texture_copy.input_width * 16,
+                              config.texture_copy.input_gap * 16,
+                              config.GetPhysicalOutputAddress(),
+                              config.texture_copy.output_width * 16,
+                              config.texture_copy.output_gap * 16, config.flags);
+                } else {
+                    DisplayTransfer(config);
+                    LOG_TRACE(HW_GPU,
+                              "DisplayTransfer: {:#010X}({}x{})-> "
+                              "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                              config.GetPhysicalInputAddress(), config.input_width.Value(),
+                              config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                              config.output_width.Value(), config.output_height.Value(),
+                              static_cast<u32>(config.output_format.Value()), config.flags);
+                }
 
-            if (Pica::g_debug_context)
-                Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
-                                               nullptr);
-
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
-            } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
-            }
+                Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            });
 
             g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -470,9 +511,11 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(command_processor_config.trigger): {
         const auto& config = g_regs.command_processor_config;
         if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+            ExecuteGPUCommand([address = config.GetPhysicalAddress(), size = config.size] {
+                MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
 
-            Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
+                Pica::CommandProcessor::ProcessCommandList(address, size);
+            });
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -506,6 +549,11 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
+    // The renderer reads the guest framebuffers, so all queued GPU work has to be finished first
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->WaitIdle();
+    }
+
     VideoCore::g_renderer->SwapBuffers();
 
     // Signal to GSP that GPU interrupt has occurred
@@ -520,6 +568,14 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
     Core::System::GetInstance().CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
 }
 
+/// Update hardware
+void Update() {
+    // Deliver the interrupts raised by GPU operations that finished in the meantime
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->ProcessDeferred();
+    }
+}
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory) {
     g_memory = &memory;
@@ -306,6 +306,9 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/// Update hardware
+void Update();
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
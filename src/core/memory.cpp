@@ -2,16 +2,21 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <unordered_map>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "audio_core/dsp_interface.h"
 #include "common/archives.h"
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/hash.h"
+#include "common/host_memory.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
+#include "common/thread_pool.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/global.h"
@@ -20,6 +25,7 @@
 #include "core/hle/lock.h"
 #include "core/memory.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -44,6 +50,13 @@ public:
             *p = cached;
     }
 
+    /// Marks num_pages pages starting at addr, which all have to lie in the same region.
+    void MarkRange(VAddr addr, u32 num_pages, bool cached) {
+        bool* p = At(addr);
+        if (p)
+            std::fill_n(p, num_pages, cached);
+    }
+
     bool IsCached(VAddr addr) {
         bool* p = At(addr);
         if (p)
@@ -79,18 +92,31 @@ private:
     }
 };
 
+static Common::ThreadPool& GetPageHashingPool() {
+    static Common::ThreadPool pool;
+    return pool;
+}
+
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // FCRAM, VRAM and the N3DS extra RAM share one block of host memory, so that the fastmem
+    // views of process address spaces can alias them.
+    static constexpr std::size_t BackingSize =
+        Memory::FCRAM_N3DS_SIZE + Memory::VRAM_SIZE + Memory::N3DS_EXTRA_RAM_SIZE;
+    static constexpr std::size_t BackingPageCount = BackingSize / PAGE_SIZE;
+
+    Common::HostMemory host_memory{BackingSize};
+    u8* const fcram = host_memory.BackingBasePointer();
+    u8* const vram = fcram + Memory::FCRAM_N3DS_SIZE;
+    u8* const n3ds_extra_ram = vram + Memory::VRAM_SIZE;
 
     std::shared_ptr<PageTable> current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
     std::vector<std::shared_ptr<PageTable>> page_table_list;
 
+    /// Fastmem views of the registered page tables, when fastmem is enabled
+    std::unordered_map<const PageTable*, std::unique_ptr<Common::HostMemory::View>> fastmem_views;
+
     AudioCore::DspInterface* dsp = nullptr;
 
     std::shared_ptr<BackingMem> fcram_mem;
@@ -98,18 +124,25 @@ public:
     std::shared_ptr<BackingMem> n3ds_extra_ram_mem;
     std::shared_ptr<BackingMem> dsp_mem;
 
+    /// Hash of every page of the backing memory when the savestate base was taken, empty if none
+    std::vector<u64> base_page_hashes;
+    /// Number of pages that differed from the base in the last serialization
+    std::size_t changed_page_count = 0;
+    /// Whether only the pages that differ from the base are serialized, while there is one
+    bool incremental_serialization = true;
+
     Impl();
 
     const u8* GetPtr(Region r) const {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
@@ -118,18 +151,27 @@ public:
     u8* GetPtr(Region r) {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
     }
 
+    /// Creates a fastmem view for the page table if fastmem is enabled and supported by the host.
+    void CreateFastmemView(PageTable& page_table);
+
+    /// Makes the fastmem view of the page table, if it has one, mirror the given pages.
+    void SyncFastmemView(PageTable& page_table, u32 first_page, u32 num_pages);
+
+    /// Hashes every page of the backing memory.
+    std::vector<u64> HashPages() const;
+
     u32 GetSize(Region r) const {
         switch (r) {
         case Region::VRAM:
@@ -149,13 +191,7 @@ private:
     friend class boost::serialization::access;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int file_version) {
-        bool save_n3ds_ram = Settings::values.is_new_3ds;
-        ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        SerializeContents(ar, file_version);
         ar& cache_marker;
         ar& page_table_list;
         // dsp is set from Core::System at startup
@@ -165,8 +201,61 @@ private:
         ar& n3ds_extra_ram_mem;
         ar& dsp_mem;
     }
+
+public:
+    template <class Archive>
+    void SerializeContents(Archive& ar, const unsigned int file_version) {
+        bool save_n3ds_ram = Settings::values.is_new_3ds;
+        ar& save_n3ds_ram;
+        // Incremental savestates were added in version 1
+        bool incremental = incremental_serialization && !base_page_hashes.empty();
+        if (file_version > 0) {
+            ar& incremental;
+        } else {
+            incremental = false;
+        }
+        if (incremental) {
+            SerializeChangedPages(ar);
+        } else {
+            ar& boost::serialization::make_binary_object(vram, Memory::VRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                fcram, save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                n3ds_extra_ram, save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        }
+    }
+
+private:
+    /// Serializes the pages that differ from the savestate base. When loading, the base must have
+    /// been restored already.
+    template <class Archive>
+    void SerializeChangedPages(Archive& ar) {
+        std::vector<u32> changed_pages;
+        if (Archive::is_saving::value) {
+            const auto page_hashes = HashPages();
+            for (u32 page = 0; page < BackingPageCount; ++page) {
+                if (page_hashes[page] != base_page_hashes[page]) {
+                    changed_pages.push_back(page);
+                }
+            }
+            changed_page_count = changed_pages.size();
+        }
+        ar& changed_pages;
+        for (const u32 page : changed_pages) {
+            if (page >= BackingPageCount) {
+                throw std::runtime_error("Invalid page in incremental savestate");
+            }
+            ar& boost::serialization::make_binary_object(fcram + page * PAGE_SIZE, PAGE_SIZE);
+        }
+    }
 };
 
+} // namespace Memory
+
+BOOST_CLASS_VERSION(Memory::MemorySystem::Impl, 1)
+
+namespace Memory {
+
 // We use this rather than BufferMem because we don't want new objects to be allocated when
 // deserializing. This avoids unnecessary memory thrashing.
 template <Region R>
@@ -200,16 +289,89 @@ MemorySystem::Impl::Impl()
       n3ds_extra_ram_mem(std::make_shared<BackingMemImpl<Region::N3DS>>(*this)),
       dsp_mem(std::make_shared<BackingMemImpl<Region::DSP>>(*this)) {}
 
+void MemorySystem::Impl::CreateFastmemView(PageTable& page_table) {
+    if (!Settings::values.use_fastmem) {
+        return;
+    }
+    if (!host_memory.SupportsViews() || Common::HostMemory::GetPageSize() != PAGE_SIZE) {
+        LOG_WARNING(HW_Memory, "Fastmem is not supported on this host");
+        return;
+    }
+
+    auto view = host_memory.CreateView(std::size_t{1} << 32);
+    if (!view) {
+        return;
+    }
+    page_table.fastmem_base = view->BasePointer();
+    fastmem_views.insert_or_assign(&page_table, std::move(view));
+    SyncFastmemView(page_table, 0, PAGE_TABLE_NUM_ENTRIES);
+}
+
+void MemorySystem::Impl::SyncFastmemView(PageTable& page_table, u32 first_page, u32 num_pages) {
+    const auto iter = fastmem_views.find(&page_table);
+    if (iter == fastmem_views.end()) {
+        return;
+    }
+    auto& view = *iter->second;
+    const auto& pointers = page_table.GetPointerArray();
+    const u8* const backing_begin = host_memory.BackingBasePointer();
+    const u8* const backing_end = backing_begin + host_memory.BackingSize();
+    const auto IsBacked = [&](const u8* pointer) {
+        return pointer >= backing_begin && pointer < backing_end;
+    };
+
+    // Pages without a pointer, or whose memory is not part of the shared block (DSP memory),
+    // have to be accessed through the page table and are left inaccessible in the view.
+    // Consecutive pages are mapped together when their backing memory is consecutive as well.
+    const u32 end = first_page + num_pages;
+    u32 page = first_page;
+    while (page < end) {
+        const u8* const pointer = pointers[page];
+        const bool backed = IsBacked(pointer);
+        u32 run_end = page + 1;
+        while (run_end < end && IsBacked(pointers[run_end]) == backed &&
+               (!backed || pointers[run_end] == pointer + (run_end - page) * PAGE_SIZE)) {
+            ++run_end;
+        }
+
+        const std::size_t offset = static_cast<std::size_t>(page) * PAGE_SIZE;
+        const std::size_t length = static_cast<std::size_t>(run_end - page) * PAGE_SIZE;
+        if (backed) {
+            view.Map(offset, pointer - backing_begin, length);
+        } else {
+            view.Unmap(offset, length);
+        }
+        page = run_end;
+    }
+}
+
 MemorySystem::MemorySystem() : impl(std::make_unique<Impl>()) {}
 MemorySystem::~MemorySystem() = default;
 
 template <class Archive>
 void MemorySystem::serialize(Archive& ar, const unsigned int file_version) {
     ar&* impl.get();
+
+    if (Archive::is_loading::value) {
+        // The page tables have been replaced, along with the pointers in them
+        impl->fastmem_views.clear();
+        for (auto& page_table : impl->page_table_list) {
+            page_table->fastmem_base = nullptr;
+            impl->CreateFastmemView(*page_table);
+        }
+    }
 }
 
 SERIALIZE_IMPL(MemorySystem)
 
+template <class Archive>
+void MemorySystem::SerializeContents(Archive& ar) {
+    impl->SerializeContents(ar, boost::serialization::version<Impl>::value);
+}
+
+template void MemorySystem::SerializeContents<iarchive>(iarchive& ar);
+template void MemorySystem::SerializeContents<oarchive>(oarchive& ar);
+
 void MemorySystem::SetCurrentPageTable(std::shared_ptr<PageTable> page_table) {
     impl->current_page_table = page_table;
 }
@@ -226,6 +388,7 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
+    const u32 first_page = base;
     u32 end = base + size;
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
@@ -243,6 +406,8 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         if (memory != nullptr && memory.GetSize() > PAGE_SIZE)
             memory += PAGE_SIZE;
     }
+
+    impl->SyncFastmemView(page_table, first_page, size);
 }
 
 void MemorySystem::MapMemoryRegion(PageTable& page_table, VAddr base, u32 size, MemoryRef target) {
@@ -281,6 +446,7 @@ MemoryRef MemorySystem::GetPointerForRasterizerCache(VAddr addr) const {
 
 void MemorySystem::RegisterPageTable(std::shared_ptr<PageTable> page_table) {
     impl->page_table_list.push_back(page_table);
+    impl->CreateFastmemView(*page_table);
 }
 
 void MemorySystem::UnregisterPageTable(std::shared_ptr<PageTable> page_table) {
@@ -288,6 +454,8 @@ void MemorySystem::UnregisterPageTable(std::shared_ptr<PageTable> page_table) {
     if (it != impl->page_table_list.end()) {
         impl->page_table_list.erase(it);
     }
+    impl->fastmem_views.erase(page_table.get());
+    page_table->fastmem_base = nullptr;
 }
 
 /**
@@ -429,6 +597,30 @@ const u8* MemorySystem::GetPointer(const VAddr vaddr) const {
     return nullptr;
 }
 
+u8* MemorySystem::GetContiguousPointer(const Kernel::Process& process, const VAddr vaddr,
+                                      const std::size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    auto& page_table = *process.vm_manager.page_table;
+    const auto& pointers = page_table.GetPointerArray();
+    const std::size_t first_page = vaddr >> PAGE_BITS;
+    const std::size_t last_page = (static_cast<std::size_t>(vaddr) + size - 1) >> PAGE_BITS;
+    if (last_page >= PAGE_TABLE_NUM_ENTRIES) {
+        return nullptr;
+    }
+
+    u8* const base = pointers[first_page];
+    for (std::size_t page = first_page; page <= last_page; ++page) {
+        if (page_table.attributes[page] != PageType::Memory ||
+            pointers[page] != base + ((page - first_page) << PAGE_BITS)) {
+            return nullptr;
+        }
+    }
+    return base + (vaddr & PAGE_MASK);
+}
+
 std::string MemorySystem::ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -503,25 +695,43 @@ MemoryRef MemorySystem::GetPhysicalRef(PAddr address) const {
     return {target_mem, offset_into_region};
 }
 
-/// For a rasterizer-accessible PAddr, gets a list of all possible VAddr
-static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
-    if (addr >= VRAM_PADDR && addr < VRAM_PADDR_END) {
-        return {addr - VRAM_PADDR + VRAM_VADDR};
-    }
-    if (addr >= FCRAM_PADDR && addr < FCRAM_PADDR_END) {
-        return {addr - FCRAM_PADDR + LINEAR_HEAP_VADDR, addr - FCRAM_PADDR + NEW_LINEAR_HEAP_VADDR};
-    }
-    if (addr >= FCRAM_PADDR_END && addr < FCRAM_N3DS_PADDR_END) {
-        return {addr - FCRAM_PADDR + NEW_LINEAR_HEAP_VADDR};
+/// A range of physical memory which the rasterizer can cache, and where it is mapped virtually
+struct RasterizerAlias {
+    PAddr paddr_start;
+    PAddr paddr_end;
+    VAddr vaddr_start;
+    Region region;
+};
+
+// FCRAM appears twice, as the old linear heap only covers the Old 3DS part of it
+constexpr std::array<RasterizerAlias, 3> rasterizer_aliases{{
+    {VRAM_PADDR, VRAM_PADDR_END, VRAM_VADDR, Region::VRAM},
+    {FCRAM_PADDR, FCRAM_PADDR_END, LINEAR_HEAP_VADDR, Region::FCRAM},
+    {FCRAM_PADDR, FCRAM_N3DS_PADDR_END, NEW_LINEAR_HEAP_VADDR, Region::FCRAM},
+}};
+
+void MemorySystem::RasterizerUnmarkAll() {
+    for (const auto& alias : rasterizer_aliases) {
+        const u32 num_pages = (alias.paddr_end - alias.paddr_start) >> PAGE_BITS;
+        const auto is_cached = [&](u32 page) {
+            return impl->cache_marker.IsCached(alias.vaddr_start + (page << PAGE_BITS));
+        };
+        // Unmarking a page also unmarks it in the other aliases of the same memory
+        u32 page = 0;
+        while (page < num_pages) {
+            if (!is_cached(page)) {
+                ++page;
+                continue;
+            }
+            u32 run_end = page + 1;
+            while (run_end < num_pages && is_cached(run_end)) {
+                ++run_end;
+            }
+            RasterizerMarkRegionCached(alias.paddr_start + (page << PAGE_BITS),
+                                       (run_end - page) << PAGE_BITS, false);
+            page = run_end;
+        }
     }
-    // While the physical <-> virtual mapping is 1:1 for the regions supported by the cache,
-    // some games (like Pokemon Super Mystery Dungeon) will try to use textures that go beyond
-    // the end address of VRAM, causing the Virtual->Physical translation to fail when flushing
-    // parts of the texture.
-    LOG_ERROR(HW_Memory,
-              "Trying to use invalid physical address for rasterizer: {:08X} at PC 0x{:08X}", addr,
-              Core::GetRunningCore().GetPC());
-    return {};
 }
 
 void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
@@ -529,14 +739,27 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
         return;
     }
 
-    u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
-    PAddr paddr = start;
+    const PAddr paddr_start = start & ~PAGE_MASK;
+    const PAddr paddr_end = ((start + size - 1) & ~PAGE_MASK) + PAGE_SIZE;
+
+    for (const auto& alias : rasterizer_aliases) {
+        const PAddr overlap_start = std::max(paddr_start, alias.paddr_start);
+        const PAddr overlap_end = std::min(paddr_end, alias.paddr_end);
+        if (overlap_start >= overlap_end) {
+            continue;
+        }
+
+        const u32 region_offset = overlap_start - alias.paddr_start;
+        const u32 first_page = (alias.vaddr_start + region_offset) >> PAGE_BITS;
+        const u32 num_pages = (overlap_end - overlap_start) >> PAGE_BITS;
+        impl->cache_marker.MarkRange(first_page << PAGE_BITS, num_pages, cached);
 
-    for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
-        for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
-            impl->cache_marker.Mark(vaddr, cached);
-            for (auto page_table : impl->page_table_list) {
-                PageType& page_type = page_table->attributes[vaddr >> PAGE_BITS];
+        const auto& backing_mem = alias.region == Region::VRAM ? impl->vram_mem : impl->fcram_mem;
+        for (auto& page_table : impl->page_table_list) {
+            bool changed = false;
+            for (u32 i = 0; i < num_pages; ++i) {
+                const u32 page = first_page + i;
+                PageType& page_type = page_table->attributes[page];
 
                 if (cached) {
                     // Switch page type to cached if now cached
@@ -547,7 +770,8 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         break;
                     case PageType::Memory:
                         page_type = PageType::RasterizerCachedMemory;
-                        page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                        page_table->pointers[page] = nullptr;
+                        changed = true;
                         break;
                     default:
                         UNREACHABLE();
@@ -559,19 +783,44 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         // It is not necessary for a process to have this region mapped into its
                         // address space, for example, a system module need not have a VRAM mapping.
                         break;
-                    case PageType::RasterizerCachedMemory: {
+                    case PageType::RasterizerCachedMemory:
                         page_type = PageType::Memory;
-                        page_table->pointers[vaddr >> PAGE_BITS] =
-                            GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
+                        page_table->pointers[page] =
+                            MemoryRef{backing_mem, region_offset + i * PAGE_SIZE};
+                        changed = true;
                         break;
-                    }
                     default:
                         UNREACHABLE();
                     }
                 }
             }
+
+            if (changed) {
+                impl->SyncFastmemView(*page_table, first_page, num_pages);
+            }
         }
     }
+
+    // While the physical <-> virtual mapping is 1:1 for the regions supported by the cache,
+    // some games (like Pokemon Super Mystery Dungeon) will try to use textures that go beyond
+    // the end address of VRAM, causing the Virtual->Physical translation to fail when flushing
+    // parts of the texture.
+    const bool is_valid =
+        std::any_of(rasterizer_aliases.begin(), rasterizer_aliases.end(), [&](const auto& alias) {
+            return paddr_start >= alias.paddr_start && paddr_end <= alias.paddr_end;
+        });
+    if (!is_valid) {
+        LOG_ERROR(HW_Memory,
+                  "Trying to use invalid physical address for rasterizer: {:08X} at PC 0x{:08X}",
+                  start, Core::GetRunningCore().GetPC());
+    }
+}
+
+/// Waits for the asynchronous GPU thread, as it may be accessing guest memory
+static void SyncGPUThread() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->WaitIdle();
+    }
 }
 
 void RasterizerFlushRegion(PAddr start, u32 size) {
@@ -579,6 +828,8 @@ void RasterizerFlushRegion(PAddr start, u32 size) {
         return;
     }
 
+    SyncGPUThread();
+
     VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
 }
 
@@ -587,6 +838,8 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    SyncGPUThread();
+
     VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
 }
 
@@ -597,6 +850,7 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
+    SyncGPUThread();
     VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
 }
 
@@ -607,9 +861,19 @@ void RasterizerClearAll(bool flush) {
         return;
     }
 
+    SyncGPUThread();
     VideoCore::g_renderer->Rasterizer()->ClearAll(flush);
 }
 
+void RasterizerFlushAll() {
+    if (VideoCore::g_renderer == nullptr) {
+        return;
+    }
+
+    SyncGPUThread();
+    VideoCore::g_renderer->Rasterizer()->FlushAll();
+}
+
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
@@ -617,6 +881,8 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         return;
     }
 
+    SyncGPUThread();
+
     VAddr end = start + size;
 
     auto CheckRegion = [&](VAddr region_start, VAddr region_end, PAddr paddr_region_start) {
@@ -931,18 +1197,18 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
 }
 
 u32 MemorySystem::GetFCRAMOffset(const u8* pointer) const {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return static_cast<u32>(pointer - impl->fcram.get());
+    ASSERT(pointer >= impl->fcram && pointer <= impl->fcram + Memory::FCRAM_N3DS_SIZE);
+    return static_cast<u32>(pointer - impl->fcram);
 }
 
 u8* MemorySystem::GetFCRAMPointer(std::size_t offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 const u8* MemorySystem::GetFCRAMPointer(std::size_t offset) const {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
@@ -954,4 +1220,54 @@ void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
 
+std::vector<u64> MemorySystem::Impl::HashPages() const {
+    // Pages are handed out in chunks, so that each call does a meaningful amount of work
+    constexpr std::size_t PagesPerChunk = 256;
+    std::vector<u64> page_hashes(BackingPageCount);
+    GetPageHashingPool().ParallelFor(
+        (BackingPageCount + PagesPerChunk - 1) / PagesPerChunk, [&](std::size_t chunk) {
+            const std::size_t end = std::min(BackingPageCount, (chunk + 1) * PagesPerChunk);
+            for (std::size_t page = chunk * PagesPerChunk; page < end; ++page) {
+                page_hashes[page] = Common::ComputeHash64(fcram + page * PAGE_SIZE, PAGE_SIZE);
+            }
+        });
+    return page_hashes;
+}
+
+const u8* MemorySystem::GetSaveStateBaseData() const {
+    return impl->fcram;
+}
+
+std::size_t MemorySystem::GetSaveStateBaseSize() const {
+    return Impl::BackingSize;
+}
+
+void MemorySystem::SetSaveStateBase() {
+    impl->base_page_hashes = impl->HashPages();
+    impl->changed_page_count = 0;
+}
+
+void MemorySystem::LoadSaveStateBase(const std::vector<u8>& data) {
+    ASSERT(data.size() == Impl::BackingSize);
+    std::memcpy(impl->fcram, data.data(), data.size());
+    SetSaveStateBase();
+}
+
+void MemorySystem::ClearSaveStateBase() {
+    impl->base_page_hashes.clear();
+    impl->changed_page_count = 0;
+}
+
+void MemorySystem::SetIncrementalSerialization(bool enabled) {
+    impl->incremental_serialization = enabled;
+}
+
+bool MemorySystem::HasSaveStateBase() const {
+    return !impl->base_page_hashes.empty();
+}
+
+std::size_t MemorySystem::GetChangedPageCount() const {
+    return impl->changed_page_count;
+}
+
 } // namespace Memory
@@ -125,6 +125,13 @@ struct PageTable {
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
 
+    /**
+     * Base of a host address range mirroring this address space, or null if fastmem is disabled.
+     * Only pages with a pointer to FCRAM, VRAM or N3DS extra RAM are accessible through it, so an
+     * access at fastmem_base + address either reaches the same memory as `pointers` or faults.
+     */
+    u8* fastmem_base = nullptr;
+
     std::array<u8*, PAGE_TABLE_NUM_ENTRIES>& GetPointerArray() {
         return pointers.raw;
     }
@@ -281,6 +288,11 @@ enum class FlushMode {
  */
 void RasterizerClearAll(bool flush);
 
+/**
+ * Flushes all memory in the rasterizer cache to RAM, keeping it cached
+ */
+void RasterizerFlushAll();
+
 /**
  * Flushes and invalidates any externally cached rasterizer resources touching the given virtual
  * address region.
@@ -350,6 +362,13 @@ public:
     u8* GetPointer(VAddr vaddr);
     const u8* GetPointer(VAddr vaddr) const;
 
+    /**
+     * Gets a host pointer through which the whole virtual region can be accessed directly. Returns
+     * nullptr if any page of the region is not plain memory (unmapped, MMIO or rasterizer cached)
+     * or if the pages are not contiguous in host memory.
+     */
+    u8* GetContiguousPointer(const Kernel::Process& process, VAddr vaddr, std::size_t size);
+
     bool IsValidPhysicalAddress(PAddr paddr) const;
 
     /// Gets offset in FCRAM from a pointer inside FCRAM range
@@ -369,6 +388,12 @@ public:
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+    /**
+     * Marks every page as uncached. Used after loading a snapshot taken while the rasterizer
+     * cache held surfaces, as the cache starts out empty.
+     */
+    void RasterizerUnmarkAll();
+
     /// Registers page table for rasterizer cache marking
     void RegisterPageTable(std::shared_ptr<PageTable> page_table);
 
@@ -377,6 +402,42 @@ public:
 
     void SetDSP(AudioCore::DspInterface& dsp);
 
+    /**
+     * Incremental savestates. FCRAM, VRAM and the N3DS extra RAM are one contiguous block of
+     * memory. Once a copy of it has been written out as a base, serializing the memory system
+     * only writes the pages that changed since, and loading applies them on top of the base.
+     */
+
+    /// Returns the memory written out as a savestate base.
+    const u8* GetSaveStateBaseData() const;
+
+    /// Returns the size of the memory written out as a savestate base.
+    std::size_t GetSaveStateBaseSize() const;
+
+    /// Makes the current memory contents the savestate base.
+    void SetSaveStateBase();
+
+    /// Restores the memory contents from a savestate base, and makes it the current base.
+    void LoadSaveStateBase(const std::vector<u8>& data);
+
+    /// Goes back to serializing the whole memory.
+    void ClearSaveStateBase();
+
+    /// Whether only the changed pages are serialized while there is a base, which is the default.
+    /// Snapshots that must not depend on the base turn it off.
+    void SetIncrementalSerialization(bool enabled);
+
+    bool HasSaveStateBase() const;
+
+    /// Returns the number of pages that differed from the base in the last serialization.
+    std::size_t GetChangedPageCount() const;
+
+    /// Serializes only the memory contents, the same way as when serializing the memory system.
+    template <class Archive>
+    void SerializeContents(Archive& ar);
+
+    class Impl;
+
 private:
     template <typename T>
     T Read(const VAddr vaddr);
@@ -394,8 +455,6 @@ private:
 
     void MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory, PageType type);
 
-    class Impl;
-
     std::unique_ptr<Impl> impl;
 
     friend class boost::serialization::access;
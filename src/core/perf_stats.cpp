@@ -11,6 +11,7 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "core/core_timing.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
@@ -73,6 +74,12 @@ void PerfStats::EndGameFrame() {
     game_frames += 1;
 }
 
+void PerfStats::AddIdleTicks(u64 ticks) {
+    std::lock_guard lock{object_mutex};
+
+    idle_ticks += ticks;
+}
+
 double PerfStats::GetMeanFrametime() {
     std::lock_guard lock{object_mutex};
 
@@ -99,6 +106,11 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
+    const auto system_us = current_system_time_us - reset_point_system_us;
+    if (system_us.count() > 0) {
+        const double idle_us = idle_ticks * 1'000'000.0 / BASE_CLOCK_RATE_ARM11;
+        results.idle_ratio = idle_us / system_us.count();
+    }
 
     // Reset counters
     reset_point = now;
@@ -106,6 +118,7 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    idle_ticks = 0;
 
     return results;
 }
@@ -35,12 +35,17 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Ratio of emulated time skipped with all cores idle / emulated time elapsed
+        double idle_ratio;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /// Accounts emulated time that was skipped because all cores were idle
+    void AddIdleTicks(u64 ticks);
+
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
     /**
@@ -76,6 +81,8 @@ private:
     u32 system_frames = 0;
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
+    /// Cumulative emulated ticks skipped with all cores idle since last reset
+    u64 idle_ticks = 0;
 
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
@@ -0,0 +1,165 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "common/zstd_compression.h"
+#include "core/rewind_buffer.h"
+
+MICROPROFILE_DEFINE(Core_RewindCompress, "Core", "Rewind Compression", MP_RGB(160, 120, 220));
+
+namespace Core {
+
+/// Snapshots are taken every few seconds, so compression favours speed over ratio
+constexpr s32 CompressionLevel = 1;
+
+RewindBuffer::RewindBuffer(std::size_t budget) : budget(budget), worker([this] { WorkerLoop(); }) {}
+
+RewindBuffer::~RewindBuffer() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_cv.notify_one();
+    worker.join();
+}
+
+std::vector<u8> RewindBuffer::AcquireBuffer() {
+    std::vector<u8> buffer;
+    {
+        std::lock_guard lock{mutex};
+        buffer.swap(spare);
+    }
+    buffer.clear();
+    return buffer;
+}
+
+void RewindBuffer::Push(std::vector<u8> snapshot) {
+    {
+        std::lock_guard lock{mutex};
+        if (pending) {
+            LOG_DEBUG(Core, "Dropping a rewind snapshot, compression is falling behind");
+            spare = std::move(*pending);
+        }
+        pending = std::move(snapshot);
+    }
+    work_cv.notify_one();
+}
+
+std::optional<std::vector<u8>> RewindBuffer::Pop() {
+    std::vector<u8> compressed;
+    {
+        std::unique_lock lock{mutex};
+
+        // The newest snapshot is still uncompressed if it is waiting for the worker
+        if (pending) {
+            std::vector<u8> snapshot = std::move(*pending);
+            pending.reset();
+            return snapshot;
+        }
+
+        idle_cv.wait(lock, [this] { return !busy; });
+        if (snapshots.empty()) {
+            return std::nullopt;
+        }
+        compressed = std::move(snapshots.back());
+        snapshots.pop_back();
+        compressed_size -= compressed.size();
+    }
+    return Common::Compression::DecompressDataZSTD(compressed);
+}
+
+void RewindBuffer::Flush() {
+    std::unique_lock lock{mutex};
+    idle_cv.wait(lock, [this] { return !pending && !busy; });
+}
+
+void RewindBuffer::Clear() {
+    std::unique_lock lock{mutex};
+    pending.reset();
+    idle_cv.wait(lock, [this] { return !busy; });
+    snapshots.clear();
+    compressed_size = 0;
+}
+
+bool RewindBuffer::IsCompressing() {
+    std::lock_guard lock{mutex};
+    return pending || busy;
+}
+
+std::size_t RewindBuffer::GetSnapshotCount() {
+    std::lock_guard lock{mutex};
+    return snapshots.size() + (pending ? 1 : 0);
+}
+
+std::size_t RewindBuffer::GetCompressedSize() {
+    std::lock_guard lock{mutex};
+    return compressed_size;
+}
+
+std::size_t RewindBuffer::GetMemoryUsage() {
+    std::lock_guard lock{mutex};
+    return MemoryUsage();
+}
+
+std::size_t RewindBuffer::MemoryUsage() const {
+    const std::size_t pending_size = pending ? pending->capacity() : 0;
+    return compressed_size + compressing_size + pending_size + spare.capacity();
+}
+
+void RewindBuffer::TrimToBudget() {
+    while (MemoryUsage() > budget && !snapshots.empty()) {
+        compressed_size -= snapshots.front().size();
+        snapshots.pop_front();
+    }
+    if (MemoryUsage() > budget) {
+        // Not even one snapshot fits next to the storage for taking the next one
+        spare = std::vector<u8>();
+        if (!warned_budget) {
+            LOG_WARNING(Core, "The rewind buffer size is too small to hold a snapshot");
+            warned_budget = true;
+        }
+    }
+}
+
+void RewindBuffer::WorkerLoop() {
+    Common::SetCurrentThreadName("Rewind");
+    MicroProfileOnThreadCreate("Rewind");
+
+    std::unique_lock lock{mutex};
+    while (true) {
+        work_cv.wait(lock, [this] { return stop || pending; });
+        if (stop) {
+            break;
+        }
+
+        std::vector<u8> snapshot = std::move(*pending);
+        pending.reset();
+        busy = true;
+        compressing_size = snapshot.capacity();
+        lock.unlock();
+
+        std::vector<u8> compressed;
+        {
+            MICROPROFILE_SCOPE(Core_RewindCompress);
+            compressed = Common::Compression::CompressDataZSTD(snapshot.data(), snapshot.size(),
+                                                               CompressionLevel);
+        }
+
+        lock.lock();
+        busy = false;
+        compressing_size = 0;
+        compressed_size += compressed.size();
+        snapshots.push_back(std::move(compressed));
+        spare = std::move(snapshot);
+        TrimToBudget();
+        idle_cv.notify_all();
+    }
+    lock.unlock();
+
+    MicroProfileOnThreadExit();
+}
+
+} // namespace Core
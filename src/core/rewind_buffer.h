@@ -0,0 +1,87 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * A bounded ring of compressed savestates kept in memory, to rewind emulation without going
+ * through the filesystem. Snapshots are compressed on a worker thread so that taking one only
+ * costs the emulation thread the serialization. The memory budget covers the uncompressed
+ * snapshots held for that as well, which are about the size of the emulated memory each. Once it
+ * is exceeded, the oldest compressed snapshots are dropped.
+ */
+class RewindBuffer : NonCopyable {
+public:
+    explicit RewindBuffer(std::size_t budget);
+    ~RewindBuffer();
+
+    /// Returns an empty buffer to serialize the next snapshot into, reusing the storage of a
+    /// snapshot that has already been compressed when there is one.
+    std::vector<u8> AcquireBuffer();
+
+    /**
+     * Queues a serialized snapshot to be compressed and added to the ring. If the previous
+     * snapshot is still waiting to be compressed, it is replaced, so that at most one
+     * uncompressed snapshot is ever held back.
+     */
+    void Push(std::vector<u8> snapshot);
+
+    /// Removes the newest snapshot from the ring and returns it decompressed. Returns nothing if
+    /// the ring is empty.
+    std::optional<std::vector<u8>> Pop();
+
+    /// Waits until the queued snapshot, if any, has been compressed and added to the ring.
+    void Flush();
+
+    /// Returns whether a snapshot is waiting to be compressed or being compressed.
+    bool IsCompressing();
+
+    void Clear();
+
+    std::size_t GetSnapshotCount();
+
+    /// Returns the total size of the compressed snapshots.
+    std::size_t GetCompressedSize();
+
+    /// Returns the memory used by the snapshots, compressed or not, as counted against the budget.
+    std::size_t GetMemoryUsage();
+
+private:
+    void WorkerLoop();
+
+    /// Returns the memory used by the snapshots. mutex must be held.
+    std::size_t MemoryUsage() const;
+
+    /// Drops the oldest snapshots until the ring fits in the budget. mutex must be held.
+    void TrimToBudget();
+
+    std::size_t budget;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    std::optional<std::vector<u8>> pending; ///< Snapshot waiting to be compressed
+    std::vector<u8> spare;                  ///< Storage of a snapshot that has been compressed
+    std::deque<std::vector<u8>> snapshots;  ///< Compressed snapshots, oldest first
+    std::size_t compressed_size = 0;
+    std::size_t compressing_size = 0; ///< Size of the snapshot being compressed
+    bool busy = false;
+    bool warned_budget = false;
+    bool stop = false;
+
+    std::thread worker;
+};
+
+} // namespace Core
@@ -2,19 +2,31 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <chrono>
+#include <thread>
 #include <boost/serialization/binary_object.hpp>
 #include <cryptopp/hex.h>
 #include "common/archives.h"
 #include "common/logging/log.h"
+#include "common/memory_streambuf.h"
+#include "common/microprofile.h"
 #include "common/scm_rev.h"
+#include "common/scope_exit.h"
 #include "common/zstd_compression.h"
 #include "core/cheats/cheats.h"
 #include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hw/gpu.h"
+#include "core/rewind_buffer.h"
 #include "core/savestate.h"
+#include "core/settings.h"
 #include "network/network.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/video_core.h"
 
+MICROPROFILE_DEFINE(Core_RewindSnapshot, "Core", "Rewind Snapshot", MP_RGB(120, 80, 220));
+
 namespace Core {
 
 #pragma pack(push, 1)
@@ -23,8 +35,10 @@ struct CSTHeader {
     u64_le program_id;           /// ID of the ROM being executed. Also called title_id
     std::array<u8, 20> revision; /// Git hash of the revision this savestate was created with
     u64_le time;                 /// The time when this save state was created
+    u8 is_incremental; /// Whether only the memory pages that changed since the base are included
+    u64_le base_id;    /// Identifies the base of an incremental save state
 
-    std::array<u8, 216> reserved; /// Make heading 256 bytes so it has consistent size
+    std::array<u8, 207> reserved; /// Make heading 256 bytes so it has consistent size
 
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
@@ -35,12 +49,105 @@ static_assert(sizeof(CSTHeader) == 256, "CSTHeader should be 256 bytes");
 #pragma pack(pop)
 
 constexpr std::array<u8, 4> header_magic_bytes{{'C', 'S', 'T', 0x1B}};
+constexpr std::array<u8, 4> base_magic_bytes{{'C', 'S', 'B', 0x1B}};
+
+/// Emulated CPU ticks per frame, which the rewind interval is counted in
+constexpr u64 FrameTicks = static_cast<u64>(BASE_CLOCK_RATE_ARM11 / GPU::SCREEN_REFRESH_RATE);
+
+/// A new base is written once more than this fraction of the memory differs from the current one
+constexpr std::size_t RebaseChangedPageDivisor = 4;
 
 std::string GetSaveStatePath(u64 program_id, u32 slot) {
     return fmt::format("{}{:016X}.{:02d}.cst", FileUtil::GetUserPath(FileUtil::UserPath::StatesDir),
                        program_id, slot);
 }
 
+static std::string GetSaveStateBasePath(u64 program_id, u32 slot, u64 base_id) {
+    return fmt::format("{}{:016X}.{:02d}.{:016X}.base",
+                       FileUtil::GetUserPath(FileUtil::UserPath::StatesDir), program_id, slot,
+                       base_id);
+}
+
+static CSTHeader MakeHeader(const std::array<u8, 4>& filetype, u64 program_id) {
+    CSTHeader header{};
+    header.filetype = filetype;
+    header.program_id = program_id;
+    std::string rev_bytes;
+    CryptoPP::StringSource(Common::g_scm_rev, true,
+                           new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
+    std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(header.revision));
+    header.time = std::chrono::duration_cast<std::chrono::seconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    return header;
+}
+
+static bool ReadHeader(const std::string& path, CSTHeader& header) {
+    FileUtil::IOFile file(path, "rb");
+    return file && file.ReadBytes(&header, sizeof(header)) == sizeof(header) &&
+           (header.filetype == header_magic_bytes || header.filetype == base_magic_bytes);
+}
+
+/// Threads compressing a save state in the background, while the emulation thread serializes
+static u32 GetCompressionWorkerCount() {
+    return std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+}
+
+/// Writes a save state file, streaming what write(std::streambuf&) outputs through the compressor
+/// to a temporary file. It only replaces the file at path once it is complete, so that a failed
+/// save doesn't destroy the previous one.
+template <typename Func>
+static void WriteSaveStateFile(const std::string& path, const CSTHeader& header, Func&& write) {
+    if (!FileUtil::CreateFullPath(path)) {
+        throw std::runtime_error("Could not create path " + path);
+    }
+
+    const std::string temp_path = path + ".tmp";
+    FileUtil::IOFile file(temp_path, "wb");
+    if (!file) {
+        throw std::runtime_error("Could not open file " + temp_path);
+    }
+
+    try {
+        if (file.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+            throw std::runtime_error("Could not write to file " + temp_path);
+        }
+        Common::Compression::ZSTDOutputStreamBuf streambuf{file, GetCompressionWorkerCount()};
+        write(streambuf);
+        if (!streambuf.Finish() || !file.Close()) {
+            throw std::runtime_error("Could not write to file " + temp_path);
+        }
+    } catch (...) {
+        file.Close();
+        FileUtil::Delete(temp_path);
+        throw;
+    }
+
+#ifdef _WIN32
+    // Renaming doesn't replace an existing file on Windows
+    if (FileUtil::Exists(path) && !FileUtil::Delete(path)) {
+        FileUtil::Delete(temp_path);
+        throw std::runtime_error("Could not replace file " + path);
+    }
+#endif
+    if (!FileUtil::Rename(temp_path, path)) {
+        FileUtil::Delete(temp_path);
+        throw std::runtime_error("Could not replace file " + path);
+    }
+}
+
+/// Opens a save state file and reads its header. The compressed data follows it.
+static FileUtil::IOFile OpenSaveStateFile(const std::string& path, CSTHeader& header) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file || file.GetSize() < sizeof(header)) {
+        throw std::runtime_error("Could not open file " + path);
+    }
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        throw std::runtime_error("Could not read from file at " + path);
+    }
+    return file;
+}
+
 std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
     std::vector<SaveStateInfo> result;
     for (u32 slot = 1; slot <= SaveStateSlotCount; ++slot) {
@@ -88,41 +195,85 @@ std::vector<SaveStateInfo> ListSaveStates(u64 program_id) {
     return result;
 }
 
-void System::SaveState(u32 slot) const {
-    std::ostringstream sstream{std::ios_base::binary};
-    // Serialize
-    oarchive oa{sstream};
-    oa&* this;
+/// Waits for the asynchronous GPU thread, which may still be writing to memory and the GPU
+/// registers, and delivers the interrupts it raised
+static void WaitForGPUThread() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->WaitIdle();
+    }
+}
 
-    const std::string& str{sstream.str()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(
-        reinterpret_cast<const u8*>(str.data()), str.size());
+/// Milliseconds elapsed since start, for logging how long saving and loading took
+static long long GetElapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
 
+void System::SaveState(u32 slot) {
+    const auto start_time = std::chrono::steady_clock::now();
     const auto path = GetSaveStatePath(title_id, slot);
-    if (!FileUtil::CreateFullPath(path)) {
-        throw std::runtime_error("Could not create path " + path);
-    }
+    WaitForGPUThread();
 
-    FileUtil::IOFile file(path, "wb");
-    if (!file) {
-        throw std::runtime_error("Could not open file " + path);
+    // The base of the incremental save state being replaced is removed once it is unused
+    CSTHeader old_header;
+    const bool replaces_incremental = ReadHeader(path, old_header) && old_header.is_incremental;
+
+    CSTHeader header = MakeHeader(header_magic_bytes, title_id);
+    bool wrote_base = false;
+    if (Settings::values.incremental_savestates) {
+        const std::size_t rebase_threshold =
+            memory->GetSaveStateBaseSize() / Memory::PAGE_SIZE / RebaseChangedPageDivisor;
+        if (!memory->HasSaveStateBase() || savestate_base_slot != slot ||
+            memory->GetChangedPageCount() > rebase_threshold ||
+            !FileUtil::Exists(GetSaveStateBasePath(title_id, slot, savestate_base_id))) {
+            const u64 base_id = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::system_clock::now().time_since_epoch())
+                                    .count();
+            CSTHeader base_header = MakeHeader(base_magic_bytes, title_id);
+            base_header.base_id = base_id;
+            const auto base_path = GetSaveStateBasePath(title_id, slot, base_id);
+            WriteSaveStateFile(base_path, base_header, [this, &base_path](std::streambuf& sb) {
+                const auto size = static_cast<std::streamsize>(memory->GetSaveStateBaseSize());
+                if (sb.sputn(reinterpret_cast<const char*>(memory->GetSaveStateBaseData()),
+                             size) != size) {
+                    throw std::runtime_error("Could not write to file " + base_path);
+                }
+            });
+
+            memory->SetSaveStateBase();
+            savestate_base_slot = slot;
+            savestate_base_id = base_id;
+            wrote_base = true;
+            LOG_INFO(Core, "Wrote a new base for incremental save states in slot {}", slot);
+        }
+        header.is_incremental = 1;
+        header.base_id = savestate_base_id;
+    } else {
+        memory->ClearSaveStateBase();
     }
 
-    CSTHeader header{};
-    header.filetype = header_magic_bytes;
-    header.program_id = title_id;
-    std::string rev_bytes;
-    CryptoPP::StringSource(Common::g_scm_rev, true,
-                           new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
-    std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(header.revision));
-    header.time = std::chrono::duration_cast<std::chrono::seconds>(
-                      std::chrono::system_clock::now().time_since_epoch())
-                      .count();
+    // Serialize
+    try {
+        WriteSaveStateFile(path, header, [this](std::streambuf& sb) {
+            oarchive oa{sb};
+            oa&* this;
+        });
+    } catch (...) {
+        // The base written just now would only have been used by this save state
+        if (wrote_base) {
+            FileUtil::Delete(GetSaveStateBasePath(title_id, slot, header.base_id));
+        }
+        throw;
+    }
+    if (header.is_incremental) {
+        LOG_DEBUG(Core, "Incremental save state contains {} changed pages",
+                  memory->GetChangedPageCount());
+    }
 
-    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
-        file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
-        throw std::runtime_error("Could not write to file " + path);
+    if (replaces_incremental && (!header.is_incremental || old_header.base_id != header.base_id)) {
+        FileUtil::Delete(GetSaveStateBasePath(title_id, slot, old_header.base_id));
     }
+    LOG_INFO(Core, "Saved state to slot {} in {} ms", slot, GetElapsedMilliseconds(start_time));
 }
 
 void System::LoadState(u32 slot) {
@@ -130,27 +281,101 @@ void System::LoadState(u32 slot) {
         throw std::runtime_error("Unable to load while connected to multiplayer");
     }
 
+    const auto start_time = std::chrono::steady_clock::now();
     const auto path = GetSaveStatePath(title_id, slot);
+    WaitForGPUThread();
 
-    std::vector<u8> decompressed;
-    {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
+    CSTHeader header;
+    FileUtil::IOFile file = OpenSaveStateFile(path, header);
 
-        FileUtil::IOFile file(path, "rb");
-        file.Seek(sizeof(CSTHeader), SEEK_SET); // Skip header
-        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
-            throw std::runtime_error("Could not read from file at " + path);
+    // Incremental save states are applied on top of the memory contents of their base
+    std::vector<u8> base;
+    if (header.is_incremental) {
+        const auto base_path = GetSaveStateBasePath(title_id, slot, header.base_id);
+        CSTHeader base_header;
+        FileUtil::IOFile base_file = OpenSaveStateFile(base_path, base_header);
+        if (base_header.filetype != base_magic_bytes || base_header.base_id != header.base_id) {
+            throw std::runtime_error("Invalid base for save state " + path);
+        }
+        base.resize(memory->GetSaveStateBaseSize());
+        Common::Compression::ZSTDInputStreamBuf base_streambuf{base_file};
+        const auto size = static_cast<std::streamsize>(base.size());
+        if (base_streambuf.sgetn(reinterpret_cast<char*>(base.data()), size) != size ||
+            base_streambuf.sgetc() != std::streambuf::traits_type::eof()) {
+            throw std::runtime_error("Invalid base for save state " + path);
         }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
+        loading_savestate_base = &base;
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
+    SCOPE_EXIT({ loading_savestate_base = nullptr; });
 
-    // Deserialize
-    iarchive ia{sstream};
+    // Deserialize straight from the decompressor
+    Common::Compression::ZSTDInputStreamBuf streambuf{file};
+    iarchive ia{streambuf};
     ia&* this;
+
+    if (header.is_incremental) {
+        savestate_base_slot = slot;
+        savestate_base_id = header.base_id;
+    }
+    LOG_INFO(Core, "Loaded state from slot {} in {} ms", slot, GetElapsedMilliseconds(start_time));
+}
+
+void System::UpdateRewindBuffer() {
+    const u64 ticks = timing->GetGlobalTicks();
+    if (ticks < next_rewind_snapshot_ticks) {
+        return;
+    }
+    // Taking a snapshot while the previous one is still being compressed would hold a second
+    // uncompressed one in memory, so try again on the next slice
+    if (rewind_buffer->IsCompressing()) {
+        return;
+    }
+    const auto interval = static_cast<u64>(std::max(Settings::values.rewind_interval, 1));
+    next_rewind_snapshot_ticks = ticks + interval * FrameTicks;
+
+    MICROPROFILE_SCOPE(Core_RewindSnapshot);
+    WaitForGPUThread();
+
+    // Snapshots must not depend on the base of incremental savestates, which may change before
+    // they are restored
+    memory->SetIncrementalSerialization(false);
+    taking_rewind_snapshot = true;
+    SCOPE_EXIT({
+        memory->SetIncrementalSerialization(true);
+        taking_rewind_snapshot = false;
+    });
+
+    // Serialize straight into a buffer the rewind buffer owns, its worker compresses it
+    std::vector<u8> snapshot = rewind_buffer->AcquireBuffer();
+    {
+        Common::VectorOutputStreamBuf streambuf{snapshot};
+        oarchive oa{streambuf};
+        oa&* this;
+    }
+    rewind_buffer->Push(std::move(snapshot));
+}
+
+bool System::Rewind() {
+    if (Network::GetRoomMember().lock()->IsConnected()) {
+        throw std::runtime_error("Unable to rewind while connected to multiplayer");
+    }
+
+    if (!rewind_buffer) {
+        return false;
+    }
+    const auto snapshot = rewind_buffer->Pop();
+    if (!snapshot) {
+        return false;
+    }
+    WaitForGPUThread();
+
+    Common::MemoryInputStreamBuf streambuf{snapshot->data(), snapshot->size()};
+    iarchive ia{streambuf};
+    ia&* this;
+
+    const auto interval = static_cast<u64>(std::max(Settings::values.rewind_interval, 1));
+    next_rewind_snapshot_ticks = timing->GetGlobalTicks() + interval * FrameTicks;
+    return true;
 }
 
 } // namespace Core
@@ -76,12 +76,25 @@ void LogSetting(const std::string& name, const T& value) {
 void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
+    LogSetting("Core_UseFastmem", Settings::values.use_fastmem);
+    LogSetting("Core_UseMultiCore", Settings::values.use_multi_core);
+    LogSetting("Core_EnableRewind", Settings::values.enable_rewind);
+    LogSetting("Core_RewindInterval", Settings::values.rewind_interval);
+    LogSetting("Core_RewindBufferSize", Settings::values.rewind_buffer_size);
     LogSetting("Renderer_UseGLES", Settings::values.use_gles);
+    LogSetting("Renderer_UseNullRenderer", Settings::values.use_null_renderer);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
     LogSetting("Renderer_SeparableShader", Settings::values.separable_shader);
     LogSetting("Renderer_ShadersAccurateMul", Settings::values.shaders_accurate_mul);
     LogSetting("Renderer_UseShaderJit", Settings::values.use_shader_jit);
+    LogSetting("Renderer_UseAsynchronousGpuEmulation",
+               Settings::values.use_asynchronous_gpu_emulation);
+    LogSetting("Renderer_UseMultithreadedSwRasterizer",
+               Settings::values.use_multithreaded_sw_rasterizer);
+    LogSetting("Renderer_UseMultithreadedVertexShading",
+               Settings::values.use_multithreaded_vertex_shading);
+    LogSetting("Renderer_VertexCacheSize", Settings::values.vertex_cache_size);
     LogSetting("Renderer_UseResolutionFactor", Settings::values.resolution_factor);
     LogSetting("Renderer_UseFrameLimit", Settings::values.use_frame_limit);
     LogSetting("Renderer_FrameLimit", Settings::values.frame_limit);
@@ -114,6 +127,9 @@ void LogSettings() {
     LogSetting("Camera_OuterLeftConfig", Settings::values.camera_config[OuterLeftCamera]);
     LogSetting("Camera_OuterLeftFlip", Settings::values.camera_flip[OuterLeftCamera]);
     LogSetting("DataStorage_UseVirtualSd", Settings::values.use_virtual_sd);
+    LogSetting("DataStorage_RomFSCacheSize", Settings::values.romfs_cache_size);
+    LogSetting("DataStorage_UseAsyncFileIO", Settings::values.use_async_file_io);
+    LogSetting("DataStorage_IncrementalSavestates", Settings::values.incremental_savestates);
     LogSetting("System_IsNew3ds", Settings::values.is_new_3ds);
     LogSetting("System_RegionValue", Settings::values.region_value);
     LogSetting("Debugging_UseGdbstub", Settings::values.use_gdbstub);
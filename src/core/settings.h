@@ -129,9 +129,17 @@ struct Values {
     // Core
     bool use_cpu_jit;
     int cpu_clock_percentage;
+    bool use_fastmem;
+    bool use_multi_core;
+    bool enable_rewind;
+    int rewind_interval;    ///< Frames between rewind snapshots
+    int rewind_buffer_size; ///< Memory budget of the rewind snapshots, in MiB
 
     // Data Storage
     bool use_virtual_sd;
+    int romfs_cache_size;
+    bool use_async_file_io;
+    bool incremental_savestates;
 
     // System
     int region_value;
@@ -140,12 +148,17 @@ struct Values {
 
     // Renderer
     bool use_gles;
+    bool use_null_renderer;
     bool use_hw_renderer;
     bool use_hw_shader;
     bool separable_shader;
     bool use_disk_shader_cache;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    bool use_asynchronous_gpu_emulation;
+    bool use_multithreaded_sw_rasterizer;
+    bool use_multithreaded_vertex_shading;
+    u16 vertex_cache_size;
     u16 resolution_factor;
     bool use_frame_limit;
     u16 frame_limit;
@@ -0,0 +1,23 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+
+namespace Tests {
+
+/// Runs func the given number of times, and returns the average time it took in milliseconds
+template <typename Func>
+double MeasureMilliseconds(int iterations, Func&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        func();
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace Tests
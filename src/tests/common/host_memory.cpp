@@ -0,0 +1,55 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "common/host_memory.h"
+
+namespace Common {
+
+TEST_CASE("HostMemory::View", "[common]") {
+    const std::size_t page_size = HostMemory::GetPageSize();
+    HostMemory memory(4 * page_size);
+    REQUIRE(memory.BackingSize() == 4 * page_size);
+    u8* const backing = memory.BackingBasePointer();
+    backing[0] = 1;
+    backing[page_size] = 2;
+
+    if (!memory.SupportsViews()) {
+        CHECK(memory.CreateView(16 * page_size) == nullptr);
+        return;
+    }
+
+    auto view = memory.CreateView(16 * page_size);
+    REQUIRE(view != nullptr);
+    REQUIRE(view->Size() == 16 * page_size);
+    u8* const base = view->BasePointer();
+
+    SECTION("mapped ranges alias the backing memory") {
+        view->Map(8 * page_size, 0, 2 * page_size);
+        CHECK(base[8 * page_size] == 1);
+        CHECK(base[9 * page_size] == 2);
+
+        base[8 * page_size + 5] = 42;
+        CHECK(backing[5] == 42);
+        backing[page_size + 7] = 43;
+        CHECK(base[9 * page_size + 7] == 43);
+    }
+
+    SECTION("the same backing memory can be mapped several times") {
+        view->Map(0, page_size, page_size);
+        view->Map(3 * page_size, page_size, page_size);
+        base[0] = 10;
+        CHECK(base[3 * page_size] == 10);
+        CHECK(backing[page_size] == 10);
+    }
+
+    SECTION("remapping a range replaces the previous mapping") {
+        view->Map(0, 0, page_size);
+        view->Unmap(0, page_size);
+        view->Map(0, page_size, page_size);
+        CHECK(base[0] == 2);
+    }
+}
+
+} // namespace Common
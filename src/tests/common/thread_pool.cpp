@@ -0,0 +1,36 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/thread_pool.h"
+
+namespace Common {
+
+TEST_CASE("ThreadPool::ParallelFor", "[common]") {
+    ThreadPool pool(4);
+    REQUIRE(pool.GetThreadCount() == 4);
+
+    std::vector<std::atomic<int>> calls(1000);
+    for (int round = 0; round < 10; ++round) {
+        pool.ParallelFor(calls.size(), [&](std::size_t i) { ++calls[i]; });
+    }
+    for (const auto& count : calls) {
+        REQUIRE(count == 10);
+    }
+
+    pool.ParallelFor(0, [](std::size_t) { FAIL("Called for an empty range"); });
+}
+
+TEST_CASE("ThreadPool::SingleThread", "[common]") {
+    ThreadPool pool(1);
+    REQUIRE(pool.GetThreadCount() == 1);
+
+    std::vector<std::size_t> order;
+    pool.ParallelFor(5, [&](std::size_t i) { order.push_back(i); });
+    REQUIRE(order == std::vector<std::size_t>{0, 1, 2, 3, 4});
+}
+
+} // namespace Common
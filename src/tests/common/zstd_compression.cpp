@@ -0,0 +1,73 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/zstd_compression.h"
+
+namespace Common::Compression {
+
+static std::vector<char> MakeData(std::size_t size) {
+    std::vector<char> data(size);
+    u32 seed = 1;
+    for (std::size_t i = 0; i < size; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        // Compressible, but not trivially
+        data[i] = static_cast<char>(i % 251 < 128 ? i : seed >> 24);
+    }
+    return data;
+}
+
+TEST_CASE("ZSTD stream buffers round trip through a file", "[common]") {
+    const std::string path = "zstd_stream_test.bin";
+    const std::vector<char> data = MakeData(0x500000);
+    constexpr std::size_t split = 1000;
+    const u32 worker_count = GENERATE(0u, 2u);
+
+    {
+        FileUtil::IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes("head", 4) == 4);
+        ZSTDOutputStreamBuf streambuf{file, worker_count};
+        // Small writes go through the buffer, large ones straight to the compressor
+        for (std::size_t i = 0; i < split; ++i) {
+            REQUIRE(streambuf.sputc(data[i]) == static_cast<u8>(data[i]));
+        }
+        REQUIRE(streambuf.sputn(data.data() + split, data.size() - split) ==
+                static_cast<std::streamsize>(data.size() - split));
+        REQUIRE(streambuf.Finish());
+    }
+    CHECK(FileUtil::GetSize(path) < data.size());
+
+    {
+        FileUtil::IOFile file(path, "rb");
+        char head[4];
+        REQUIRE(file.ReadBytes(head, 4) == 4);
+        ZSTDInputStreamBuf streambuf{file};
+        std::vector<char> result(data.size());
+        for (std::size_t i = 0; i < split; ++i) {
+            result[i] = static_cast<char>(streambuf.sbumpc());
+        }
+        REQUIRE(streambuf.sgetn(result.data() + split, result.size() - split) ==
+                static_cast<std::streamsize>(result.size() - split));
+        CHECK(streambuf.sgetc() == std::streambuf::traits_type::eof());
+        CHECK(result == data);
+    }
+
+    SECTION("truncated data is not read past its end") {
+        FileUtil::IOFile file(path, "r+b");
+        REQUIRE(file.Resize(file.GetSize() / 2));
+        REQUIRE(file.Seek(4, SEEK_SET));
+        ZSTDInputStreamBuf streambuf{file};
+        std::vector<char> result(data.size());
+        CHECK(streambuf.sgetn(result.data(), result.size()) <
+              static_cast<std::streamsize>(result.size()));
+    }
+
+    FileUtil::Delete(path);
+}
+
+} // namespace Common::Compression
@@ -0,0 +1,105 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <catch2/catch.hpp>
+#include "core/arm/dyncom/arm_dyncom.h"
+#include "core/arm/dyncom/arm_dyncom_block_cache.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "tests/core/arm/arm_test_common.h"
+
+namespace ArmTests {
+
+/// Runs exactly the given number of instructions, following blocks from one to the next
+static void RunInstructions(ARM_DynCom& dyncom, Core::Timing::Timer& timer, s64 count) {
+    timer.Advance();
+    timer.SetNextSlice(count);
+    dyncom.Run();
+}
+
+TEST_CASE("ARM_DynCom (block cache): code changes", "[arm_dyncom]") {
+    TestEnvironment test_env(false);
+    test_env.SetMemory32(0x1000, 0xEA0003FE); // b 0x2000
+    test_env.SetMemory32(0x2000, 0xE2800001); // add r0, r0, #1
+    test_env.SetMemory32(0x2004, 0xEAFFFBFD); // b 0x1000
+
+    Core::Timing timing(1, 100);
+    auto timer = timing.GetTimer(0);
+    ARM_DynCom dyncom(&Core::System::GetInstance(), test_env.GetMemory(), USER32MODE, 0, timer);
+
+    const auto run_from_start = [&] {
+        dyncom.SetPC(0x1000);
+        dyncom.SetReg(0, 0);
+        RunInstructions(dyncom, *timer, 15);
+        return dyncom.GetReg(0);
+    };
+    REQUIRE(run_from_start() == 5);
+
+    test_env.SetMemory32(0x2000, 0xE2800002); // add r0, r0, #2
+
+    SECTION("translated blocks are kept until their code is invalidated") {
+        REQUIRE(run_from_start() == 5);
+        dyncom.InvalidateCacheRange(0x3000, 0x1000);
+        REQUIRE(run_from_start() == 5);
+    }
+
+    SECTION("invalidating a range also breaks the links to its blocks") {
+        dyncom.InvalidateCacheRange(0x2000, 4);
+        REQUIRE(run_from_start() == 10);
+    }
+
+    SECTION("clearing the cache discards every block") {
+        dyncom.ClearInstructionCache();
+        REQUIRE(run_from_start() == 10);
+    }
+}
+
+TEST_CASE("ARM_DynCom (block cache): invalidation only breaks links into its pages",
+          "[arm_dyncom]") {
+    BlockCache cache;
+    cache.Insert(0x1000, 0);
+    cache.Insert(0x2000, 64);
+    const u32 epoch_1000 = cache.PageEpoch(0x1000);
+    const u32 epoch_2000 = cache.PageEpoch(0x2000);
+
+    cache.InvalidateRange(0x2004, 4);
+    REQUIRE(cache.Find(0x2000) == BlockCache::NotFound);
+    REQUIRE(cache.PageEpoch(0x2000) != epoch_2000);
+    REQUIRE(cache.Find(0x1000) == 0);
+    REQUIRE(cache.PageEpoch(0x1000) == epoch_1000);
+
+    cache.Clear();
+    REQUIRE(cache.PageEpoch(0x1000) != epoch_1000);
+}
+
+TEST_CASE("ARM_DynCom (block cache): instructions per second", "[.][benchmark]") {
+    TestEnvironment test_env(false);
+    test_env.SetMemory32(0x1000, 0xE2800001); // add r0, r0, #1
+    test_env.SetMemory32(0x1004, 0xE1500001); // cmp r0, r1
+    test_env.SetMemory32(0x1008, 0xBAFFFFFC); // blt 0x1000
+    test_env.SetMemory32(0x100C, 0xEAFFFFFE); // b +#0
+
+    Core::Timing timing(1, 100);
+    auto timer = timing.GetTimer(0);
+    ARM_DynCom dyncom(&Core::System::GetInstance(), test_env.GetMemory(), USER32MODE, 0, timer);
+    dyncom.SetPC(0x1000);
+    dyncom.SetReg(0, 0);
+    dyncom.SetReg(1, 0x7FFFFFFF);
+
+    // Every third instruction ends a block, so this mostly measures going from block to block
+    constexpr s64 instructions = 30'000'000;
+    const auto start = std::chrono::steady_clock::now();
+    for (s64 executed = 0; executed < instructions; executed += Core::Timing::MAX_SLICE_LENGTH) {
+        RunInstructions(dyncom, *timer, Core::Timing::MAX_SLICE_LENGTH);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const u64 executed = timer->GetTicks();
+    WARN("Executed " << executed << " instructions in a three instruction loop: "
+                     << executed / elapsed.count() / 1'000'000.0 << " million per second");
+    CHECK(dyncom.GetReg(0) == (executed + 2) / 3);
+}
+
+} // namespace ArmTests
@@ -0,0 +1,55 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/core_thread_pool.h"
+
+namespace Core {
+
+TEST_CASE("CoreThreadPool runs cores on their own threads", "[core]") {
+    CoreThreadPool pool(3);
+    REQUIRE(!CoreThreadPool::IsCoreThread());
+
+    const auto emu_thread = std::this_thread::get_id();
+    std::vector<std::thread::id> core_threads(3);
+    // Catch assertions are not thread safe, so the core threads only record what they see
+    std::vector<int> calls(3);
+    std::vector<int> calls_on_same_thread(3);
+    int emu_thread_total = 0;
+    int calls_on_emu_thread = 0;
+
+    for (int round = 0; round < 10; ++round) {
+        pool.RunSlice([&](std::size_t i) {
+            if (round == 0) {
+                core_threads[i] = std::this_thread::get_id();
+            }
+            if (CoreThreadPool::IsCoreThread() && core_threads[i] == std::this_thread::get_id()) {
+                ++calls_on_same_thread[i];
+            }
+            ++calls[i];
+
+            for (int j = 0; j < 100; ++j) {
+                pool.CallOnEmuThread([&] {
+                    // Only the emulation thread runs these, so this needs no synchronisation
+                    if (std::this_thread::get_id() == emu_thread) {
+                        ++calls_on_emu_thread;
+                    }
+                    ++emu_thread_total;
+                });
+            }
+        });
+    }
+
+    CHECK(calls == std::vector<int>{10, 10, 10});
+    CHECK(calls_on_same_thread == calls);
+    CHECK(emu_thread_total == 3 * 10 * 100);
+    CHECK(calls_on_emu_thread == emu_thread_total);
+    CHECK(core_threads[0] != core_threads[1]);
+    CHECK(core_threads[1] != core_threads[2]);
+    CHECK(core_threads[0] != emu_thread);
+}
+
+} // namespace Core
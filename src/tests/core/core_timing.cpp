@@ -4,12 +4,17 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <functional>
+#include <random>
 #include <string>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "tests/benchmark_common.h"
 
 // Numbers are chosen randomly to make sure the correct one is given.
 static constexpr std::array<u64, 5> CB_IDS{{42, 144, 93, 1026, UINT64_C(0xFFFF7FFFF7FFFF)}};
@@ -196,4 +201,170 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(MAX_SLICE_LENGTH == timing.GetTimer(0)->GetDowncount());
 }
 
+TEST_CASE("CoreTiming[Unschedule]", "[core]") {
+    Core::Timing timing(2, 100);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    timing.ScheduleEvent(300, cb_a, CB_IDS[0], 0);
+    timing.ScheduleEvent(100, cb_b, CB_IDS[1], 0);
+    timing.ScheduleEvent(200, cb_b, CB_IDS[1], 0);
+    timing.ScheduleEvent(150, cb_b, CB_IDS[2], 0);
+    for (u64 userdata = 0; userdata < 8; ++userdata) {
+        timing.ScheduleEvent(50 + userdata, cb_c, userdata, 0);
+    }
+    // Goes through the queue of events scheduled from other cores
+    timing.ScheduleEvent(100, cb_b, CB_IDS[1], 1);
+    REQUIRE(50 == timing.GetTimer(0)->GetDowncount());
+
+    // Every event of cb_b with that userdata is cancelled, on both cores
+    timing.UnscheduleEvent(cb_b, CB_IDS[1]);
+    timing.RemoveEvent(cb_c);
+    timing.UnscheduleEvent(cb_b, CB_IDS[2]);
+
+    // Cancelling events that are not queued does nothing
+    timing.UnscheduleEvent(cb_b, CB_IDS[1]);
+    timing.RemoveEvent(cb_c);
+
+    timing.GetTimer(0)->AddTicks(timing.GetTimer(0)->GetDowncount());
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+    REQUIRE(250 == timing.GetTimer(0)->GetDowncount());
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+
+    callbacks_ran_flags = 0;
+    timing.GetTimer(1)->Advance();
+    timing.GetTimer(1)->SetNextSlice();
+    REQUIRE(MAX_SLICE_LENGTH == timing.GetTimer(1)->GetDowncount());
+    timing.GetTimer(1)->AddTicks(timing.GetTimer(1)->GetDowncount());
+    timing.GetTimer(1)->Advance();
+    REQUIRE(callbacks_ran_flags.none());
+}
+
+namespace SkipIdleTimeTest {
+static Core::Timing* timing_ptr = nullptr;
+static Core::TimingEventType* periodic_event = nullptr;
+static int periodic_runs = 0;
+static bool woken_up = false;
+
+void PeriodicCallback(u64 userdata, s64 cycles_late) {
+    ++periodic_runs;
+    timing_ptr->ScheduleEvent(MAX_SLICE_LENGTH - cycles_late, periodic_event, 0, 0);
+}
+
+void WakeupCallback(u64 userdata, s64 cycles_late) {
+    woken_up = true;
+}
+} // namespace SkipIdleTimeTest
+
+TEST_CASE("CoreTiming[SkipIdleTime]", "[core]") {
+    using namespace SkipIdleTimeTest;
+
+    Core::Timing timing(2, 100);
+    timing_ptr = &timing;
+    periodic_event = timing.RegisterEvent("periodic", PeriodicCallback);
+    Core::TimingEventType* wakeup = timing.RegisterEvent("wakeup", WakeupCallback);
+    periodic_runs = 0;
+    woken_up = false;
+
+    const auto advance_while_idle = [&] {
+        for (std::size_t i = 0; i < 2; ++i) {
+            timing.GetTimer(i)->Advance();
+        }
+        return !woken_up;
+    };
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(1)->Advance();
+    timing.ScheduleEvent(MAX_SLICE_LENGTH, periodic_event, 0, 0);
+
+    SECTION("skips past the slice limit until the limit given") {
+        const s64 skipped = timing.SkipIdleTime(MAX_SLICE_LENGTH * 4, advance_while_idle);
+        REQUIRE(skipped == MAX_SLICE_LENGTH * 4);
+        REQUIRE(periodic_runs == 3);
+        REQUIRE(timing.GetTimer(0)->GetTicks() == MAX_SLICE_LENGTH * 4);
+        REQUIRE(timing.GetTimer(1)->GetTicks() == MAX_SLICE_LENGTH * 4);
+        REQUIRE(timing.GetTimer(0)->GetIdleTicks() == MAX_SLICE_LENGTH);
+    }
+
+    SECTION("stops at the event that wakes a core up") {
+        timing.ScheduleEvent(MAX_SLICE_LENGTH * 5 / 2, wakeup, 0, 1);
+        const s64 skipped = timing.SkipIdleTime(MAX_SLICE_LENGTH * 10, advance_while_idle);
+        REQUIRE(skipped == MAX_SLICE_LENGTH * 5 / 2);
+        REQUIRE(woken_up);
+        REQUIRE(periodic_runs == 2);
+        REQUIRE(timing.GetTimer(0)->GetTicks() == MAX_SLICE_LENGTH * 5 / 2);
+        REQUIRE(timing.GetTimer(1)->GetTicks() == MAX_SLICE_LENGTH * 5 / 2);
+    }
+}
+
+namespace UnscheduleBenchmark {
+
+/// How the queue used to cancel events, by searching it and rebuilding the heap
+void RemoveAndRebuild(std::vector<Core::Timing::Event>& queue,
+                      const Core::TimingEventType* event_type, u64 userdata) {
+    const auto itr = std::remove_if(queue.begin(), queue.end(), [&](const auto& e) {
+        return e.type == event_type && e.userdata == userdata;
+    });
+    if (itr != queue.end()) {
+        queue.erase(itr, queue.end());
+        std::make_heap(queue.begin(), queue.end(), std::greater<>());
+    }
+}
+
+} // namespace UnscheduleBenchmark
+
+TEST_CASE("CoreTiming event cancellation benchmark", "[.][benchmark]") {
+    using namespace UnscheduleBenchmark;
+
+    // Like threads waking up from timeouts: every pending event is cancelled and rescheduled
+    constexpr u64 pending_events = 2000;
+    constexpr int reschedules = 20000;
+    constexpr int iterations = 5;
+
+    Core::Timing timing(1, 100);
+    Core::TimingEventType* wakeup = timing.RegisterEvent("Wakeup", [](u64, s64) {});
+
+    std::mt19937_64 random{42};
+    std::vector<u64> order(reschedules);
+    std::vector<s64> delays(reschedules);
+    for (int i = 0; i < reschedules; ++i) {
+        order[i] = random() % pending_events;
+        delays[i] = 1000 + static_cast<s64>(random() % 100000);
+    }
+
+    std::vector<Core::Timing::Event> naive_queue;
+    u64 fifo_order = 0;
+    for (u64 userdata = 0; userdata < pending_events; ++userdata) {
+        timing.ScheduleEvent(delays[userdata], wakeup, userdata);
+        naive_queue.push_back({delays[userdata], fifo_order++, userdata, wakeup});
+        std::push_heap(naive_queue.begin(), naive_queue.end(), std::greater<>());
+    }
+
+    const double rebuilt = Tests::MeasureMilliseconds(iterations, [&] {
+        for (int i = 0; i < reschedules; ++i) {
+            RemoveAndRebuild(naive_queue, wakeup, order[i]);
+            naive_queue.push_back({delays[i], fifo_order++, order[i], wakeup});
+            std::push_heap(naive_queue.begin(), naive_queue.end(), std::greater<>());
+        }
+    });
+    const double indexed = Tests::MeasureMilliseconds(iterations, [&] {
+        for (int i = 0; i < reschedules; ++i) {
+            timing.UnscheduleEvent(wakeup, order[i]);
+            timing.ScheduleEvent(delays[i], wakeup, order[i]);
+        }
+    });
+
+    WARN("Rescheduling " << reschedules << " of " << pending_events << " events: " << rebuilt
+                         << " ms by rebuilding the heap, " << indexed << " ms indexed");
+    CHECK(indexed < rebuilt);
+}
+
 // TODO: Add tests for multiple timers
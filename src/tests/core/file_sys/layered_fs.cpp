@@ -0,0 +1,107 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/layered_fs.h"
+
+namespace FileSys {
+
+class MemoryRomFSReader : public RomFSReader {
+public:
+    explicit MemoryRomFSReader(std::vector<u8> data) : data(std::move(data)) {}
+
+    std::size_t GetSize() const override {
+        return data.size();
+    }
+
+    std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer) override {
+        const std::size_t read_length = std::min(length, data.size() - offset);
+        std::memcpy(buffer, data.data() + offset, read_length);
+        return read_length;
+    }
+
+private:
+    std::vector<u8> data;
+};
+
+/// Builds a RomFS with only an empty root directory
+static std::vector<u8> MakeEmptyRomFS() {
+    RomFSHeader header{};
+    header.header_length = sizeof(header);
+    header.directory_hash_table = {0x28, 4};
+    header.directory_metadata_table = {0x2C, 0x18};
+    header.file_hash_table = {0x44, 4};
+    header.file_metadata_table = {0x48, 0};
+    header.file_data_offset = 0x50;
+
+    std::vector<u8> data(header.file_data_offset, 0xFF);
+    std::memcpy(data.data(), &header, sizeof(header));
+    // Directory hash table: the root directory is at offset 0
+    std::memset(data.data() + 0x28, 0, 4);
+    // Root directory metadata: parent is itself, nameless, no siblings, children or files
+    std::memset(data.data() + 0x2C, 0, 4);
+    std::memset(data.data() + 0x40, 0, 4);
+    return data;
+}
+
+static std::vector<u8> ReadImage(LayeredFS& layered_fs) {
+    std::vector<u8> image(layered_fs.GetSize());
+    REQUIRE(layered_fs.ReadFile(0, image.size(), image.data()) == image.size());
+    return image;
+}
+
+static bool Contains(const std::vector<u8>& image, const std::string& text) {
+    return std::search(image.begin(), image.end(), text.begin(), text.end()) != image.end();
+}
+
+TEST_CASE("LayeredFS metadata cache", "[core][file_sys]") {
+    const std::string test_path = "layered_fs_test/";
+    const std::string patch_path = test_path + "romfs/";
+    FileUtil::SetUserPath(test_path + "user/");
+    REQUIRE(FileUtil::CreateFullPath(patch_path + "dir/"));
+    FileUtil::WriteStringToFile(true, patch_path + "a.bin", "hello");
+    FileUtil::WriteStringToFile(true, patch_path + "dir/b.bin", "world!");
+
+    const auto make_layered_fs = [&] {
+        return LayeredFS(std::make_shared<MemoryRomFSReader>(MakeEmptyRomFS()), patch_path,
+                         test_path + "romfs_ext/");
+    };
+
+    std::vector<u8> cold_image;
+    {
+        auto layered_fs = make_layered_fs();
+        cold_image = ReadImage(layered_fs);
+    }
+    CHECK(Contains(cold_image, "hello"));
+    CHECK(Contains(cold_image, "world!"));
+    CHECK(FileUtil::IsDirectory(FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) +
+                                "layered_fs"));
+
+    SECTION("an unchanged patch directory gives the same image") {
+        auto layered_fs = make_layered_fs();
+        CHECK(ReadImage(layered_fs) == cold_image);
+    }
+
+    SECTION("a changed file is picked up") {
+        FileUtil::WriteStringToFile(true, patch_path + "a.bin", "hello again");
+        auto layered_fs = make_layered_fs();
+        const auto image = ReadImage(layered_fs);
+        CHECK(Contains(image, "hello again"));
+    }
+
+    SECTION("a new file is picked up") {
+        FileUtil::WriteStringToFile(true, patch_path + "dir/c.bin", "new file");
+        auto layered_fs = make_layered_fs();
+        CHECK(Contains(ReadImage(layered_fs), "new file"));
+    }
+
+    FileUtil::DeleteDirRecursively(test_path);
+}
+
+} // namespace FileSys
@@ -0,0 +1,116 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <string>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include "common/file_util.h"
+#include "core/file_sys/romfs_reader.h"
+
+namespace FileSys {
+
+constexpr std::size_t TestDataSize = 10 * DirectRomFSReader::BlockSize + 0x123;
+constexpr std::size_t TestFileOffset = 0x200;
+constexpr std::size_t TestCryptoOffset = 0x1000;
+constexpr std::array<u8, 16> TestKey{0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                     0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+constexpr std::array<u8, 16> TestCtr{0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE,
+                                     0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF};
+
+static std::vector<u8> MakePlaintext() {
+    std::vector<u8> data(TestDataSize);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 7 + (i >> 8));
+    }
+    return data;
+}
+
+static void WriteEncryptedFile(const std::string& path, const std::vector<u8>& plaintext) {
+    std::vector<u8> encrypted(plaintext.size());
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption e(TestKey.data(), TestKey.size(),
+                                                    TestCtr.data());
+    e.Seek(TestCryptoOffset);
+    e.ProcessData(encrypted.data(), plaintext.data(), plaintext.size());
+
+    FileUtil::IOFile file(path, "wb");
+    const std::vector<u8> header(TestFileOffset, 0xCC);
+    file.WriteBytes(header.data(), header.size());
+    file.WriteBytes(encrypted.data(), encrypted.size());
+}
+
+TEST_CASE("DirectRomFSReader block cache", "[core][file_sys]") {
+    const std::string path = "romfs_reader_test.bin";
+    const auto plaintext = MakePlaintext();
+    WriteEncryptedFile(path, plaintext);
+
+    {
+        DirectRomFSReader reader(FileUtil::IOFile(path, "rb"), TestFileOffset, TestDataSize,
+                                 TestKey, TestCtr, TestCryptoOffset);
+        reader.SetCacheCapacity(4);
+
+        const auto check_read = [&](std::size_t offset, std::size_t length) {
+            std::vector<u8> buffer(length);
+            const std::size_t expected = std::min(length, TestDataSize - offset);
+            REQUIRE(reader.ReadFile(offset, length, buffer.data()) == expected);
+            CHECK(std::equal(buffer.begin(), buffer.begin() + expected,
+                             plaintext.begin() + offset));
+        };
+
+        SECTION("scattered reads return decrypted data and hit the cache") {
+            check_read(0x10, 0x20);
+            check_read(3 * DirectRomFSReader::BlockSize - 5, 10);
+            check_read(0x40, 0x20);
+            const auto stats = reader.GetCacheStats();
+            CHECK(stats.misses == 3);
+            CHECK(stats.hits == 2);
+        }
+
+        SECTION("sequential reads return decrypted data and read ahead") {
+            constexpr std::size_t chunk = 0x1000;
+            for (std::size_t offset = 0; offset < TestDataSize; offset += chunk) {
+                check_read(offset, chunk);
+            }
+            const auto stats = reader.GetCacheStats();
+            CHECK(stats.misses == 11);
+            CHECK(stats.hits > stats.misses);
+        }
+
+        SECTION("reads larger than the cache return decrypted data") {
+            check_read(0x80, TestDataSize);
+        }
+    }
+
+    FileUtil::Delete(path);
+}
+
+TEST_CASE("DirectRomFSReader unencrypted spans", "[core][file_sys]") {
+    const std::string path = "romfs_reader_test.bin";
+    const auto plaintext = MakePlaintext();
+    {
+        FileUtil::IOFile file(path, "wb");
+        const std::vector<u8> header(TestFileOffset, 0xCC);
+        file.WriteBytes(header.data(), header.size());
+        file.WriteBytes(plaintext.data(), plaintext.size());
+    }
+
+    {
+        DirectRomFSReader reader(FileUtil::IOFile(path, "rb"), TestFileOffset, TestDataSize);
+
+        const u8* span = reader.GetSpan(0x1234, 0x100);
+        REQUIRE(span != nullptr);
+        CHECK(std::equal(span, span + 0x100, plaintext.begin() + 0x1234));
+        CHECK(reader.GetSpan(TestDataSize - 0x10, 0x20) == nullptr);
+
+        std::vector<u8> buffer(0x100);
+        REQUIRE(reader.ReadFile(TestDataSize - 0x80, 0x100, buffer.data()) == 0x80);
+        CHECK(std::equal(buffer.begin(), buffer.begin() + 0x80, plaintext.end() - 0x80));
+    }
+
+    FileUtil::Delete(path);
+}
+
+} // namespace FileSys
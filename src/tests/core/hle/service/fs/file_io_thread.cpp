@@ -0,0 +1,86 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <numeric>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/file_sys/errors.h"
+#include "core/file_sys/file_backend.h"
+#include "core/hle/service/fs/file_io_thread.h"
+
+namespace Service::FS {
+
+/// A read-only file whose contents are its byte offsets
+class TestFile final : public FileSys::FileBackend {
+public:
+    explicit TestFile(std::size_t size) : data(size) {
+        std::iota(data.begin(), data.end(), u8{0});
+    }
+
+    ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override {
+        if (offset > data.size()) {
+            return FileSys::ERROR_INVALID_READ_FLAG;
+        }
+        const std::size_t read_length = std::min<std::size_t>(length, data.size() - offset);
+        std::copy_n(data.begin() + offset, read_length, buffer);
+        return MakeResult<std::size_t>(read_length);
+    }
+
+    ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
+                                 const u8* buffer) override {
+        return FileSys::ERROR_UNSUPPORTED_OPEN_FLAGS;
+    }
+
+    u64 GetSize() const override {
+        return data.size();
+    }
+
+    bool SetSize(u64 size) const override {
+        return false;
+    }
+
+    bool Close() const override {
+        return false;
+    }
+
+    void Flush() const override {}
+
+private:
+    std::vector<u8> data;
+};
+
+TEST_CASE("FileIOThread services reads in order", "[core][fs]") {
+    FileIOThread io_thread;
+    TestFile file(0x1000);
+
+    std::vector<std::shared_ptr<FileIORequest>> requests;
+    for (u64 offset = 0; offset < 0x1000; offset += 0x100) {
+        requests.push_back(io_thread.Read(file, offset, 0x100));
+    }
+
+    requests.back()->Wait();
+    for (const auto& request : requests) {
+        // Waiting for the last request implies the earlier ones have completed as well
+        REQUIRE(request->result.Succeeded());
+        REQUIRE(*request->result == 0x100);
+        for (std::size_t i = 0; i < 0x100; ++i) {
+            REQUIRE(request->data[i] == static_cast<u8>(request->GetOffset() + i));
+        }
+    }
+}
+
+TEST_CASE("FileIOThread reports short and failed reads", "[core][fs]") {
+    FileIOThread io_thread;
+    TestFile file(0x180);
+
+    auto short_read = io_thread.Read(file, 0x100, 0x100);
+    auto failed_read = io_thread.Read(file, 0x200, 0x100);
+    failed_read->Wait();
+
+    REQUIRE(short_read->result.Succeeded());
+    CHECK(*short_read->result == 0x80);
+    CHECK(failed_read->result.Code() == FileSys::ERROR_INVALID_READ_FLAG);
+}
+
+} // namespace Service::FS
@@ -2,13 +2,18 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include <sstream>
+#include <vector>
 #include <catch2/catch.hpp>
+#include "common/archives.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/shared_page.h"
 #include "core/memory.h"
+#include "core/settings.h"
 
 TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
     Core::Timing timing(1, 100);
@@ -54,3 +59,124 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::MemorySystem fastmem", "[core][memory]") {
+    Settings::values.use_fastmem = true;
+    Memory::MemorySystem memory;
+    Settings::values.use_fastmem = false;
+
+    auto page_table = std::make_shared<Memory::PageTable>();
+    page_table->Clear();
+    memory.RegisterPageTable(page_table);
+    if (page_table->fastmem_base == nullptr) {
+        // Not supported on this host
+        return;
+    }
+
+    constexpr VAddr base = 0x10000000;
+    memory.MapMemoryRegion(*page_table, base, 2 * Memory::PAGE_SIZE, memory.GetFCRAMRef(0x3000));
+
+    SECTION("mapped memory is accessible through the fastmem view") {
+        memory.GetFCRAMPointer(0x3000)[5] = 42;
+        CHECK(page_table->fastmem_base[base + 5] == 42);
+        page_table->fastmem_base[base + Memory::PAGE_SIZE + 7] = 43;
+        CHECK(memory.GetFCRAMPointer(0x4000)[7] == 43);
+    }
+
+    SECTION("remapped memory is accessible at its new address") {
+        memory.UnmapRegion(*page_table, base, 2 * Memory::PAGE_SIZE);
+        memory.MapMemoryRegion(*page_table, base, Memory::PAGE_SIZE, memory.GetFCRAMRef(0x8000));
+        memory.GetFCRAMPointer(0x8000)[9] = 44;
+        CHECK(page_table->fastmem_base[base + 9] == 44);
+    }
+
+    memory.UnregisterPageTable(page_table);
+    CHECK(page_table->fastmem_base == nullptr);
+}
+
+TEST_CASE("Memory::MemorySystem::GetContiguousPointer", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    auto& page_table = *process->vm_manager.page_table;
+
+    constexpr VAddr base = 0x10000000;
+    memory.MapMemoryRegion(page_table, base, 2 * Memory::PAGE_SIZE, memory.GetFCRAMRef(0x3000));
+    memory.MapMemoryRegion(page_table, base + 2 * Memory::PAGE_SIZE, Memory::PAGE_SIZE,
+                           memory.GetFCRAMRef(0x9000));
+
+    SECTION("contiguous pages can be accessed in place") {
+        CHECK(memory.GetContiguousPointer(*process, base + 0x10, 2 * Memory::PAGE_SIZE - 0x10) ==
+              memory.GetFCRAMPointer(0x3010));
+    }
+
+    SECTION("pages that are not contiguous on the host can't") {
+        CHECK(memory.GetContiguousPointer(*process, base + Memory::PAGE_SIZE,
+                                          2 * Memory::PAGE_SIZE) == nullptr);
+    }
+
+    SECTION("unmapped pages can't") {
+        CHECK(memory.GetContiguousPointer(*process, base + 2 * Memory::PAGE_SIZE,
+                                          2 * Memory::PAGE_SIZE) == nullptr);
+    }
+}
+
+TEST_CASE("Memory::MemorySystem incremental savestates", "[core][memory]") {
+    Memory::MemorySystem memory;
+    const auto serialized_size = [&memory] {
+        std::ostringstream stream{std::ios_base::binary};
+        oarchive oa{stream};
+        oa << memory;
+        return stream.str().size();
+    };
+
+    const std::size_t full_size = serialized_size();
+    memory.SetSaveStateBase();
+    REQUIRE(memory.HasSaveStateBase());
+    const std::size_t unchanged_size = serialized_size();
+    CHECK(memory.GetChangedPageCount() == 0);
+    CHECK(unchanged_size < full_size);
+
+    memory.GetFCRAMPointer(0x10)[0] ^= 0xFF;
+    memory.GetFCRAMPointer(5 * Memory::PAGE_SIZE)[0] ^= 0xFF;
+    CHECK(serialized_size() >= unchanged_size + 2 * Memory::PAGE_SIZE);
+    CHECK(memory.GetChangedPageCount() == 2);
+
+    memory.ClearSaveStateBase();
+    CHECK(serialized_size() == full_size);
+}
+
+TEST_CASE("Memory::MemorySystem incremental savestate round trip", "[core][memory]") {
+    Memory::MemorySystem memory;
+    const std::size_t size = memory.GetSaveStateBaseSize();
+    u8* const contents = memory.GetFCRAMPointer(0);
+    for (std::size_t i = 0; i < size; i += 97) {
+        contents[i] = static_cast<u8>(i / 97);
+    }
+    memory.SetSaveStateBase();
+    const std::vector<u8> base(memory.GetSaveStateBaseData(),
+                               memory.GetSaveStateBaseData() + size);
+
+    // Change the first and last pages, and one in VRAM, which follows FCRAM
+    contents[3] ^= 0x5A;
+    contents[size - 1] ^= 0xA5;
+    contents[Memory::FCRAM_N3DS_SIZE + 5 * Memory::PAGE_SIZE + 11] = 0x33;
+
+    std::ostringstream out{std::ios_base::binary};
+    {
+        oarchive oa{out};
+        memory.SerializeContents(oa);
+    }
+    REQUIRE(memory.GetChangedPageCount() == 3);
+
+    Memory::MemorySystem restored;
+    restored.LoadSaveStateBase(base);
+    std::istringstream in{out.str(), std::ios_base::binary};
+    {
+        iarchive ia{in};
+        restored.SerializeContents(ia);
+    }
+    REQUIRE(std::memcmp(restored.GetSaveStateBaseData(), memory.GetSaveStateBaseData(), size) ==
+            0);
+}
@@ -0,0 +1,154 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "tests/benchmark_common.h"
+
+namespace {
+
+constexpr u32 HEAP_MAPPING_SIZE = 0x02000000;
+
+std::shared_ptr<Memory::PageTable> CreatePageTable(Memory::MemorySystem& memory) {
+    auto page_table = std::make_shared<Memory::PageTable>();
+    page_table->Clear();
+    memory.MapMemoryRegion(*page_table, Memory::VRAM_VADDR, Memory::VRAM_SIZE,
+                           memory.GetPhysicalRef(Memory::VRAM_PADDR));
+    memory.MapMemoryRegion(*page_table, Memory::LINEAR_HEAP_VADDR, HEAP_MAPPING_SIZE,
+                           memory.GetFCRAMRef(0));
+    memory.MapMemoryRegion(*page_table, Memory::NEW_LINEAR_HEAP_VADDR, HEAP_MAPPING_SIZE,
+                           memory.GetFCRAMRef(0));
+    memory.RegisterPageTable(page_table);
+    return page_table;
+}
+
+bool IsCached(Memory::PageTable& page_table, VAddr vaddr) {
+    const u32 page = vaddr >> Memory::PAGE_BITS;
+    return page_table.attributes[page] == Memory::PageType::RasterizerCachedMemory &&
+           page_table.pointers[page] == nullptr;
+}
+
+bool IsUncached(Memory::MemorySystem& memory, Memory::PageTable& page_table, VAddr vaddr,
+                PAddr paddr) {
+    const u32 page = vaddr >> Memory::PAGE_BITS;
+    return page_table.attributes[page] == Memory::PageType::Memory &&
+           page_table.pointers[page] == memory.GetPhysicalPointer(paddr);
+}
+
+/// The previous implementation, which looked up the aliases of every page separately
+void MarkRegionCachedPerPage(Memory::MemorySystem& memory,
+                             const std::vector<std::shared_ptr<Memory::PageTable>>& page_tables,
+                             PAddr start, u32 size, bool cached) {
+    const auto GetAliases = [](PAddr paddr) -> std::vector<VAddr> {
+        if (paddr >= Memory::VRAM_PADDR && paddr < Memory::VRAM_PADDR_END) {
+            return {paddr - Memory::VRAM_PADDR + Memory::VRAM_VADDR};
+        }
+        if (paddr >= Memory::FCRAM_PADDR && paddr < Memory::FCRAM_PADDR_END) {
+            return {paddr - Memory::FCRAM_PADDR + Memory::LINEAR_HEAP_VADDR,
+                    paddr - Memory::FCRAM_PADDR + Memory::NEW_LINEAR_HEAP_VADDR};
+        }
+        return {};
+    };
+
+    const u32 num_pages =
+        ((start + size - 1) >> Memory::PAGE_BITS) - (start >> Memory::PAGE_BITS) + 1;
+    PAddr paddr = start;
+    for (u32 i = 0; i < num_pages; ++i, paddr += Memory::PAGE_SIZE) {
+        for (VAddr vaddr : GetAliases(paddr)) {
+            for (const auto& page_table : page_tables) {
+                const u32 page = vaddr >> Memory::PAGE_BITS;
+                auto& page_type = page_table->attributes[page];
+                if (cached && page_type == Memory::PageType::Memory) {
+                    page_type = Memory::PageType::RasterizerCachedMemory;
+                    page_table->pointers[page] = nullptr;
+                } else if (!cached && page_type == Memory::PageType::RasterizerCachedMemory) {
+                    page_type = Memory::PageType::Memory;
+                    page_table->pointers[page] = memory.GetPhysicalRef(paddr);
+                }
+            }
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Memory::MemorySystem::RasterizerMarkRegionCached", "[core][memory]") {
+    Memory::MemorySystem memory;
+    auto page_table = CreatePageTable(memory);
+
+    SECTION("VRAM") {
+        const PAddr start = Memory::VRAM_PADDR + 0x1800;
+        memory.RasterizerMarkRegionCached(start, 0x2000, true);
+        CHECK(IsUncached(memory, *page_table, Memory::VRAM_VADDR, Memory::VRAM_PADDR));
+        CHECK(IsCached(*page_table, Memory::VRAM_VADDR + 0x1000));
+        CHECK(IsCached(*page_table, Memory::VRAM_VADDR + 0x3000));
+        CHECK(IsUncached(memory, *page_table, Memory::VRAM_VADDR + 0x4000,
+                         Memory::VRAM_PADDR + 0x4000));
+
+        memory.RasterizerMarkRegionCached(start, 0x2000, false);
+        for (u32 offset = 0x1000; offset <= 0x3000; offset += Memory::PAGE_SIZE) {
+            CHECK(IsUncached(memory, *page_table, Memory::VRAM_VADDR + offset,
+                             Memory::VRAM_PADDR + offset));
+        }
+    }
+
+    SECTION("FCRAM is marked in both linear heaps") {
+        const PAddr start = Memory::FCRAM_PADDR + 0x10000;
+        memory.RasterizerMarkRegionCached(start, 0x1000, true);
+        CHECK(IsCached(*page_table, Memory::LINEAR_HEAP_VADDR + 0x10000));
+        CHECK(IsCached(*page_table, Memory::NEW_LINEAR_HEAP_VADDR + 0x10000));
+
+        memory.RasterizerMarkRegionCached(start, 0x1000, false);
+        CHECK(IsUncached(memory, *page_table, Memory::LINEAR_HEAP_VADDR + 0x10000, start));
+        CHECK(IsUncached(memory, *page_table, Memory::NEW_LINEAR_HEAP_VADDR + 0x10000, start));
+    }
+
+    SECTION("pages mapped after marking are marked as well") {
+        memory.RasterizerMarkRegionCached(Memory::VRAM_PADDR, Memory::VRAM_SIZE, true);
+        auto other_page_table = CreatePageTable(memory);
+        CHECK(IsCached(*other_page_table, Memory::VRAM_VADDR));
+        CHECK(IsCached(*other_page_table, Memory::VRAM_VADDR_END - Memory::PAGE_SIZE));
+        memory.UnregisterPageTable(other_page_table);
+    }
+
+    memory.UnregisterPageTable(page_table);
+}
+
+TEST_CASE("Memory::MemorySystem::RasterizerMarkRegionCached benchmark", "[.][benchmark]") {
+    constexpr int iterations = 20;
+    Memory::MemorySystem memory;
+    std::vector<std::shared_ptr<Memory::PageTable>> page_tables;
+    for (int i = 0; i < 3; ++i) {
+        page_tables.push_back(CreatePageTable(memory));
+    }
+
+    // A screen-sized surface in VRAM and a large texture in the linear heap
+    const std::vector<std::pair<PAddr, u32>> regions = {
+        {Memory::VRAM_PADDR, 0x00100000},
+        {Memory::FCRAM_PADDR + 0x00400000, 0x00800000},
+    };
+
+    const double per_page = Tests::MeasureMilliseconds(iterations, [&] {
+        for (const auto& [start, size] : regions) {
+            MarkRegionCachedPerPage(memory, page_tables, start, size, true);
+            MarkRegionCachedPerPage(memory, page_tables, start, size, false);
+        }
+    });
+    const double ranged = Tests::MeasureMilliseconds(iterations, [&] {
+        for (const auto& [start, size] : regions) {
+            memory.RasterizerMarkRegionCached(start, size, true);
+            memory.RasterizerMarkRegionCached(start, size, false);
+        }
+    });
+
+    WARN("Marking and unmarking 9 MiB with 3 page tables: " << per_page << " ms per page, "
+                                                            << ranged << " ms by range");
+    CHECK(ranged < per_page);
+
+    for (const auto& page_table : page_tables) {
+        memory.UnregisterPageTable(page_table);
+    }
+}
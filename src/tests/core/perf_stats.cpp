@@ -0,0 +1,33 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <catch2/catch.hpp>
+#include "core/core_timing.h"
+#include "core/perf_stats.h"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("PerfStats idle ratio", "[core]") {
+    Core::PerfStats perf_stats(0);
+    perf_stats.GetAndResetStats(0us);
+
+    SECTION("is the share of emulated time skipped while idle") {
+        perf_stats.AddIdleTicks(BASE_CLOCK_RATE_ARM11 / 8);
+        perf_stats.AddIdleTicks(BASE_CLOCK_RATE_ARM11 / 8);
+        const auto results = perf_stats.GetAndResetStats(1s);
+        REQUIRE(results.idle_ratio == Approx(0.25));
+    }
+
+    SECTION("is reset with the other stats") {
+        perf_stats.AddIdleTicks(BASE_CLOCK_RATE_ARM11);
+        perf_stats.GetAndResetStats(1s);
+        REQUIRE(perf_stats.GetAndResetStats(2s).idle_ratio == 0.0);
+    }
+
+    SECTION("is zero when no emulated time has passed") {
+        perf_stats.AddIdleTicks(BASE_CLOCK_RATE_ARM11);
+        REQUIRE(perf_stats.GetAndResetStats(0us).idle_ratio == 0.0);
+    }
+}
@@ -0,0 +1,89 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/rewind_buffer.h"
+
+namespace Core {
+
+/// Pseudo-random data, so that compression cannot make the snapshots arbitrarily small
+static std::vector<u8> MakeSnapshot(u32 seed, std::size_t size = 0x1000) {
+    std::vector<u8> snapshot(size);
+    for (auto& byte : snapshot) {
+        seed = seed * 1664525 + 1013904223;
+        byte = static_cast<u8>(seed >> 24);
+    }
+    return snapshot;
+}
+
+TEST_CASE("RewindBuffer returns snapshots newest first", "[core]") {
+    RewindBuffer buffer{1024 * 1024};
+    REQUIRE(!buffer.Pop());
+
+    for (u32 i = 0; i < 4; ++i) {
+        std::vector<u8> snapshot = buffer.AcquireBuffer();
+        REQUIRE(snapshot.empty());
+        snapshot = MakeSnapshot(i);
+        buffer.Push(std::move(snapshot));
+        buffer.Flush();
+    }
+    REQUIRE(buffer.GetSnapshotCount() == 4);
+
+    // The newest snapshot is returned without waiting for the worker
+    buffer.Push(MakeSnapshot(4));
+    for (u32 i = 5; i-- > 0;) {
+        const auto snapshot = buffer.Pop();
+        REQUIRE(snapshot);
+        CHECK(*snapshot == MakeSnapshot(i));
+    }
+    CHECK(!buffer.Pop());
+    CHECK(buffer.GetCompressedSize() == 0);
+}
+
+TEST_CASE("RewindBuffer drops the oldest snapshots over budget", "[core]") {
+    // Two compressed snapshots, and the uncompressed one kept for taking the next
+    constexpr std::size_t budget = 0x3800;
+    RewindBuffer buffer{budget};
+    for (u32 i = 0; i < 8; ++i) {
+        std::vector<u8> snapshot = buffer.AcquireBuffer();
+        snapshot = MakeSnapshot(i);
+        buffer.Push(std::move(snapshot));
+        buffer.Flush();
+        CHECK(!buffer.IsCompressing());
+        CHECK(buffer.GetMemoryUsage() <= budget);
+    }
+    REQUIRE(buffer.GetSnapshotCount() == 2);
+    CHECK(*buffer.Pop() == MakeSnapshot(7));
+    CHECK(*buffer.Pop() == MakeSnapshot(6));
+
+    buffer.Push(MakeSnapshot(8));
+    buffer.Clear();
+    CHECK(buffer.GetSnapshotCount() == 0);
+    CHECK(!buffer.Pop());
+}
+
+TEST_CASE("RewindBuffer counts the uncompressed snapshots against the budget", "[core]") {
+    RewindBuffer buffer{0x2800};
+    buffer.Push(MakeSnapshot(0));
+    buffer.Flush();
+    REQUIRE(buffer.GetSnapshotCount() == 1);
+    CHECK(buffer.GetMemoryUsage() >= buffer.GetCompressedSize() + 0x1000);
+
+    // The compressed snapshot doesn't fit next to the uncompressed one
+    RewindBuffer small_buffer{0x1800};
+    small_buffer.Push(MakeSnapshot(0));
+    small_buffer.Flush();
+    CHECK(small_buffer.GetSnapshotCount() == 0);
+    CHECK(small_buffer.GetMemoryUsage() <= 0x1800);
+
+    // Not even the uncompressed one fits, so its storage isn't kept either
+    RewindBuffer tiny_buffer{0x800};
+    tiny_buffer.Push(MakeSnapshot(0));
+    tiny_buffer.Flush();
+    CHECK(tiny_buffer.GetSnapshotCount() == 0);
+    CHECK(tiny_buffer.GetMemoryUsage() == 0);
+}
+
+} // namespace Core
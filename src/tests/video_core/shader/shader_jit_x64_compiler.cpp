@@ -89,3 +89,31 @@ TEST_CASE("EX2", "[video_core][shader][shader_jit]") {
     REQUIRE(shader.Run(79.7262742773f) == Approx(1.e24f));
     REQUIRE(std::isinf(shader.Run(800.f)));
 }
+
+TEST_CASE("Loading compiled code", "[video_core][shader][shader_jit]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    auto shader = ShaderTest({
+        // clang-format off
+        {OpCode::Id::EX2, sh_output, sh_input},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    // The code is loaded at another host address, and must still find its prelude
+    auto loaded = std::make_unique<JitShader>();
+    REQUIRE(loaded->Load(shader.shader->GetCode(), shader.shader->GetInstructionOffsets()));
+    REQUIRE(loaded->GetCode() == shader.shader->GetCode());
+
+    const auto compiled_results = {shader.Run(0.f), shader.Run(2.f), shader.Run(-800.f)};
+    shader.shader = std::move(loaded);
+    const auto loaded_results = {shader.Run(0.f), shader.Run(2.f), shader.Run(-800.f)};
+    REQUIRE(std::equal(compiled_results.begin(), compiled_results.end(), loaded_results.begin()));
+
+    SECTION("offsets outside of the code are rejected") {
+        auto offsets = shader.shader->GetInstructionOffsets();
+        offsets[1] = static_cast<u32>(shader.shader->GetCode().size());
+        REQUIRE_FALSE(JitShader{}.Load(shader.shader->GetCode(), offsets));
+    }
+}
@@ -0,0 +1,95 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "video_core/shader/shader_jit_x64_disk_cache.h"
+
+using JitDiskCache = Pica::Shader::JitDiskCache;
+
+static JitDiskCache::Entry MakeEntry(u64 hash, u8 code_byte) {
+    JitDiskCache::Entry entry{hash, ~hash, std::vector<u8>(64, code_byte), {}};
+    for (std::size_t i = 0; i < entry.instruction_offsets.size(); ++i) {
+        entry.instruction_offsets[i] = static_cast<u32>(i % entry.code.size());
+    }
+    return entry;
+}
+
+static bool SameEntry(const JitDiskCache::Entry& a, const JitDiskCache::Entry& b) {
+    return a.program_code_hash == b.program_code_hash &&
+           a.swizzle_data_hash == b.swizzle_data_hash && a.code == b.code &&
+           a.instruction_offsets == b.instruction_offsets;
+}
+
+TEST_CASE("JitDiskCache", "[video_core][shader][shader_jit]") {
+    const std::string path = "shader_jit_x64_disk_cache_test.bin";
+    FileUtil::Delete(path);
+
+    const auto first = MakeEntry(1, 0xC3);
+    const auto second = MakeEntry(2, 0x90);
+    {
+        JitDiskCache cache(path);
+        REQUIRE(cache.Load().empty());
+        cache.Save(first);
+        cache.Save(second);
+    }
+
+    SECTION("saved entries are loaded in order") {
+        const auto entries = JitDiskCache(path).Load();
+        REQUIRE(entries.size() == 2);
+        CHECK(SameEntry(entries[0], first));
+        CHECK(SameEntry(entries[1], second));
+    }
+
+    SECTION("a corrupted entry is skipped with the rest of the file") {
+        {
+            FileUtil::IOFile file(path, "r+b");
+            // Flip a byte of the code of the second entry, which ends with 8 bytes of hash
+            file.Seek(-8 - 4 * static_cast<s64>(first.instruction_offsets.size()) - 1, SEEK_END);
+            const u8 corrupted = 0x00;
+            file.WriteObject(corrupted);
+        }
+        const auto entries = JitDiskCache(path).Load();
+        REQUIRE(entries.size() == 1);
+        CHECK(SameEntry(entries[0], first));
+    }
+
+    SECTION("a cache from an older version is removed") {
+        {
+            FileUtil::IOFile file(path, "r+b");
+            const u32 old_version = 1;
+            file.WriteObject(old_version);
+        }
+        CHECK(JitDiskCache(path).Load().empty());
+        CHECK_FALSE(FileUtil::Exists(path));
+    }
+
+    SECTION("a cache from another build is removed") {
+        {
+            FileUtil::IOFile file(path, "r+b");
+            file.Seek(sizeof(u32), SEEK_SET);
+            const u64 other_build = 0;
+            file.WriteObject(other_build);
+        }
+        CHECK(JitDiskCache(path).Load().empty());
+        CHECK_FALSE(FileUtil::Exists(path));
+    }
+
+    SECTION("a cache from a host with other CPU features is removed") {
+        {
+            FileUtil::IOFile file(path, "r+b");
+            file.Seek(sizeof(u32) + sizeof(u64), SEEK_SET);
+            u32 host_features{};
+            file.ReadBytes(&host_features, sizeof(host_features));
+            file.Seek(sizeof(u32) + sizeof(u64), SEEK_SET);
+            host_features ^= 1;
+            file.WriteObject(host_features);
+        }
+        CHECK(JitDiskCache(path).Load().empty());
+        CHECK_FALSE(FileUtil::Exists(path));
+    }
+
+    FileUtil::Delete(path);
+}
@@ -0,0 +1,98 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <catch2/catch.hpp>
+#include "video_core/swrasterizer/span.h"
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+using namespace Pica::Rasterizer;
+
+/// Straightforward evaluation of an edge function, the way the rasterizer used to do per pixel
+static s32 ReferenceWeight(const EdgeFunctions& edges, std::size_t edge, u32 x, u32 y) {
+    const u32 area = static_cast<u32>(edges.delta_x[edge]) * (y - edges.start_y[edge]) -
+                     static_cast<u32>(edges.delta_y[edge]) * (x - edges.start_x[edge]);
+    return static_cast<s32>(static_cast<u32>(edges.bias[edge]) + area);
+}
+
+static void CheckImplementation(SpanCoverageFunction compute_span_coverage, u16 max_coordinate) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<u32> coordinate(0, max_coordinate);
+    std::uniform_int_distribution<u32> span_length(1, SpanSize);
+
+    for (int iteration = 0; iteration < 10000; ++iteration) {
+        u32 vertex_x[3], vertex_y[3];
+        for (std::size_t i = 0; i < 3; ++i) {
+            vertex_x[i] = coordinate(rng);
+            vertex_y[i] = coordinate(rng);
+        }
+
+        EdgeFunctions edges;
+        for (std::size_t i = 0; i < 3; ++i) {
+            const std::size_t start = (i + 1) % 3;
+            const std::size_t end = (i + 2) % 3;
+            edges.start_x[i] = vertex_x[start];
+            edges.start_y[i] = vertex_y[start];
+            edges.delta_x[i] = vertex_x[end] - vertex_x[start];
+            edges.delta_y[i] = vertex_y[end] - vertex_y[start];
+            edges.bias[i] = -static_cast<s32>(rng() & 1);
+        }
+
+        const u32 x = (coordinate(rng) & ~0xF) + 8;
+        const u32 y = (coordinate(rng) & ~0xF) + 8;
+        const u32 count = span_length(rng);
+
+        SpanCoverage coverage;
+        compute_span_coverage(edges, x, y, count, coverage);
+
+        u32 expected_mask = 0;
+        for (u32 i = 0; i < count; ++i) {
+            bool covered = true;
+            for (std::size_t edge = 0; edge < 3; ++edge) {
+                const s32 weight = ReferenceWeight(edges, edge, x + (i << 4), y);
+                REQUIRE(coverage.weights[edge][i] == weight);
+                covered &= weight >= 0;
+            }
+            expected_mask |= static_cast<u32>(covered) << i;
+        }
+        REQUIRE(coverage.mask == expected_mask);
+    }
+}
+
+TEST_CASE("ComputeSpanCoverage", "[video_core][swrasterizer]") {
+    SECTION("small triangles") {
+        CheckImplementation(ComputeSpanCoverage, 0x400);
+    }
+    SECTION("overflowing triangles") {
+        CheckImplementation(ComputeSpanCoverage, 0xFFFF);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+TEST_CASE("ComputeSpanCoverageSSE41", "[video_core][swrasterizer]") {
+    if (!Common::GetCPUCaps().sse4_1) {
+        return;
+    }
+    SECTION("small triangles") {
+        CheckImplementation(ComputeSpanCoverageSSE41, 0x400);
+    }
+    SECTION("overflowing triangles") {
+        CheckImplementation(ComputeSpanCoverageSSE41, 0xFFFF);
+    }
+}
+
+TEST_CASE("ComputeSpanCoverageAVX2", "[video_core][swrasterizer]") {
+    if (!Common::GetCPUCaps().avx2) {
+        return;
+    }
+    SECTION("small triangles") {
+        CheckImplementation(ComputeSpanCoverageAVX2, 0x400);
+    }
+    SECTION("overflowing triangles") {
+        CheckImplementation(ComputeSpanCoverageAVX2, 0xFFFF);
+    }
+}
+#endif
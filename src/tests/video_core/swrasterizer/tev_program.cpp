@@ -0,0 +1,414 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <catch2/catch.hpp>
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/tev_program.h"
+#include "video_core/swrasterizer/texturing.h"
+
+using namespace Pica;
+using namespace Pica::Rasterizer;
+using TevStageConfig = TexturingRegs::TevStageConfig;
+using BlendFactor = FramebufferRegs::BlendFactor;
+using CompareFunc = FramebufferRegs::CompareFunc;
+using StencilOp = TevProgram::StencilOp;
+
+/// Evaluates the texture environment stage by stage, straight from the registers
+static Common::Vec4<u8> ReferenceTev(const TexturingRegs& regs, const TevInputs& inputs) {
+    using Source = TevStageConfig::Source;
+
+    const auto tev_stages = regs.GetTevStages();
+    Common::Vec4<u8> combiner_output = {0, 0, 0, 0};
+    Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
+    Common::Vec4<u8> next_combiner_buffer =
+        Common::MakeVec(regs.tev_combiner_buffer_color.r.Value(),
+                        regs.tev_combiner_buffer_color.g.Value(),
+                        regs.tev_combiner_buffer_color.b.Value(),
+                        regs.tev_combiner_buffer_color.a.Value())
+            .Cast<u8>();
+
+    for (unsigned index = 0; index < tev_stages.size(); ++index) {
+        const auto& stage = tev_stages[index];
+        const auto GetSource = [&](Source source) -> Common::Vec4<u8> {
+            switch (source) {
+            case Source::PrimaryColor:
+                return inputs.primary_color;
+            case Source::PrimaryFragmentColor:
+                return inputs.primary_fragment_color;
+            case Source::SecondaryFragmentColor:
+                return inputs.secondary_fragment_color;
+            case Source::Texture0:
+            case Source::Texture1:
+            case Source::Texture2:
+            case Source::Texture3:
+                return inputs.texture_color[static_cast<u32>(source) -
+                                            static_cast<u32>(Source::Texture0)];
+            case Source::PreviousBuffer:
+                return combiner_buffer;
+            case Source::Constant:
+                return Common::MakeVec(stage.const_r.Value(), stage.const_g.Value(),
+                                       stage.const_b.Value(), stage.const_a.Value())
+                    .Cast<u8>();
+            case Source::Previous:
+                return combiner_output;
+            default:
+                return {0, 0, 0, 0};
+            }
+        };
+
+        const Common::Vec3<u8> color_result[3] = {
+            GetColorModifier(stage.color_modifier1, GetSource(stage.color_source1)),
+            GetColorModifier(stage.color_modifier2, GetSource(stage.color_source2)),
+            GetColorModifier(stage.color_modifier3, GetSource(stage.color_source3)),
+        };
+        const auto color_output = ColorCombine(stage.color_op, color_result);
+
+        u8 alpha_output;
+        if (stage.color_op == TevStageConfig::Operation::Dot3_RGBA) {
+            alpha_output = color_output.x;
+        } else {
+            const std::array<u8, 3> alpha_result = {{
+                GetAlphaModifier(stage.alpha_modifier1, GetSource(stage.alpha_source1)),
+                GetAlphaModifier(stage.alpha_modifier2, GetSource(stage.alpha_source2)),
+                GetAlphaModifier(stage.alpha_modifier3, GetSource(stage.alpha_source3)),
+            }};
+            alpha_output = AlphaCombine(stage.alpha_op, alpha_result);
+        }
+
+        combiner_output[0] = std::min(255u, color_output.r() * stage.GetColorMultiplier());
+        combiner_output[1] = std::min(255u, color_output.g() * stage.GetColorMultiplier());
+        combiner_output[2] = std::min(255u, color_output.b() * stage.GetColorMultiplier());
+        combiner_output[3] = std::min(255u, alpha_output * stage.GetAlphaMultiplier());
+
+        combiner_buffer = next_combiner_buffer;
+        if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(index)) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+        if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(index)) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+    return combiner_output;
+}
+
+static void SetStage(TexturingRegs& regs, std::size_t index, const TevStageConfig& stage) {
+    TevStageConfig* const stages[] = {&regs.tev_stage0, &regs.tev_stage1, &regs.tev_stage2,
+                                      &regs.tev_stage3, &regs.tev_stage4, &regs.tev_stage5};
+    *stages[index] = stage;
+}
+
+TEST_CASE("TevProgram matches the per-stage evaluation", "[video_core][swrasterizer]") {
+    constexpr std::array<u32, 10> sources = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0xd, 0xe, 0xf};
+    constexpr std::array<u32, 10> color_modifiers = {0x0, 0x1, 0x2, 0x3, 0x4,
+                                                     0x5, 0x8, 0x9, 0xc, 0xd};
+
+    std::mt19937 rng(42);
+    const auto Pick = [&rng](const auto& values) { return values[rng() % values.size()]; };
+    const auto RandomColor = [&rng] {
+        return Common::MakeVec<u32>(rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF)
+            .Cast<u8>();
+    };
+
+    // There are more configurations than the cache keeps, so programs also get dropped
+    TevProgramCache cache;
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        Regs full_regs{};
+        auto& regs = full_regs.texturing;
+        for (std::size_t i = 0; i < 6; ++i) {
+            TevStageConfig stage{};
+            // Leave some stages as pass-through, which is what most games do
+            if (rng() % 3 != 0) {
+                stage.sources_raw = Pick(sources) | Pick(sources) << 4 | Pick(sources) << 8 |
+                                    Pick(sources) << 16 | Pick(sources) << 20 |
+                                    Pick(sources) << 24;
+                stage.modifiers_raw = Pick(color_modifiers) | Pick(color_modifiers) << 4 |
+                                      Pick(color_modifiers) << 8 | (rng() & 0x7) << 12 |
+                                      (rng() & 0x7) << 16 | (rng() & 0x7) << 20;
+                // Dot3 is not a valid alpha operation
+                stage.ops_raw = (rng() % 10) | (rng() % 6) << 16;
+                stage.scales_raw = (rng() & 0x3) | (rng() & 0x3) << 16;
+            } else {
+                stage.sources_raw = 0xF000F;
+            }
+            stage.const_color = rng();
+            SetStage(regs, i, stage);
+        }
+        regs.tev_combiner_buffer_input.update_mask_rgb.Assign(rng() & 0xF);
+        regs.tev_combiner_buffer_input.update_mask_a.Assign(rng() & 0xF);
+        regs.tev_combiner_buffer_color.raw = rng();
+
+        const TevProgram& program = cache.Get(full_regs);
+        const TevUniforms uniforms(full_regs);
+        SpanTevInputs span_inputs;
+        SpanColors span_results;
+        for (u32 fragment = 0; fragment < SpanSize; ++fragment) {
+            const TevInputs inputs{RandomColor(),
+                                   RandomColor(),
+                                   RandomColor(),
+                                   {{RandomColor(), RandomColor(), RandomColor(), RandomColor()}}};
+            const auto result = program.Run(inputs, uniforms);
+            const auto expected = ReferenceTev(regs, inputs);
+            REQUIRE(result.r() == expected.r());
+            REQUIRE(result.g() == expected.g());
+            REQUIRE(result.b() == expected.b());
+            REQUIRE(result.a() == expected.a());
+
+            span_results.Set(fragment, result);
+            span_inputs.primary_color.Set(fragment, inputs.primary_color);
+            span_inputs.primary_fragment_color.Set(fragment, inputs.primary_fragment_color);
+            span_inputs.secondary_fragment_color.Set(fragment, inputs.secondary_fragment_color);
+            for (std::size_t i = 0; i < inputs.texture_color.size(); ++i) {
+                span_inputs.texture_color[i].Set(fragment, inputs.texture_color[i]);
+            }
+        }
+
+        // The span gives the same result as running the fragments one at a time
+        SpanColors span_output;
+        program.RunSpan(span_inputs, uniforms, span_output);
+        REQUIRE(span_output.channels == span_results.channels);
+    }
+}
+
+/// Evaluates a test the way the rasterizer does it with the registers
+static bool ReferenceCompare(CompareFunc func, u32 value, u32 ref) {
+    switch (func) {
+    case CompareFunc::Never:
+        return false;
+    case CompareFunc::Always:
+        return true;
+    case CompareFunc::Equal:
+        return value == ref;
+    case CompareFunc::NotEqual:
+        return value != ref;
+    case CompareFunc::LessThan:
+        return value < ref;
+    case CompareFunc::LessThanOrEqual:
+        return value <= ref;
+    case CompareFunc::GreaterThan:
+        return value > ref;
+    case CompareFunc::GreaterThanOrEqual:
+        return value >= ref;
+    }
+    return false;
+}
+
+/// Blends a fragment straight from the registers
+static Common::Vec4<u8> ReferenceBlend(const Regs& regs, const Common::Vec4<u8>& source,
+                                       const Common::Vec4<u8>& dest) {
+    const auto& output_merger = regs.framebuffer.output_merger;
+    Common::Vec4<u8> blend_output = source;
+
+    if (output_merger.alphablend_enable) {
+        const auto params = output_merger.alpha_blending;
+        const Common::Vec4<u8> blend_const =
+            Common::MakeVec(output_merger.blend_const.r.Value(),
+                            output_merger.blend_const.g.Value(),
+                            output_merger.blend_const.b.Value(),
+                            output_merger.blend_const.a.Value())
+                .Cast<u8>();
+
+        const auto LookupFactor = [&](unsigned channel, BlendFactor factor) -> u8 {
+            switch (factor) {
+            case BlendFactor::Zero:
+                return 0;
+            case BlendFactor::One:
+                return 255;
+            case BlendFactor::SourceColor:
+                return source[channel];
+            case BlendFactor::OneMinusSourceColor:
+                return 255 - source[channel];
+            case BlendFactor::DestColor:
+                return dest[channel];
+            case BlendFactor::OneMinusDestColor:
+                return 255 - dest[channel];
+            case BlendFactor::SourceAlpha:
+                return source.a();
+            case BlendFactor::OneMinusSourceAlpha:
+                return 255 - source.a();
+            case BlendFactor::DestAlpha:
+                return dest.a();
+            case BlendFactor::OneMinusDestAlpha:
+                return 255 - dest.a();
+            case BlendFactor::ConstantColor:
+                return blend_const[channel];
+            case BlendFactor::OneMinusConstantColor:
+                return 255 - blend_const[channel];
+            case BlendFactor::ConstantAlpha:
+                return blend_const.a();
+            case BlendFactor::OneMinusConstantAlpha:
+                return 255 - blend_const.a();
+            case BlendFactor::SourceAlphaSaturate:
+                if (channel == 3)
+                    return 255;
+                return std::min(source.a(), static_cast<u8>(255 - dest.a()));
+            default:
+                return source[channel];
+            }
+        };
+
+        const auto srcfactor = Common::MakeVec(LookupFactor(0, params.factor_source_rgb),
+                                               LookupFactor(1, params.factor_source_rgb),
+                                               LookupFactor(2, params.factor_source_rgb),
+                                               LookupFactor(3, params.factor_source_a));
+        const auto dstfactor = Common::MakeVec(LookupFactor(0, params.factor_dest_rgb),
+                                               LookupFactor(1, params.factor_dest_rgb),
+                                               LookupFactor(2, params.factor_dest_rgb),
+                                               LookupFactor(3, params.factor_dest_a));
+
+        blend_output =
+            EvaluateBlendEquation(source, srcfactor, dest, dstfactor, params.blend_equation_rgb);
+        blend_output.a() =
+            EvaluateBlendEquation(source, srcfactor, dest, dstfactor, params.blend_equation_a).a();
+    } else {
+        blend_output = Common::MakeVec(LogicOp(source.r(), dest.r(), output_merger.logic_op),
+                                       LogicOp(source.g(), dest.g(), output_merger.logic_op),
+                                       LogicOp(source.b(), dest.b(), output_merger.logic_op),
+                                       LogicOp(source.a(), dest.a(), output_merger.logic_op));
+    }
+
+    return {
+        output_merger.red_enable ? blend_output.r() : dest.r(),
+        output_merger.green_enable ? blend_output.g() : dest.g(),
+        output_merger.blue_enable ? blend_output.b() : dest.b(),
+        output_merger.alpha_enable ? blend_output.a() : dest.a(),
+    };
+}
+
+TEST_CASE("TevProgram fragment operations match the register evaluation",
+          "[video_core][swrasterizer]") {
+    std::mt19937 rng(7);
+    const auto RandomColor = [&rng] {
+        return Common::MakeVec<u32>(rng() & 0xFF, rng() & 0xFF, rng() & 0xFF, rng() & 0xFF)
+            .Cast<u8>();
+    };
+    // Only the defined blend factors and equations, as others are unimplemented
+    const auto RandomFactor = [&rng] { return static_cast<BlendFactor>(rng() % 15); };
+    const auto RandomEquation = [&rng] {
+        return static_cast<FramebufferRegs::BlendEquation>(rng() % 5);
+    };
+
+    TevProgramCache cache;
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        Regs regs{};
+        auto& output_merger = regs.framebuffer.output_merger;
+        output_merger.alphablend_enable.Assign(rng() & 1);
+        output_merger.alpha_blending.blend_equation_rgb.Assign(RandomEquation());
+        output_merger.alpha_blending.blend_equation_a.Assign(RandomEquation());
+        output_merger.alpha_blending.factor_source_rgb.Assign(RandomFactor());
+        output_merger.alpha_blending.factor_dest_rgb.Assign(RandomFactor());
+        output_merger.alpha_blending.factor_source_a.Assign(RandomFactor());
+        output_merger.alpha_blending.factor_dest_a.Assign(RandomFactor());
+        output_merger.logic_op.Assign(static_cast<FramebufferRegs::LogicOp>(rng() & 0xF));
+        output_merger.blend_const.raw = rng();
+        regs.reg_array[PICA_REG_INDEX(framebuffer.output_merger.alpha_test)] = rng();
+        output_merger.stencil_test.raw_func = rng();
+        output_merger.stencil_test.raw_op = rng();
+        regs.reg_array[PICA_REG_INDEX(framebuffer.output_merger.depth_test_enable)] = rng();
+        regs.framebuffer.framebuffer.depth_format.Assign(
+            rng() & 1 ? FramebufferRegs::DepthFormat::D24S8 : FramebufferRegs::DepthFormat::D24);
+
+        const TevProgram& program = cache.Get(regs);
+        const TevUniforms uniforms(regs);
+        const auto& stencil_test = output_merger.stencil_test;
+        const bool stencil_enable =
+            stencil_test.enable &&
+            regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
+        REQUIRE(program.IsStencilEnabled() == stencil_enable);
+        REQUIRE(program.IsDepthTestEnabled() == (output_merger.depth_test_enable != 0));
+        REQUIRE(program.IsDepthWriteEnabled() == (output_merger.depth_write_enable != 0));
+
+        SpanColors span_source, span_dest, span_blended;
+        std::array<u32, SpanSize> span_z, span_ref_z;
+        u32 alpha_pass_mask = 0;
+        u32 depth_pass_mask = 0;
+        for (u32 fragment = 0; fragment < SpanSize; ++fragment) {
+            const auto source = RandomColor();
+            const auto dest = RandomColor();
+            // Small values make equal ones likely
+            const u8 stencil = static_cast<u8>(rng() & 0x3);
+            const u32 z = rng() & 0x3;
+            const u32 ref_z = rng() & 0x3;
+
+            span_source.Set(fragment, source);
+            span_dest.Set(fragment, dest);
+            span_z[fragment] = z;
+            span_ref_z[fragment] = ref_z;
+            if (program.AlphaTest(source.a(), uniforms))
+                alpha_pass_mask |= 1u << fragment;
+            if (program.DepthTest(z, ref_z))
+                depth_pass_mask |= 1u << fragment;
+            span_blended.Set(fragment, program.Blend(source, dest, uniforms));
+
+            const bool alpha_pass =
+                !output_merger.alpha_test.enable ||
+                ReferenceCompare(output_merger.alpha_test.func, source.a(),
+                                 output_merger.alpha_test.ref);
+            REQUIRE(program.AlphaTest(source.a(), uniforms) == alpha_pass);
+
+            const u8 ref = stencil_test.reference_value & stencil_test.input_mask;
+            REQUIRE(program.StencilTest(stencil, uniforms) ==
+                    ReferenceCompare(stencil_test.func, ref, stencil & stencil_test.input_mask));
+
+            const std::array<std::pair<StencilOp, FramebufferRegs::StencilAction>, 3> actions = {{
+                {StencilOp::StencilFail, stencil_test.action_stencil_fail},
+                {StencilOp::DepthFail, stencil_test.action_depth_fail},
+                {StencilOp::DepthPass, stencil_test.action_depth_pass},
+            }};
+            for (const auto& [op, action] : actions) {
+                const u8 new_stencil =
+                    PerformStencilAction(action, stencil, stencil_test.reference_value);
+                const u8 expected = (new_stencil & stencil_test.write_mask) |
+                                    (stencil & ~stencil_test.write_mask);
+                REQUIRE(program.UpdateStencil(op, stencil, uniforms) == expected);
+            }
+
+            REQUIRE(program.DepthTest(z, ref_z) ==
+                    ReferenceCompare(output_merger.depth_test_func, z, ref_z));
+
+            const auto result = program.Blend(source, dest, uniforms);
+            const auto expected = ReferenceBlend(regs, source, dest);
+            REQUIRE(result.r() == expected.r());
+            REQUIRE(result.g() == expected.g());
+            REQUIRE(result.b() == expected.b());
+            REQUIRE(result.a() == expected.a());
+        }
+
+        // The span functions give the same results as processing the fragments one at a time
+        REQUIRE(program.AlphaTestSpan(span_source.channels[3], uniforms) == alpha_pass_mask);
+        REQUIRE(program.DepthTestSpan(span_z, span_ref_z) == depth_pass_mask);
+        SpanColors span_output;
+        program.BlendSpan(span_source, span_dest, uniforms, span_output);
+        REQUIRE(span_output.channels == span_blended.channels);
+    }
+}
+
+TEST_CASE("TevProgramCache reuses the program of a configuration", "[video_core][swrasterizer]") {
+    Regs regs{};
+    regs.texturing.tev_stage0.sources_raw = 0x3;
+    regs.texturing.tev_stage0.const_color = 0x11223344;
+
+    TevProgramCache cache;
+    const TevProgram* const program = &cache.Get(regs);
+
+    // Constant colors and reference values are uniforms, so they don't need a new program
+    regs.texturing.tev_stage0.const_color = 0x55667788;
+    regs.framebuffer.output_merger.blend_const.raw = 0x99AABBCC;
+    regs.framebuffer.output_merger.alpha_test.ref.Assign(0x80);
+    regs.framebuffer.output_merger.stencil_test.reference_value.Assign(0x40);
+    REQUIRE(&cache.Get(regs) == program);
+
+    SECTION("a different texture environment") {
+        regs.texturing.tev_stage0.sources_raw = 0xE;
+        REQUIRE(&cache.Get(regs) != program);
+    }
+
+    SECTION("a different output merger configuration") {
+        regs.framebuffer.output_merger.alpha_test.enable.Assign(1);
+        REQUIRE(&cache.Get(regs) != program);
+    }
+}
@@ -0,0 +1,142 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/tev_program.h"
+#include "video_core/swrasterizer/tile_binner.h"
+#include "video_core/video_core.h"
+
+using namespace Pica;
+using namespace Pica::Rasterizer;
+using BlendFactor = FramebufferRegs::BlendFactor;
+using CompareFunc = FramebufferRegs::CompareFunc;
+using StencilAction = FramebufferRegs::StencilAction;
+
+namespace {
+
+// Neither is a multiple of the tile size, so the last row and column of tiles are partial
+constexpr u32 Width = 200;
+constexpr u32 Height = 120;
+constexpr PAddr ColorBufferAddress = Memory::VRAM_PADDR;
+constexpr PAddr DepthBufferAddress = Memory::VRAM_PADDR + Width * Height * 4;
+constexpr std::size_t BufferSize = Width * Height * 4;
+
+using Triangle = std::array<Vertex, 3>;
+
+/// Sets up blending, depth and stencil so that the result depends on the order of the triangles
+void SetupRegs() {
+    g_state.regs = {};
+
+    auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+    framebuffer.allow_color_write.Assign(0xF);
+    framebuffer.allow_depth_stencil_write.Assign(0x3);
+    framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+    framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24S8);
+    framebuffer.color_buffer_address.Assign(ColorBufferAddress / 8);
+    framebuffer.depth_buffer_address.Assign(DepthBufferAddress / 8);
+    framebuffer.width.Assign(Width);
+    framebuffer.height.Assign(Height - 1);
+
+    auto& output_merger = g_state.regs.framebuffer.output_merger;
+    output_merger.alphablend_enable.Assign(1);
+    output_merger.alpha_blending.factor_source_rgb.Assign(BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_dest_rgb.Assign(BlendFactor::OneMinusSourceAlpha);
+    output_merger.alpha_blending.factor_source_a.Assign(BlendFactor::One);
+    output_merger.alpha_blending.factor_dest_a.Assign(BlendFactor::One);
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(CompareFunc::LessThanOrEqual);
+    output_merger.depth_write_enable.Assign(1);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+    output_merger.stencil_test.enable.Assign(1);
+    output_merger.stencil_test.func.Assign(CompareFunc::Always);
+    output_merger.stencil_test.write_mask.Assign(0xFF);
+    output_merger.stencil_test.input_mask.Assign(0xFF);
+    output_merger.stencil_test.action_depth_fail.Assign(StencilAction::Increment);
+    output_merger.stencil_test.action_depth_pass.Assign(StencilAction::IncrementWrap);
+
+    // 1.0 as a float24
+    g_state.regs.rasterizer.viewport_depth_range.Assign(0x3F0000);
+    g_state.regs.lighting.disable.Assign(1);
+}
+
+/// Random triangles inside of the framebuffer, from single pixels to ones covering most of it
+std::vector<Triangle> MakeTriangles() {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Triangle> triangles;
+    for (int i = 0; i < 500; ++i) {
+        const float size = i % 10 == 0 ? 150.0f : 20.0f * unit(rng) + 0.5f;
+        const float center_x = unit(rng) * Width;
+        const float center_y = unit(rng) * Height;
+
+        Shader::OutputVertex vertex{};
+        Triangle triangle{vertex, vertex, vertex};
+        for (auto& v : triangle) {
+            const float x = std::clamp(center_x + (unit(rng) - 0.5f) * size, 0.0f,
+                                       static_cast<float>(Width));
+            const float y = std::clamp(center_y + (unit(rng) - 0.5f) * size, 0.0f,
+                                       static_cast<float>(Height));
+            v.screenpos = Common::MakeVec(float24::FromFloat32(x), float24::FromFloat32(y),
+                                          float24::FromFloat32(unit(rng)));
+            v.pos.w = float24::FromFloat32(1.0f);
+            v.color = Common::MakeVec(float24::FromFloat32(unit(rng)),
+                                      float24::FromFloat32(unit(rng)),
+                                      float24::FromFloat32(unit(rng)),
+                                      float24::FromFloat32(unit(rng)));
+        }
+        triangles.push_back(triangle);
+    }
+    return triangles;
+}
+
+void ClearBuffers(Memory::MemorySystem& memory) {
+    std::memset(memory.GetPhysicalPointer(ColorBufferAddress), 0x40, BufferSize);
+    std::memset(memory.GetPhysicalPointer(DepthBufferAddress), 0xFF, BufferSize);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("TileBinner output matches serial rasterization", "[video_core][swrasterizer]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    SetupRegs();
+
+    const auto triangles = MakeTriangles();
+    TevProgramCache tev_programs;
+    const TevProgram& tev_program = tev_programs.Get(g_state.regs);
+
+    ClearBuffers(memory);
+    for (const auto& triangle : triangles) {
+        ProcessTriangle(triangle[0], triangle[1], triangle[2], tev_program);
+    }
+    const u8* color_buffer = memory.GetPhysicalPointer(ColorBufferAddress);
+    const u8* depth_buffer = memory.GetPhysicalPointer(DepthBufferAddress);
+    const std::vector<u8> serial_color(color_buffer, color_buffer + BufferSize);
+    const std::vector<u8> serial_depth(depth_buffer, depth_buffer + BufferSize);
+
+    // Make sure that the triangles actually drew something to compare
+    REQUIRE(serial_color != std::vector<u8>(BufferSize, 0x40));
+
+    ClearBuffers(memory);
+    TileBinner binner(4);
+    for (const auto& triangle : triangles) {
+        binner.AddTriangle(triangle[0], triangle[1], triangle[2], tev_program);
+    }
+    binner.Flush();
+
+    REQUIRE(std::memcmp(color_buffer, serial_color.data(), BufferSize) == 0);
+    REQUIRE(std::memcmp(depth_buffer, serial_depth.data(), BufferSize) == 0);
+}
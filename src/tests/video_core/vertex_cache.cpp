@@ -0,0 +1,61 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+#include "video_core/vertex_cache.h"
+
+using namespace Pica;
+
+static Shader::AttributeBuffer MakeOutput(u32 vertex) {
+    Shader::AttributeBuffer output{};
+    output.attr[0].x = float24::FromFloat32(static_cast<float>(vertex));
+    return output;
+}
+
+static bool IsCached(const VertexCache& cache, u32 vertex) {
+    const auto* output = cache.Lookup(vertex);
+    return output && output->attr[0].x.ToFloat32() == static_cast<float>(vertex);
+}
+
+TEST_CASE("VertexCache", "[video_core][vertex_cache]") {
+    constexpr std::size_t num_entries = 64;
+    constexpr std::size_t num_sets = num_entries / VertexCache::Ways;
+    VertexCache cache(num_entries);
+
+    SECTION("lookups miss until the vertex is inserted") {
+        CHECK(cache.Lookup(5) == nullptr);
+        cache.Insert(5, MakeOutput(5));
+        CHECK(IsCached(cache, 5));
+        CHECK(cache.Lookup(5 + num_sets) == nullptr);
+    }
+
+    SECTION("a full cache keeps all its vertices") {
+        for (u32 vertex = 0; vertex < num_entries; ++vertex) {
+            cache.Insert(vertex, MakeOutput(vertex));
+        }
+        for (u32 vertex = 0; vertex < num_entries; ++vertex) {
+            CHECK(IsCached(cache, vertex));
+        }
+    }
+
+    SECTION("a full set evicts its oldest vertex") {
+        for (u32 way = 0; way <= VertexCache::Ways; ++way) {
+            cache.Insert(3 + way * num_sets, MakeOutput(3 + way * num_sets));
+        }
+        CHECK(cache.Lookup(3) == nullptr);
+        for (u32 way = 1; way <= VertexCache::Ways; ++way) {
+            CHECK(IsCached(cache, 3 + way * num_sets));
+        }
+    }
+
+    SECTION("invalidation drops all vertices") {
+        cache.Insert(1, MakeOutput(1));
+        cache.Insert(2, MakeOutput(2));
+        cache.Invalidate();
+        CHECK(cache.Lookup(1) == nullptr);
+        CHECK(cache.Lookup(2) == nullptr);
+        cache.Insert(2, MakeOutput(2));
+        CHECK(IsCached(cache, 2));
+    }
+}
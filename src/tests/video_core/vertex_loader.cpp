@@ -0,0 +1,152 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <catch2/catch.hpp>
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+#include "video_core/video_core.h"
+
+using namespace Pica;
+using Format = PipelineRegs::VertexAttributeFormat;
+
+namespace {
+
+struct TestVertex {
+    float position[3];
+    s16 normal[2];
+    u8 padding[4];
+    u8 color[4];
+    s8 weight;
+    u8 align[3];
+};
+static_assert(sizeof(TestVertex) == 28);
+
+constexpr TestVertex test_vertices[] = {
+    {{1.0f, 2.0f, 3.0f}, {-4, 5}, {}, {6, 7, 8, 255}, -9, {}},
+    {{-0.5f, 0.25f, 100.0f}, {32767, -32768}, {}, {0, 1, 2, 3}, 127, {}},
+    {{0.0f, -7.0f, 1024.0f}, {0, 1}, {}, {128, 64, 32, 16}, -128, {}},
+};
+
+PipelineRegs MakeRegs() {
+    PipelineRegs regs{};
+    auto& attributes = regs.vertex_attributes;
+    attributes.base_address.Assign(Memory::VRAM_PADDR / 16);
+    attributes.format0.Assign(Format::FLOAT);
+    attributes.size0.Assign(2);
+    attributes.format1.Assign(Format::SHORT);
+    attributes.size1.Assign(1);
+    attributes.format2.Assign(Format::UBYTE);
+    attributes.size2.Assign(3);
+    attributes.format3.Assign(Format::BYTE);
+    attributes.size3.Assign(0);
+    attributes.attribute_mask.Assign(1 << 4);
+    attributes.max_attribute_index.Assign(4);
+
+    auto& loader = attributes.attribute_loaders[0];
+    loader.data_offset.Assign(0);
+    loader.comp0.Assign(0);
+    loader.comp1.Assign(1);
+    loader.comp2.Assign(12); // 4 bytes of padding
+    loader.comp3.Assign(2);
+    loader.comp4.Assign(3);
+    loader.component_count.Assign(5);
+    loader.byte_count.Assign(sizeof(TestVertex));
+    return regs;
+}
+
+void CheckAttribute(const Common::Vec4<float24>& attr, float x, float y, float z, float w) {
+    CHECK(attr.x.ToFloat32() == float24::FromFloat32(x).ToFloat32());
+    CHECK(attr.y.ToFloat32() == float24::FromFloat32(y).ToFloat32());
+    CHECK(attr.z.ToFloat32() == float24::FromFloat32(z).ToFloat32());
+    CHECK(attr.w.ToFloat32() == float24::FromFloat32(w).ToFloat32());
+}
+
+} // Anonymous namespace
+
+TEST_CASE("VertexLoader::LoadVertices", "[video_core][vertex_loader]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    std::memcpy(memory.GetPhysicalPointer(Memory::VRAM_PADDR), test_vertices,
+                sizeof(test_vertices));
+
+    g_state.input_default_attributes.attr[4] = {float24::FromFloat32(0.5f),
+                                                float24::FromFloat32(1.5f),
+                                                float24::FromFloat32(2.5f),
+                                                float24::FromFloat32(3.5f)};
+
+    const PipelineRegs regs = MakeRegs();
+    const VertexLoader loader(regs);
+    REQUIRE(loader.GetNumTotalAttributes() == 5);
+
+    const unsigned int vertices[] = {2, 0, 1, 2};
+    Shader::AttributeBuffer inputs[4];
+    DebugUtils::MemoryAccessTracker memory_accesses;
+    loader.LoadVertices(regs, vertices, 4, inputs, memory_accesses);
+
+    for (std::size_t i = 0; i < 4; ++i) {
+        const auto& vertex = test_vertices[vertices[i]];
+        CheckAttribute(inputs[i].attr[0], vertex.position[0], vertex.position[1],
+                       vertex.position[2], 1.0f);
+        CheckAttribute(inputs[i].attr[1], vertex.normal[0], vertex.normal[1], 0.0f, 1.0f);
+        CheckAttribute(inputs[i].attr[2], vertex.color[0], vertex.color[1], vertex.color[2],
+                       vertex.color[3]);
+        CheckAttribute(inputs[i].attr[3], vertex.weight, 0.0f, 0.0f, 1.0f);
+        CheckAttribute(inputs[i].attr[4], 0.5f, 1.5f, 2.5f, 3.5f);
+    }
+
+    VideoCore::g_memory = nullptr;
+}
+
+TEST_CASE("VertexLoader::LoadVertices reads from the loader data offset",
+          "[video_core][vertex_loader]") {
+    Memory::MemorySystem memory;
+    VideoCore::g_memory = &memory;
+    std::memcpy(memory.GetPhysicalPointer(Memory::VRAM_PADDR), test_vertices,
+                sizeof(test_vertices));
+
+    PipelineRegs regs = MakeRegs();
+    const VertexLoader loader(regs);
+    // The loader is set up without looking at the data offset, which only moves the array
+    regs.vertex_attributes.attribute_loaders[0].data_offset.Assign(sizeof(TestVertex));
+
+    const unsigned int vertex = 1;
+    Shader::AttributeBuffer input;
+    DebugUtils::MemoryAccessTracker memory_accesses;
+    loader.LoadVertices(regs, &vertex, 1, &input, memory_accesses);
+
+    const auto& expected = test_vertices[2];
+    CheckAttribute(input.attr[0], expected.position[0], expected.position[1],
+                   expected.position[2], 1.0f);
+    CheckAttribute(input.attr[3], expected.weight, 0.0f, 0.0f, 1.0f);
+
+    VideoCore::g_memory = nullptr;
+}
+
+TEST_CASE("GetVertexLoader", "[video_core][vertex_loader]") {
+    PipelineRegs regs = MakeRegs();
+    const VertexLoader& loader = GetVertexLoader(regs);
+
+    SECTION("the base address is not part of the configuration") {
+        regs.vertex_attributes.base_address.Assign(Memory::FCRAM_PADDR / 16);
+        CHECK(&GetVertexLoader(regs) == &loader);
+    }
+
+    SECTION("the loader data offsets are not part of the configuration") {
+        regs.vertex_attributes.attribute_loaders[0].data_offset.Assign(0x1000);
+        CHECK(&GetVertexLoader(regs) == &loader);
+    }
+
+    SECTION("a different attribute layout gets a different loader") {
+        regs.vertex_attributes.attribute_loaders[0].component_count.Assign(4);
+        regs.vertex_attributes.max_attribute_index.Assign(3);
+        const VertexLoader& other = GetVertexLoader(regs);
+        CHECK(&other != &loader);
+        CHECK(other.GetNumTotalAttributes() == 4);
+        CHECK(&GetVertexLoader(MakeRegs()) == &loader);
+    }
+}
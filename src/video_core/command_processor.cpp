@@ -2,18 +2,22 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
 #include <memory>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -26,6 +30,7 @@
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_base.h"
 #include "video_core/shader/shader.h"
+#include "video_core/vertex_cache.h"
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
@@ -39,6 +44,165 @@ constexpr std::array<u32, 16> expand_bits_to_bytes{
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+/// Returns the configured vertex cache size, rounded down to a size the cache supports
+static std::size_t GetVertexCacheSize() {
+    const std::size_t configured = Settings::values.vertex_cache_size;
+    std::size_t size = VertexCache::Ways;
+    while (size * 2 <= configured) {
+        size *= 2;
+    }
+    if (size != configured) {
+        LOG_WARNING(HW_GPU, "Vertex cache size {} is not a power of two of at least {}, using {}",
+                    configured, VertexCache::Ways, size);
+    }
+    return size;
+}
+
+/**
+ * Post-transform cache for indexed draws. Each entry holds a full set of vertex shader outputs,
+ * so the size trades hit-rate for memory use. It is read from the settings when the cache is
+ * first used.
+ */
+static VertexCache& GetVertexCache() {
+    static VertexCache cache(GetVertexCacheSize());
+    return cache;
+}
+
+/// Returns whether writing the register can change the vertex shader output of a vertex
+static bool AffectsVertexShaderOutput(u32 id) {
+    switch (id) {
+    // Registers which only select the vertices of a draw, or what happens to them afterwards
+    case PICA_REG_INDEX(pipeline.index_array):
+    case PICA_REG_INDEX(pipeline.num_vertices):
+    case PICA_REG_INDEX(pipeline.vertex_offset):
+    case PICA_REG_INDEX(pipeline.trigger_draw):
+    case PICA_REG_INDEX(pipeline.trigger_draw_indexed):
+    case PICA_REG_INDEX(pipeline.command_buffer.size[0]):
+    case PICA_REG_INDEX(pipeline.command_buffer.size[1]):
+    case PICA_REG_INDEX(pipeline.command_buffer.addr[0]):
+    case PICA_REG_INDEX(pipeline.command_buffer.addr[1]):
+    case PICA_REG_INDEX(pipeline.command_buffer.trigger[0]):
+    case PICA_REG_INDEX(pipeline.command_buffer.trigger[1]):
+    case PICA_REG_INDEX(pipeline.gpu_mode):
+    case PICA_REG_INDEX(pipeline.triangle_topology):
+    case PICA_REG_INDEX(pipeline.restart_primitive):
+        return false;
+    default:
+        // The vertex input configuration and the vertex shader setup, including its uniforms
+        return (id >= PICA_REG_INDEX(pipeline) && id < PICA_REG_INDEX(gs)) ||
+               id >= PICA_REG_INDEX(vs);
+    }
+}
+
+// Draws with fewer vertices than this are shaded on the GPU thread, as waking up the worker
+// threads would take longer than shading them
+constexpr unsigned int PARALLEL_SHADING_MIN_VERTICES = 256;
+
+/// Returns whether the vertices of a draw should be shaded on the vertex shading thread pool
+static bool ShouldShadeInParallel(unsigned int num_vertices) {
+    if (!Settings::values.use_multithreaded_vertex_shading ||
+        num_vertices < PARALLEL_SHADING_MIN_VERTICES) {
+        return false;
+    }
+
+    // Memory access tracking and vertex shader breakpoints expect vertices to be loaded in order
+    if (g_debug_context) {
+        const auto event = static_cast<int>(DebugContext::Event::VertexShaderInvocation);
+        return !g_debug_context->recorder && !g_debug_context->breakpoints[event].enabled;
+    }
+    return true;
+}
+
+static Common::ThreadPool& GetVertexShadingPool() {
+    static Common::ThreadPool pool;
+    return pool;
+}
+
+/**
+ * Shades the vertices of a draw on the vertex shading thread pool, then submits them to the
+ * geometry pipeline in draw order. Indexed draws take vertices from the vertex cache when
+ * possible and shade every other distinct vertex only once.
+ * @returns The number of vertices which had to be shaded
+ */
+template <typename GetVertexFunc>
+static unsigned int ShadeAndSubmitInParallel(GetVertexFunc GetVertex, unsigned int num_vertices,
+                                             bool is_indexed, const VertexLoader& loader,
+                                             const Shader::ShaderEngine& shader_engine) {
+    // Number of vertices loaded together by VertexLoader::LoadVertices
+    constexpr std::size_t BATCH_SIZE = 8;
+    // Number of vertices a worker takes at once, to keep contention on the job counter low
+    constexpr std::size_t CHUNK_SIZE = 8 * BATCH_SIZE;
+    constexpr u32 NO_JOB = 0xFFFFFFFF;
+
+    // Reused between draws to avoid reallocating them. Indexed draws can only refer to the first
+    // 0x10000 vertices, which job_of_vertex is indexed by.
+    static std::vector<unsigned int> job_vertices;
+    static std::vector<Shader::AttributeBuffer> job_outputs;
+    static std::vector<const Shader::AttributeBuffer*> draw_outputs;
+    static std::vector<u32> job_of_vertex(0x10000, NO_JOB);
+
+    const auto& regs = g_state.regs;
+
+    job_vertices.clear();
+    if (job_outputs.size() < num_vertices) {
+        job_outputs.resize(num_vertices);
+    }
+    draw_outputs.resize(num_vertices);
+
+    // Find out which vertices have to be shaded. The vertex cache is not modified until all the
+    // vertices have been submitted, so the outputs it returns stay valid until then.
+    for (unsigned int index = 0; index < num_vertices; ++index) {
+        const unsigned int vertex = GetVertex(index);
+        if (is_indexed) {
+            if (const auto* cached = GetVertexCache().Lookup(vertex)) {
+                draw_outputs[index] = cached;
+                continue;
+            }
+            if (job_of_vertex[vertex] != NO_JOB) {
+                draw_outputs[index] = &job_outputs[job_of_vertex[vertex]];
+                continue;
+            }
+            job_of_vertex[vertex] = static_cast<u32>(job_vertices.size());
+        }
+        draw_outputs[index] = &job_outputs[job_vertices.size()];
+        job_vertices.push_back(vertex);
+    }
+
+    const std::size_t num_jobs = job_vertices.size();
+    const std::size_t num_chunks = (num_jobs + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    GetVertexShadingPool().ParallelFor(num_chunks, [&](std::size_t chunk) {
+        Shader::UnitState shader_unit;
+        std::array<Shader::AttributeBuffer, BATCH_SIZE> inputs;
+        DebugUtils::MemoryAccessTracker memory_accesses;
+
+        const std::size_t chunk_end = std::min(num_jobs, (chunk + 1) * CHUNK_SIZE);
+        for (std::size_t first = chunk * CHUNK_SIZE; first < chunk_end; first += BATCH_SIZE) {
+            const std::size_t count = std::min(BATCH_SIZE, chunk_end - first);
+            loader.LoadVertices(regs.pipeline, &job_vertices[first], count, inputs.data(),
+                                memory_accesses);
+            for (std::size_t i = 0; i < count; ++i) {
+                shader_unit.LoadInput(regs.vs, inputs[i]);
+                shader_engine.Run(g_state.vs, shader_unit);
+                shader_unit.WriteOutput(regs.vs, job_outputs[first + i]);
+            }
+        }
+    });
+
+    // Send to geometry pipeline
+    for (unsigned int index = 0; index < num_vertices; ++index) {
+        g_state.geometry_pipeline.SubmitVertex(*draw_outputs[index]);
+    }
+
+    if (is_indexed) {
+        for (std::size_t job = 0; job < num_jobs; ++job) {
+            GetVertexCache().Insert(job_vertices[job], job_outputs[job]);
+            job_of_vertex[job_vertices[job]] = NO_JOB;
+        }
+    }
+
+    return static_cast<unsigned int>(num_jobs);
+}
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
         return "vertex shader";
@@ -131,6 +295,10 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
     regs.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
 
+    if (AffectsVertexShaderOutput(id)) {
+        GetVertexCache().Invalidate();
+    }
+
     // Double check for is_pica_tracing to avoid call overhead
     if (DebugUtils::IsPicaTracing()) {
         DebugUtils::OnPicaRegWrite({(u16)id, (u16)mask, regs.reg_array[id]});
@@ -313,9 +481,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         // Processes information about internal vertex attributes to figure out how a vertex is
         // loaded.
-        // Later, these can be compiled and cached.
         const u32 base_address = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress();
-        VertexLoader loader(regs.pipeline);
+        const VertexLoader& loader = GetVertexLoader(regs.pipeline);
         Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
         // Load vertices
@@ -343,59 +510,57 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const std::size_t VERTEX_CACHE_SIZE = 32;
-        std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
-
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
 
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
         g_state.geometry_pipeline.Reconfigure();
         g_state.geometry_pipeline.Setup(shader_engine);
-        if (g_state.geometry_pipeline.NeedIndexInput())
-            ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+        const auto GetVertex = [&](unsigned int index) -> unsigned int {
             // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+            return is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                              : (index + regs.pipeline.vertex_offset);
+        };
 
-            bool vertex_cache_hit = false;
+        if (g_state.geometry_pipeline.NeedIndexInput()) {
+            ASSERT(is_indexed);
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                g_state.geometry_pipeline.SubmitIndex(GetVertex(index));
+            }
+        }
 
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
-                }
+        // With index input, the geometry shader loads and processes the vertices by itself
+        const unsigned int num_vertices =
+            g_state.geometry_pipeline.NeedIndexInput() ? 0 : regs.pipeline.num_vertices;
+        unsigned int num_shaded_vertices = 0;
+        if (ShouldShadeInParallel(num_vertices)) {
+            num_shaded_vertices = ShadeAndSubmitInParallel(GetVertex, num_vertices, is_indexed,
+                                                           loader, *shader_engine);
+        } else {
+            Shader::AttributeBuffer vs_output;
+            Shader::UnitState shader_unit;
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+            for (unsigned int index = 0; index < num_vertices; ++index) {
+                const unsigned int vertex = GetVertex(index);
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
+                if (is_indexed) {
+                    if (g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(
+                            base_address + index_info.offset + size * index, size);
+                    }
+
+                    if (const auto* cached = GetVertexCache().Lookup(vertex)) {
+                        // Send to geometry pipeline
+                        g_state.geometry_pipeline.SubmitVertex(*cached);
+                        continue;
                     }
                 }
-            }
 
-            if (!vertex_cache_hit) {
                 // Initialize data for the current vertex
                 Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                loader.LoadVertices(regs.pipeline, &vertex, 1, &input, memory_accesses);
 
                 // Send to vertex shader
                 if (g_debug_context)
@@ -404,17 +569,20 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                 shader_unit.LoadInput(regs.vs, input);
                 shader_engine->Run(g_state.vs, shader_unit);
                 shader_unit.WriteOutput(regs.vs, vs_output);
+                ++num_shaded_vertices;
 
                 if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    GetVertexCache().Insert(vertex, vs_output);
                 }
+
+                // Send to geometry pipeline
+                g_state.geometry_pipeline.SubmitVertex(vs_output);
             }
+        }
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+        if (is_indexed) {
+            MICROPROFILE_META_CPU("Vertex Cache Hits", num_vertices - num_shaded_vertices);
+            MICROPROFILE_META_CPU("Vertex Cache Misses", num_shaded_vertices);
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -647,6 +815,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
 void ProcessCommandList(PAddr list, u32 size) {
 
+    // Vertex data may have been changed since the last command list
+    GetVertexCache().Invalidate();
+
     u32* buffer = (u32*)VideoCore::g_memory->GetPhysicalPointer(list);
 
     if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
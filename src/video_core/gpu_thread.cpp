@@ -0,0 +1,89 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "video_core/gpu_thread.h"
+
+namespace VideoCore {
+
+GPUThread::GPUThread() {
+    thread = std::thread(&GPUThread::ThreadLoop, this);
+}
+
+GPUThread::~GPUThread() {
+    {
+        std::lock_guard lock{command_mutex};
+        stop = true;
+    }
+    command_cv.notify_one();
+    thread.join();
+}
+
+void GPUThread::PushCommand(std::function<void()> command) {
+    {
+        std::lock_guard lock{command_mutex};
+        commands.push_back(std::move(command));
+    }
+    command_cv.notify_one();
+}
+
+void GPUThread::DeferToEmuThread(std::function<void()> callback) {
+    std::lock_guard lock{deferred_mutex};
+    deferred.push_back(std::move(callback));
+}
+
+void GPUThread::WaitIdle() {
+    if (IsGPUThread()) {
+        return;
+    }
+
+    {
+        std::unique_lock lock{command_mutex};
+        idle_cv.wait(lock, [this] { return commands.empty() && !busy; });
+    }
+    ProcessDeferred();
+}
+
+void GPUThread::ProcessDeferred() {
+    std::vector<std::function<void()>> callbacks;
+    {
+        std::lock_guard lock{deferred_mutex};
+        callbacks.swap(deferred);
+    }
+    for (auto& callback : callbacks) {
+        callback();
+    }
+}
+
+void GPUThread::ThreadLoop() {
+    Common::SetCurrentThreadName("GPUThread");
+    MicroProfileOnThreadCreate("GPUThread");
+
+    std::unique_lock lock{command_mutex};
+    while (true) {
+        command_cv.wait(lock, [this] { return stop || !commands.empty(); });
+        if (commands.empty()) {
+            // Only reachable when stopping, all remaining work has been drained
+            break;
+        }
+
+        auto command = std::move(commands.front());
+        commands.pop_front();
+        busy = true;
+        lock.unlock();
+
+        command();
+
+        lock.lock();
+        busy = false;
+        if (commands.empty()) {
+            idle_cv.notify_all();
+        }
+    }
+
+    MicroProfileOnThreadExit();
+}
+
+} // namespace VideoCore
@@ -0,0 +1,64 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/**
+ * Worker thread that executes GPU operations (PICA command lists, display transfers and memory
+ * fills) asynchronously to the emulated CPU. Operations are executed in the order they were
+ * pushed. Anything the GPU thread needs to signal back to the emulated system, like interrupts, is
+ * deferred and run on the emulation thread once it synchronizes with the GPU thread.
+ */
+class GPUThread : NonCopyable {
+public:
+    GPUThread();
+    ~GPUThread();
+
+    /// Queues an operation for execution on the GPU thread
+    void PushCommand(std::function<void()> command);
+
+    /// Queues a callback that has to be run on the emulation thread
+    void DeferToEmuThread(std::function<void()> callback);
+
+    /**
+     * Blocks until all queued operations have been executed and then runs the deferred callbacks.
+     * Calling this from the GPU thread itself is a no-op.
+     */
+    void WaitIdle();
+
+    /// Runs the callbacks deferred by already completed operations, without blocking
+    void ProcessDeferred();
+
+    /// Returns whether the caller is running on the GPU thread
+    bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread.get_id();
+    }
+
+private:
+    void ThreadLoop();
+
+    std::thread thread;
+
+    std::mutex command_mutex;
+    std::condition_variable command_cv;
+    std::condition_variable idle_cv;
+    std::deque<std::function<void()>> commands;
+    bool busy = false;
+    bool stop = false;
+
+    std::mutex deferred_mutex;
+    std::vector<std::function<void()>> deferred;
+};
+
+} // namespace VideoCore
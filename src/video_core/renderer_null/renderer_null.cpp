@@ -0,0 +1,58 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "core/tracer/recorder.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/renderer_null/renderer_null.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+RendererNull::RendererNull(Frontend::EmuWindow& window) : RendererBase{window} {}
+
+RendererNull::~RendererNull() = default;
+
+VideoCore::ResultStatus RendererNull::Init() {
+    // Only the software rasterizer can run without a graphics context
+    if (g_hw_renderer_enabled) {
+        LOG_WARNING(Render, "Hardware renderer requested with the null renderer, "
+                            "falling back to the software rasterizer");
+        g_hw_renderer_enabled = false;
+    }
+
+    RefreshRasterizerSetting();
+
+    return VideoCore::ResultStatus::Success;
+}
+
+void RendererNull::ShutDown() {}
+
+void RendererNull::SwapBuffers() {
+    if (g_renderer_screenshot_requested) {
+        LOG_ERROR(Render, "Screenshots are not supported by the null renderer");
+        g_renderer_screenshot_requested = false;
+    }
+
+    m_current_frame++;
+
+    auto& system = Core::System::GetInstance();
+    system.perf_stats->EndSystemFrame();
+
+    render_window.PollEvents();
+
+    system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    system.perf_stats->BeginSystemFrame();
+
+    RefreshRasterizerSetting();
+
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+        Pica::g_debug_context->recorder->FrameFinished();
+    }
+}
+
+} // namespace VideoCore
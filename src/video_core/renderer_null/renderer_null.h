@@ -0,0 +1,40 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "video_core/renderer_base.h"
+
+namespace VideoCore {
+
+/**
+ * Renderer that never presents anything. Emulation still goes through the software rasterizer, so
+ * the guest framebuffers are fully rendered to emulated memory, but no host graphics context is
+ * required. This is used for headless runs (e.g. benchmarking on machines without a GPU).
+ */
+class RendererNull : public RendererBase {
+public:
+    explicit RendererNull(Frontend::EmuWindow& window);
+    ~RendererNull() override;
+
+    /// Initialize the renderer
+    VideoCore::ResultStatus Init() override;
+
+    /// Shutdown the renderer
+    void ShutDown() override;
+
+    /// Finalizes the guest frame, without presenting it anywhere
+    void SwapBuffers() override;
+
+    /// There is nothing to present, so this is a no-op
+    void TryPresent(int timeout_ms) override {}
+
+    /// Video dumping is not supported without a graphics context
+    void PrepareVideoDumping() override {}
+
+    /// Video dumping is not supported without a graphics context
+    void CleanupVideoDumping() override {}
+};
+
+} // namespace VideoCore
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_x64.h"
@@ -9,8 +10,20 @@
 
 namespace Pica::Shader {
 
-JitX64Engine::JitX64Engine() = default;
-JitX64Engine::~JitX64Engine() = default;
+MICROPROFILE_DEFINE(GPU_ShaderCompile, "GPU", "Shader Compile", MP_RGB(150, 50, 240));
+
+JitX64Engine::JitX64Engine() {
+    // The programs the title used last time are only loaded once it uses them again
+    for (auto& entry : disk_cache.Load()) {
+        const u64 cache_key = entry.program_code_hash ^ entry.swizzle_data_hash;
+        stored_programs.insert_or_assign(cache_key, std::move(entry));
+    }
+}
+
+JitX64Engine::~JitX64Engine() {
+    LOG_INFO(HW_GPU, "Shader JIT cache: {} hits, {} loaded from disk, {} compiled", cache_hits,
+             disk_cache_loads, cache_misses);
+}
 
 void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
@@ -22,10 +35,24 @@ void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     u64 cache_key = code_hash ^ swizzle_hash;
     auto iter = cache.find(cache_key);
     if (iter != cache.end()) {
+        ++cache_hits;
         setup.engine_data.cached_shader = iter->second.get();
     } else {
         auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
+        const auto stored = stored_programs.find(cache_key);
+        if (stored != stored_programs.end() &&
+            shader->Load(stored->second.code, stored->second.instruction_offsets)) {
+            ++disk_cache_loads;
+        } else {
+            MICROPROFILE_SCOPE(GPU_ShaderCompile);
+            ++cache_misses;
+            shader->Compile(&setup.program_code, &setup.swizzle_data);
+            disk_cache.Save({code_hash, swizzle_hash, shader->GetCode(),
+                             shader->GetInstructionOffsets()});
+        }
+        if (stored != stored_programs.end()) {
+            stored_programs.erase(stored);
+        }
         setup.engine_data.cached_shader = shader.get();
         cache.emplace_hint(iter, cache_key, std::move(shader));
     }
@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include "common/common_types.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_x64_disk_cache.h"
 
 namespace Pica::Shader {
 
@@ -23,6 +24,16 @@ public:
 
 private:
     std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+    JitDiskCache disk_cache;
+    /// Programs from the disk cache that haven't been used yet in this run
+    std::unordered_map<u64, JitDiskCache::Entry> stored_programs;
+
+    /// Number of SetupBatch calls that found the shader already compiled
+    u64 cache_hits = 0;
+    /// Number of SetupBatch calls that loaded the shader from the disk cache
+    u64 disk_cache_loads = 0;
+    /// Number of SetupBatch calls that had to compile the shader
+    u64 cache_misses = 0;
 };
 
 } // namespace Pica::Shader
@@ -164,11 +164,24 @@ static void LogCritical(const char* msg) {
 
 void JitShader::Compile_Assert(bool condition, const char* msg) {
     if (!condition) {
-        mov(ABI_PARAM1, reinterpret_cast<std::size_t>(msg));
-        CallFarFunction(*this, LogCritical);
+        Compile_LogCritical(msg);
     }
 }
 
+void JitShader::Compile_LogCritical(const char* msg) {
+    // The message is copied into the code, so that it doesn't refer to a host address
+    Label message, end;
+    lea(ABI_PARAM1, ptr[rip + message]);
+    call(qword[rip + log_critical_address]);
+    jmp(end, T_NEAR);
+    L(message);
+    for (const char* c = msg; *c != '\0'; ++c) {
+        db(*c);
+    }
+    db(0);
+    L(end);
+}
+
 /**
  * Loads and swizzles a source register into the specified XMM register.
  * @param instr VS instruction, used for determining how to load the source register
@@ -788,8 +801,7 @@ void JitShader::Compile_EMIT(Instruction instr) {
     jnz(have_emitter);
 
     ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
-    mov(ABI_PARAM1, reinterpret_cast<std::size_t>("Execute EMIT on VS"));
-    CallFarFunction(*this, LogCritical);
+    Compile_LogCritical("Execute EMIT on VS");
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
     jmp(end);
 
@@ -798,7 +810,7 @@ void JitShader::Compile_EMIT(Instruction instr) {
     mov(ABI_PARAM1, rax);
     mov(ABI_PARAM2, STATE);
     add(ABI_PARAM2, static_cast<Xbyak::uint32>(offsetof(UnitState, registers.output)));
-    CallFarFunction(*this, Emit);
+    call(qword[rip + emit_address]);
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
     L(end);
 }
@@ -810,8 +822,7 @@ void JitShader::Compile_SETE(Instruction instr) {
     jnz(have_emitter);
 
     ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
-    mov(ABI_PARAM1, reinterpret_cast<std::size_t>("Execute SETEMIT on VS"));
-    CallFarFunction(*this, LogCritical);
+    Compile_LogCritical("Execute SETEMIT on VS");
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
     jmp(end);
 
@@ -920,14 +931,10 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     mov(COND1, byte[STATE + offsetof(UnitState, conditional_code[1])]);
 
     // Used to set a register to one
-    static const __m128 one = {1.f, 1.f, 1.f, 1.f};
-    mov(rax, reinterpret_cast<std::size_t>(&one));
-    movaps(ONE, xword[rax]);
+    movaps(ONE, xword[rip + one_vector]);
 
     // Used to negate registers
-    static const __m128 neg = {-0.f, -0.f, -0.f, -0.f};
-    mov(rax, reinterpret_cast<std::size_t>(&neg));
-    movaps(NEGBIT, xword[rax]);
+    movaps(NEGBIT, xword[rip + negative_zero_vector]);
 
     // Jump to start of the shader program
     jmp(ABI_PARAM3);
@@ -935,6 +942,11 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     // Compile entire program
     Compile_Block(static_cast<unsigned>(program_code->size()));
 
+    for (std::size_t i = 0; i < instruction_offsets.size(); ++i) {
+        instruction_offsets[i] = static_cast<u32>(instruction_labels[i].getAddress() -
+                                                  reinterpret_cast<const u8*>(program));
+    }
+
     // Free memory that's no longer needed
     program_code = nullptr;
     swizzle_data = nullptr;
@@ -947,15 +959,60 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     LOG_DEBUG(HW_GPU, "Compiled shader size={}", getSize());
 }
 
+std::vector<u8> JitShader::GetCode() const {
+    const auto begin = reinterpret_cast<const u8*>(program);
+    return std::vector<u8>(begin, getCurr());
+}
+
+bool JitShader::Load(const std::vector<u8>& code,
+                     const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& instruction_offsets_) {
+    if (getSize() + code.size() > MAX_SHADER_SIZE ||
+        std::any_of(instruction_offsets_.begin(), instruction_offsets_.end(),
+                    [&](u32 offset) { return offset >= code.size(); })) {
+        return false;
+    }
+
+    // The prelude was emitted by the constructor at the same offset as in the run that compiled
+    // the program, so the code finds its constants and host addresses at the same place
+    program = (CompiledShader*)getCurr();
+    for (const u8 byte : code) {
+        db(byte);
+    }
+    instruction_offsets = instruction_offsets_;
+
+    ready();
+    return true;
+}
+
 JitShader::JitShader() : Xbyak::CodeGenerator(MAX_SHADER_SIZE) {
     CompilePrelude();
 }
 
 void JitShader::CompilePrelude() {
+    CompilePrelude_Constants();
     log2_subroutine = CompilePrelude_Log2();
     exp2_subroutine = CompilePrelude_Exp2();
 }
 
+void JitShader::CompilePrelude_Constants() {
+    // Programs only refer to host addresses through this table, which is emitted again with the
+    // addresses of the current run. This keeps them valid when loaded from the disk cache.
+    log_critical_address = getCurr();
+    dq(reinterpret_cast<u64>(&LogCritical));
+    emit_address = getCurr();
+    dq(reinterpret_cast<u64>(&Emit));
+
+    align(16);
+    one_vector = getCurr();
+    for (int i = 0; i < 4; ++i) {
+        dd(0x3f800000); // 1.0f
+    }
+    negative_zero_vector = getCurr();
+    for (int i = 0; i < 4; ++i) {
+        dd(0x80000000); // -0.0f
+    }
+}
+
 Xbyak::Label JitShader::CompilePrelude_Log2() {
     Xbyak::Label subroutine;
 
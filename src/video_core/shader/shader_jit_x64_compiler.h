@@ -33,12 +33,31 @@ public:
     JitShader();
 
     void Run(const ShaderSetup& setup, UnitState& state, unsigned offset) const {
-        program(&setup.uniforms, &state, instruction_labels[offset].getAddress());
+        program(&setup.uniforms, &state,
+                reinterpret_cast<const u8*>(program) + instruction_offsets[offset]);
     }
 
     void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
                  const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
 
+    /**
+     * Returns the code of the compiled program. It only refers to itself and to the prelude, which
+     * every JitShader emits the same way, so it can be loaded by another one, even in a later run.
+     */
+    std::vector<u8> GetCode() const;
+
+    /// Returns the offset in the code of each PICA instruction
+    const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& GetInstructionOffsets() const {
+        return instruction_offsets;
+    }
+
+    /**
+     * Loads a program returned by GetCode instead of compiling one. Returns false if the code
+     * doesn't fit or an offset is outside of it.
+     */
+    bool Load(const std::vector<u8>& code,
+              const std::array<u32, MAX_PROGRAM_CODE_LENGTH>& instruction_offsets);
+
     void Compile_ADD(Instruction instr);
     void Compile_DP3(Instruction instr);
     void Compile_DP4(Instruction instr);
@@ -100,6 +119,9 @@ private:
      */
     void Compile_Assert(bool condition, const char* msg);
 
+    /// Emits a call that logs the given message
+    void Compile_LogCritical(const char* msg);
+
     /**
      * Analyzes the entire shader program for `CALL` instructions before emitting any code,
      * identifying the locations where a return needs to be inserted.
@@ -110,6 +132,7 @@ private:
      * Emits data and code for utility functions.
      */
     void CompilePrelude();
+    void CompilePrelude_Constants();
     Xbyak::Label CompilePrelude_Log2();
     Xbyak::Label CompilePrelude_Exp2();
 
@@ -119,6 +142,9 @@ private:
     /// Mapping of Pica VS instructions to pointers in the emitted code
     std::array<Xbyak::Label, MAX_PROGRAM_CODE_LENGTH> instruction_labels;
 
+    /// Offsets of the Pica VS instructions from the start of the program
+    std::array<u32, MAX_PROGRAM_CODE_LENGTH> instruction_offsets{};
+
     /// Label pointing to the end of the current LOOP block. Used by the BREAKC instruction to break
     /// out of the loop.
     std::optional<Xbyak::Label> loop_break_label;
@@ -134,6 +160,12 @@ private:
 
     Xbyak::Label log2_subroutine;
     Xbyak::Label exp2_subroutine;
+
+    /// Prelude entries holding the host addresses of LogCritical and Emit
+    const void* log_critical_address = nullptr;
+    const void* emit_address = nullptr;
+    const void* one_vector = nullptr;
+    const void* negative_zero_vector = nullptr;
 };
 
 } // namespace Pica::Shader
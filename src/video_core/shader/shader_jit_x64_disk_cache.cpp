@@ -0,0 +1,193 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/x64/cpu_detect.h"
+#include "core/core.h"
+#include "core/loader/loader.h"
+#include "core/settings.h"
+#include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/shader/shader_jit_x64_disk_cache.h"
+
+namespace Pica::Shader {
+
+constexpr u32 NativeVersion = 3;
+
+/**
+ * The host CPU features that JitShader emits different code for. Code from a host with other
+ * features may use unsupported instructions, or put the prelude at other offsets.
+ */
+static u32 GetHostFeatures() {
+    const auto& caps = Common::GetCPUCaps();
+    return (caps.sse4_1 ? 1u : 0u);
+}
+
+/// Identifies the build and host that emitted the code, as both change the code of a program
+static u64 GetVersionHash() {
+    const u32 host_features = GetHostFeatures();
+    return Common::ComputeHash64(Common::g_shader_jit_cache_version,
+                                 std::strlen(Common::g_shader_jit_cache_version)) ^
+           Common::ComputeHash64(&host_features, sizeof(host_features));
+}
+
+static u64 GetEntryHash(const JitDiskCache::Entry& entry) {
+    return Common::ComputeHash64(entry.code.data(), entry.code.size()) ^
+           Common::ComputeHash64(entry.instruction_offsets.data(),
+                                 sizeof(entry.instruction_offsets));
+}
+
+static bool ReadEntry(FileUtil::IOFile& file, JitDiskCache::Entry& entry) {
+    u32 code_size{};
+    if (file.ReadBytes(&entry.program_code_hash, sizeof(u64)) != sizeof(u64) ||
+        file.ReadBytes(&entry.swizzle_data_hash, sizeof(u64)) != sizeof(u64) ||
+        file.ReadBytes(&code_size, sizeof(code_size)) != sizeof(code_size) ||
+        code_size > MAX_SHADER_SIZE) {
+        return false;
+    }
+    entry.code.resize(code_size);
+    u64 entry_hash{};
+    return file.ReadBytes(entry.code.data(), code_size) == code_size &&
+           file.ReadArray(entry.instruction_offsets.data(), entry.instruction_offsets.size()) ==
+               entry.instruction_offsets.size() &&
+           file.ReadBytes(&entry_hash, sizeof(entry_hash)) == sizeof(entry_hash) &&
+           entry_hash == GetEntryHash(entry);
+}
+
+static bool WriteEntry(FileUtil::IOFile& file, const JitDiskCache::Entry& entry) {
+    const u32 code_size = static_cast<u32>(entry.code.size());
+    return file.WriteObject(entry.program_code_hash) == 1 &&
+           file.WriteObject(entry.swizzle_data_hash) == 1 && file.WriteObject(code_size) == 1 &&
+           file.WriteBytes(entry.code.data(), code_size) == code_size &&
+           file.WriteArray(entry.instruction_offsets.data(), entry.instruction_offsets.size()) ==
+               entry.instruction_offsets.size() &&
+           file.WriteObject(GetEntryHash(entry)) == 1;
+}
+
+JitDiskCache::JitDiskCache() {
+    if (!Settings::values.use_disk_shader_cache) {
+        return;
+    }
+
+    u64 program_id{};
+    if (Core::System::GetInstance().GetAppLoader().ReadProgramId(program_id) !=
+            Loader::ResultStatus::Success ||
+        program_id == 0) {
+        return;
+    }
+
+    path = FileUtil::SanitizePath(FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir) +
+                                  DIR_SEP "x64_jit" DIR_SEP +
+                                  fmt::format("{:016X}.bin", program_id));
+    enabled = true;
+}
+
+JitDiskCache::JitDiskCache(std::string path) : enabled(true), path(std::move(path)) {}
+
+std::vector<JitDiskCache::Entry> JitDiskCache::Load() {
+    if (!enabled) {
+        return {};
+    }
+
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        LOG_INFO(HW_GPU, "No shader JIT cache found in path={}", path);
+        return {};
+    }
+
+    u32 version{};
+    if (file.ReadBytes(&version, sizeof(version)) != sizeof(version)) {
+        LOG_ERROR(HW_GPU, "Failed to get shader JIT cache version in path={} - skipping", path);
+        return {};
+    }
+    if (version < NativeVersion) {
+        LOG_INFO(HW_GPU, "Shader JIT cache is old - removing");
+        file.Close();
+        Invalidate();
+        return {};
+    }
+    if (version > NativeVersion) {
+        LOG_WARNING(HW_GPU, "Shader JIT cache was generated with a newer version of the emulator "
+                            "- skipping");
+        return {};
+    }
+
+    u64 version_hash{};
+    u32 host_features{};
+    if (file.ReadBytes(&version_hash, sizeof(version_hash)) != sizeof(version_hash) ||
+        file.ReadBytes(&host_features, sizeof(host_features)) != sizeof(host_features)) {
+        LOG_ERROR(HW_GPU, "Failed to read shader JIT cache header in path={} - removing", path);
+        file.Close();
+        Invalidate();
+        return {};
+    }
+    if (host_features != GetHostFeatures()) {
+        LOG_INFO(HW_GPU, "Shader JIT cache was emitted for a CPU with other features - removing");
+        file.Close();
+        Invalidate();
+        return {};
+    }
+    if (version_hash != GetVersionHash()) {
+        LOG_INFO(HW_GPU, "Shader JIT cache is from another version of the emulator - removing");
+        file.Close();
+        Invalidate();
+        return {};
+    }
+
+    std::vector<Entry> entries;
+    while (file.Tell() < file.GetSize()) {
+        // The hash of each entry makes sure a corrupted one can't be loaded as code
+        if (!ReadEntry(file, entries.emplace_back())) {
+            LOG_ERROR(HW_GPU, "Failed to read shader JIT cache entry - skipping the rest");
+            entries.pop_back();
+            break;
+        }
+    }
+
+    LOG_INFO(HW_GPU, "Found a shader JIT cache with {} entries", entries.size());
+    return entries;
+}
+
+void JitDiskCache::Save(const Entry& entry) {
+    if (!enabled) {
+        return;
+    }
+
+    const bool existed = FileUtil::Exists(path);
+    if (!existed && !FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(HW_GPU, "Failed to create shader JIT cache directory");
+        enabled = false;
+        return;
+    }
+
+    FileUtil::IOFile file(path, "ab");
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Failed to open shader JIT cache in path={}", path);
+        enabled = false;
+        return;
+    }
+
+    if ((!existed &&
+         (file.WriteObject(NativeVersion) != 1 || file.WriteObject(GetVersionHash()) != 1 ||
+          file.WriteObject(GetHostFeatures()) != 1)) ||
+        !WriteEntry(file, entry)) {
+        LOG_ERROR(HW_GPU, "Failed to write shader JIT cache entry - removing");
+        file.Close();
+        Invalidate();
+        enabled = false;
+    }
+}
+
+void JitDiskCache::Invalidate() {
+    if (!FileUtil::Delete(path)) {
+        LOG_ERROR(HW_GPU, "Failed to invalidate shader JIT cache file={}", path);
+    }
+}
+
+} // namespace Pica::Shader
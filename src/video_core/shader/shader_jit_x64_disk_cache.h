@@ -0,0 +1,57 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica::Shader {
+
+/**
+ * Keeps a per-title record on disk of the code the x64 shader JIT has emitted, so that the next
+ * boot of the same title can load its programs instead of compiling them mid-game. The code only
+ * reaches host addresses through the prelude of its JitShader, so it stays valid between runs of
+ * the same build.
+ */
+class JitDiskCache {
+public:
+    struct Entry {
+        u64 program_code_hash;
+        u64 swizzle_data_hash;
+        std::vector<u8> code;
+        std::array<u32, MAX_PROGRAM_CODE_LENGTH> instruction_offsets;
+    };
+
+    /// Uses the cache of the running title, if the setting is enabled
+    JitDiskCache();
+    /// Uses the cache file at the given path
+    explicit JitDiskCache(std::string path);
+
+    /// Returns whether the cache is in use, which requires the setting and a title id.
+    bool IsEnabled() const {
+        return enabled;
+    }
+
+    /**
+     * Loads all stored programs. Returns nothing if there is no cache or it can't be used. A
+     * cache written by another version of the emulator or on a CPU with other features is removed.
+     */
+    std::vector<Entry> Load();
+
+    /// Appends a newly compiled program to the cache file.
+    void Save(const Entry& entry);
+
+private:
+    /// Removes the cache file, e.g. after finding it is from an old version.
+    void Invalidate();
+
+    bool enabled = false;
+    std::string path;
+};
+
+} // namespace Pica::Shader
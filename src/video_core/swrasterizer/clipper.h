@@ -9,11 +9,23 @@ namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+class TevProgram;
+class TileBinner;
+} // namespace Rasterizer
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/**
+ * Clips the given triangle against the view volume and passes the resulting triangles on to the
+ * rasterizer, which runs tev_program for their fragments. If binner is not null, the triangles
+ * are queued in it instead of being rasterized immediately.
+ */
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     const Rasterizer::TevProgram& tev_program,
+                     Rasterizer::TileBinner* binner = nullptr);
 
 } // namespace Clipper
 } // namespace Pica
@@ -27,6 +27,8 @@
 #include "video_core/swrasterizer/lighting.h"
 #include "video_core/swrasterizer/proctex.h"
 #include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/span.h"
+#include "video_core/swrasterizer/tev_program.h"
 #include "video_core/swrasterizer/texturing.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
@@ -117,23 +119,25 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
     return std::make_tuple(x / z * half + half, y / z * half + half, z_abs, addr);
 }
 
+static Fix12P4 FloatToFix(float24 flt) {
+    // TODO: Rounding here is necessary to prevent garbage pixels at
+    //       triangle borders. Is it that the correct solution, though?
+    return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+}
+
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
- * culling via recursion.
+ * culling via recursion. If tile is not null, only the pixels inside it are touched.
  */
 static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
-                                    bool reversed = false) {
+                                    const TevProgram& tev_program,
+                                    const Common::Rectangle<u32>* tile, bool reversed = false) {
     const auto& regs = g_state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
     // vertex positions in rasterizer coordinates
-    static auto FloatToFix = [](float24 flt) {
-        // TODO: Rounding here is necessary to prevent garbage pixels at
-        //       triangle borders. Is it that the correct solution, though?
-        return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
-    };
     static auto ScreenToRasterizerCoordinates = [](const Common::Vec3<float24>& vec) {
         return Common::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
     };
@@ -145,13 +149,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, tev_program, tile, true);
             return;
         }
     } else {
         if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, tev_program, tile, true);
             return;
         }
 
@@ -185,6 +189,17 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
     max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
 
+    if (tile != nullptr) {
+        // Both bounds are pixel aligned at this point, so clamping to the tile selects exactly
+        // the pixels of the full triangle that lie inside of it.
+        min_x = static_cast<u16>(std::max<u32>(min_x, tile->left << 4));
+        min_y = static_cast<u16>(std::max<u32>(min_y, tile->top << 4));
+        max_x = static_cast<u16>(std::min<u32>(max_x, tile->right << 4));
+        max_y = static_cast<u16>(std::min<u32>(max_y, tile->bottom << 4));
+        if (min_x >= max_x || min_y >= max_y)
+            return;
+    }
+
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
     // values which are added to the barycentric coordinates w0, w1 and w2, respectively.
@@ -210,21 +225,205 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
+    // Edge i is the one opposite to vertex i, so that its value is the barycentric weight w_i
+    EdgeFunctions edges;
+    const int biases[3] = {bias0, bias1, bias2};
+    for (std::size_t i = 0; i < 3; ++i) {
+        const auto& start = vtxpos[(i + 1) % 3];
+        const auto& end = vtxpos[(i + 2) % 3];
+        edges.start_x[i] = start.x;
+        edges.start_y[i] = start.y;
+        edges.delta_x[i] = end.x - start.x;
+        edges.delta_y[i] = end.y - start.y;
+        edges.bias[i] = biases[i];
+    }
+    static const SpanCoverageFunction compute_span_coverage = GetSpanCoverageFunction();
+    SpanCoverage coverage;
+
     auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
     auto textures = regs.texturing.GetTextures();
-    auto tev_stages = regs.texturing.GetTevStages();
+    const TevUniforms tev_uniforms(regs);
+
+    const float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+    const float depth_offset =
+        float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+    const bool w_buffering =
+        regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering;
+
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    const bool shadow_mode = regs.framebuffer.output_merger.fragment_operation_mode ==
+                             FramebufferRegs::FragmentOperationMode::Shadow;
+    const bool allow_depth_stencil_write = framebuffer.allow_depth_stencil_write != 0;
+    const float max_depth =
+        static_cast<float>((1 << FramebufferRegs::DepthBitsPerPixel(framebuffer.depth_format)) - 1);
+
+    // The fragments of the current span. Each covered pixel is shaded up to the texture
+    // environment on its own, the rest is done for the whole span at once.
+    SpanTevInputs tev_inputs{};
+    std::array<float, SpanSize> depths{};
+    u32 span_mask = 0;
+    u16 span_x = 0;
+
+    // Runs the texture environment and the output merger for the fragments of the current span
+    const auto MergeSpan = [&](u16 y) {
+        u32 mask = span_mask;
+        span_mask = 0;
+        if (mask == 0)
+            return;
+
+        // Calls function with the index and x coordinate of each of the given fragments
+        const auto ForEachFragment = [span_x](u32 fragments, auto function) {
+            for (u32 i = 0; i < SpanSize; ++i) {
+                if (fragments & (1u << i))
+                    function(i, static_cast<u16>(span_x + (i << 4)));
+            }
+        };
+
+        // Texture environment - consists of 6 stages of color and alpha combining.
+        //
+        // Color combiners take three input color values from some source (e.g. interpolated
+        // vertex color, texture color, previous stage, etc), perform some very simple
+        // operations on each of them (e.g. inversion) and then calculate the output color
+        // with some basic arithmetic. Alpha combiners can be configured separately but work
+        // analogously.
+        SpanColors combiner_output;
+        tev_program.RunSpan(tev_inputs, tev_uniforms, combiner_output);
+
+        if (shadow_mode) {
+            ForEachFragment(mask, [&](u32 i, u16 x) {
+                u32 depth_int = static_cast<u32>(depths[i] * 0xFFFFFF);
+                // use green color as the shadow intensity
+                u8 stencil = combiner_output.channels[1][i];
+                DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
+            });
+            // skip the normal output merger pipeline if it is in shadow mode
+            return;
+        }
+
+        // TODO: Does alpha testing happen before or after stencil?
+        mask &= tev_program.AlphaTestSpan(combiner_output.channels[3], tev_uniforms);
+
+        // Apply fog combiner
+        // Not fully accurate. We'd have to know what data type is used to
+        // store the depth etc. Using float for now until we know more
+        // about Pica datatypes
+        if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
+            const Common::Vec3<u8> fog_color =
+                Common::MakeVec(regs.texturing.fog_color.r.Value(),
+                                regs.texturing.fog_color.g.Value(),
+                                regs.texturing.fog_color.b.Value())
+                    .Cast<u8>();
+
+            ForEachFragment(mask, [&](u32 i, u16) {
+                // Get index into fog LUT
+                float fog_index;
+                if (g_state.regs.texturing.fog_flip) {
+                    fog_index = (1.0f - depths[i]) * 128.0f;
+                } else {
+                    fog_index = depths[i] * 128.0f;
+                }
+
+                // Generate clamped fog factor from LUT for given fog index
+                float fog_i = std::clamp(floorf(fog_index), 0.0f, 127.0f);
+                float fog_f = fog_index - fog_i;
+                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
+                float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
+                fog_factor = std::clamp(fog_factor, 0.0f, 1.0f);
 
-    bool stencil_action_enable =
-        g_state.regs.framebuffer.output_merger.stencil_test.enable &&
-        g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
-    const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
+                // Blend the fog
+                for (unsigned c = 0; c < 3; c++) {
+                    auto& value = combiner_output.channels[c][i];
+                    value = static_cast<u8>(fog_factor * value +
+                                            (1.0f - fog_factor) * fog_color[c]);
+                }
+            });
+        }
+
+        std::array<u8, SpanSize> old_stencil{};
+
+        auto UpdateStencil = [&](TevProgram::StencilOp op, u32 i, u16 x) {
+            if (allow_depth_stencil_write)
+                SetStencil(x >> 4, y >> 4,
+                           tev_program.UpdateStencil(op, old_stencil[i], tev_uniforms));
+        };
+
+        if (tev_program.IsStencilEnabled()) {
+            ForEachFragment(mask, [&](u32 i, u16 x) {
+                old_stencil[i] = GetStencil(x >> 4, y >> 4);
+                if (!tev_program.StencilTest(old_stencil[i], tev_uniforms)) {
+                    UpdateStencil(TevProgram::StencilOp::StencilFail, i, x);
+                    mask &= ~(1u << i);
+                }
+            });
+        }
+
+        // Convert float to integer
+        std::array<u32, SpanSize> z;
+        for (std::size_t i = 0; i < SpanSize; ++i) {
+            z[i] = static_cast<u32>(depths[i] * max_depth);
+        }
+
+        if (tev_program.IsDepthTestEnabled()) {
+            std::array<u32, SpanSize> ref_z{};
+            ForEachFragment(mask, [&](u32 i, u16 x) { ref_z[i] = GetDepth(x >> 4, y >> 4); });
+            const u32 pass = tev_program.DepthTestSpan(z, ref_z);
+            if (tev_program.IsStencilEnabled()) {
+                ForEachFragment(mask & ~pass, [&](u32 i, u16 x) {
+                    UpdateStencil(TevProgram::StencilOp::DepthFail, i, x);
+                });
+            }
+            mask &= pass;
+        }
+
+        if (allow_depth_stencil_write && tev_program.IsDepthWriteEnabled()) {
+            ForEachFragment(mask, [&](u32 i, u16 x) { SetDepth(x >> 4, y >> 4, z[i]); });
+        }
+
+        // The stencil depth_pass action is executed even if depth testing is disabled
+        if (tev_program.IsStencilEnabled()) {
+            ForEachFragment(mask, [&](u32 i, u16 x) {
+                UpdateStencil(TevProgram::StencilOp::DepthPass, i, x);
+            });
+        }
+
+        if (framebuffer.allow_color_write != 0) {
+            SpanColors dest{};
+            ForEachFragment(mask,
+                            [&](u32 i, u16 x) { dest.Set(i, GetPixel(x >> 4, y >> 4)); });
+            SpanColors result;
+            tev_program.BlendSpan(combiner_output, dest, tev_uniforms, result);
+            ForEachFragment(mask,
+                            [&](u32 i, u16 x) { DrawPixel(x >> 4, y >> 4, result.Get(i)); });
+        }
+    };
 
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
     // TODO: Not sure if looping through x first might be faster
     for (u16 y = min_y + 8; y < max_y; y += 0x10) {
         for (u16 x = min_x + 8; x < max_x; x += 0x10) {
 
+            // Calculate the barycentric coordinates w0, w1 and w2 for a whole span of pixels at
+            // once whenever a new span starts
+            const u32 span_index = ((x - min_x) >> 4) % SpanSize;
+            if (span_index == 0) {
+                MergeSpan(y);
+                span_x = x;
+
+                const u32 span_length = std::min<u32>(SpanSize, (max_x - x + 0xF) >> 4);
+                compute_span_coverage(edges, x, y, span_length, coverage);
+
+                // Skip spans which are not covered by the current primitive at all
+                if (coverage.mask == 0) {
+                    x += 0x10 * (span_length - 1);
+                    continue;
+                }
+            }
+
+            // If current pixel is not covered by the current primitive
+            if ((coverage.mask & (1u << span_index)) == 0)
+                continue;
+
             // Do not process the pixel if it's inside the scissor box and the scissor mode is set
             // to Exclude
             if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
@@ -232,16 +431,11 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     continue;
             }
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
+            int w0 = coverage.weights[0][span_index];
+            int w1 = coverage.weights[1][span_index];
+            int w2 = coverage.weights[2][span_index];
             int wsum = w0 + w1 + w2;
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
-
             auto baricentric_coordinates =
                 Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
                                 float24::FromFloat32(static_cast<float>(w1)),
@@ -257,14 +451,10 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 
             // Not fully accurate. About 3 bits in precision are missing.
             // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            float depth_offset =
-                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
             float depth = interpolated_z_over_w * depth_scale + depth_offset;
 
             // Potentially switch to W-Buffer
-            if (regs.rasterizer.depthmap_enable ==
-                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
+            if (w_buffering) {
                 // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
                 depth *= interpolated_w_inverse.ToFloat32() * wsum;
             }
@@ -437,22 +627,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                                            g_state.regs.texturing, g_state.proctex);
             }
 
-            // Texture environment - consists of 6 stages of color and alpha combining.
-            //
-            // Color combiners take three input color values from some source (e.g. interpolated
-            // vertex color, texture color, previous stage, etc), perform some very simple
-            // operations on each of them (e.g. inversion) and then calculate the output color
-            // with some basic arithmetic. Alpha combiners can be configured separately but work
-            // analogously.
-            Common::Vec4<u8> combiner_output;
-            Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
-            Common::Vec4<u8> next_combiner_buffer =
-                Common::MakeVec(regs.texturing.tev_combiner_buffer_color.r.Value(),
-                                regs.texturing.tev_combiner_buffer_color.g.Value(),
-                                regs.texturing.tev_combiner_buffer_color.b.Value(),
-                                regs.texturing.tev_combiner_buffer_color.a.Value())
-                    .Cast<u8>();
-
             Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
             Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
 
@@ -475,424 +649,38 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
             }
 
-            for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
-                 ++tev_stage_index) {
-                const auto& tev_stage = tev_stages[tev_stage_index];
-                using Source = TexturingRegs::TevStageConfig::Source;
-
-                auto GetSource = [&](Source source) -> Common::Vec4<u8> {
-                    switch (source) {
-                    case Source::PrimaryColor:
-                        return primary_color;
-
-                    case Source::PrimaryFragmentColor:
-                        return primary_fragment_color;
-
-                    case Source::SecondaryFragmentColor:
-                        return secondary_fragment_color;
-
-                    case Source::Texture0:
-                        return texture_color[0];
-
-                    case Source::Texture1:
-                        return texture_color[1];
-
-                    case Source::Texture2:
-                        return texture_color[2];
-
-                    case Source::Texture3:
-                        return texture_color[3];
-
-                    case Source::PreviousBuffer:
-                        return combiner_buffer;
-
-                    case Source::Constant:
-                        return Common::MakeVec(tev_stage.const_r.Value(), tev_stage.const_g.Value(),
-                                               tev_stage.const_b.Value(), tev_stage.const_a.Value())
-                            .Cast<u8>();
-
-                    case Source::Previous:
-                        return combiner_output;
-
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown color combiner source {}", (int)source);
-                        UNIMPLEMENTED();
-                        return {0, 0, 0, 0};
-                    }
-                };
-
-                // color combiner
-                // NOTE: Not sure if the alpha combiner might use the color output of the previous
-                //       stage as input. Hence, we currently don't directly write the result to
-                //       combiner_output.rgb(), but instead store it in a temporary variable until
-                //       alpha combining has been done.
-                Common::Vec3<u8> color_result[3] = {
-                    GetColorModifier(tev_stage.color_modifier1, GetSource(tev_stage.color_source1)),
-                    GetColorModifier(tev_stage.color_modifier2, GetSource(tev_stage.color_source2)),
-                    GetColorModifier(tev_stage.color_modifier3, GetSource(tev_stage.color_source3)),
-                };
-                auto color_output = ColorCombine(tev_stage.color_op, color_result);
-
-                u8 alpha_output;
-                if (tev_stage.color_op == TexturingRegs::TevStageConfig::Operation::Dot3_RGBA) {
-                    // result of Dot3_RGBA operation is also placed to the alpha component
-                    alpha_output = color_output.x;
-                } else {
-                    // alpha combiner
-                    std::array<u8, 3> alpha_result = {{
-                        GetAlphaModifier(tev_stage.alpha_modifier1,
-                                         GetSource(tev_stage.alpha_source1)),
-                        GetAlphaModifier(tev_stage.alpha_modifier2,
-                                         GetSource(tev_stage.alpha_source2)),
-                        GetAlphaModifier(tev_stage.alpha_modifier3,
-                                         GetSource(tev_stage.alpha_source3)),
-                    }};
-                    alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
-                }
-
-                combiner_output[0] =
-                    std::min((unsigned)255, color_output.r() * tev_stage.GetColorMultiplier());
-                combiner_output[1] =
-                    std::min((unsigned)255, color_output.g() * tev_stage.GetColorMultiplier());
-                combiner_output[2] =
-                    std::min((unsigned)255, color_output.b() * tev_stage.GetColorMultiplier());
-                combiner_output[3] =
-                    std::min((unsigned)255, alpha_output * tev_stage.GetAlphaMultiplier());
-
-                combiner_buffer = next_combiner_buffer;
-
-                if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
-                        tev_stage_index)) {
-                    next_combiner_buffer.r() = combiner_output.r();
-                    next_combiner_buffer.g() = combiner_output.g();
-                    next_combiner_buffer.b() = combiner_output.b();
-                }
-
-                if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(
-                        tev_stage_index)) {
-                    next_combiner_buffer.a() = combiner_output.a();
-                }
-            }
-
-            const auto& output_merger = regs.framebuffer.output_merger;
-
-            if (output_merger.fragment_operation_mode ==
-                FramebufferRegs::FragmentOperationMode::Shadow) {
-                u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
-                // use green color as the shadow intensity
-                u8 stencil = combiner_output.y;
-                DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
-                // skip the normal output merger pipeline if it is in shadow mode
-                continue;
-            }
-
-            // TODO: Does alpha testing happen before or after stencil?
-            if (output_merger.alpha_test.enable) {
-                bool pass = false;
-
-                switch (output_merger.alpha_test.func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = combiner_output.a() == output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = combiner_output.a() != output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = combiner_output.a() < output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = combiner_output.a() <= output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = combiner_output.a() > output_merger.alpha_test.ref;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = combiner_output.a() >= output_merger.alpha_test.ref;
-                    break;
-                }
-
-                if (!pass)
-                    continue;
-            }
-
-            // Apply fog combiner
-            // Not fully accurate. We'd have to know what data type is used to
-            // store the depth etc. Using float for now until we know more
-            // about Pica datatypes
-            if (regs.texturing.fog_mode == TexturingRegs::FogMode::Fog) {
-                const Common::Vec3<u8> fog_color =
-                    Common::MakeVec(regs.texturing.fog_color.r.Value(),
-                                    regs.texturing.fog_color.g.Value(),
-                                    regs.texturing.fog_color.b.Value())
-                        .Cast<u8>();
-
-                // Get index into fog LUT
-                float fog_index;
-                if (g_state.regs.texturing.fog_flip) {
-                    fog_index = (1.0f - depth) * 128.0f;
-                } else {
-                    fog_index = depth * 128.0f;
-                }
-
-                // Generate clamped fog factor from LUT for given fog index
-                float fog_i = std::clamp(floorf(fog_index), 0.0f, 127.0f);
-                float fog_f = fog_index - fog_i;
-                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
-                float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
-                fog_factor = std::clamp(fog_factor, 0.0f, 1.0f);
-
-                // Blend the fog
-                for (unsigned i = 0; i < 3; i++) {
-                    combiner_output[i] = static_cast<u8>(fog_factor * combiner_output[i] +
-                                                         (1.0f - fog_factor) * fog_color[i]);
-                }
-            }
-
-            u8 old_stencil = 0;
-
-            auto UpdateStencil = [stencil_test, x, y,
-                                  &old_stencil](Pica::FramebufferRegs::StencilAction action) {
-                u8 new_stencil =
-                    PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                if (g_state.regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
-                    SetStencil(x >> 4, y >> 4,
-                               (new_stencil & stencil_test.write_mask) |
-                                   (old_stencil & ~stencil_test.write_mask));
-            };
-
-            if (stencil_action_enable) {
-                old_stencil = GetStencil(x >> 4, y >> 4);
-                u8 dest = old_stencil & stencil_test.input_mask;
-                u8 ref = stencil_test.reference_value & stencil_test.input_mask;
-
-                bool pass = false;
-                switch (stencil_test.func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = (ref == dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = (ref != dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = (ref < dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = (ref <= dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = (ref > dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = (ref >= dest);
-                    break;
-                }
-
-                if (!pass) {
-                    UpdateStencil(stencil_test.action_stencil_fail);
-                    continue;
-                }
-            }
-
-            // Convert float to integer
-            unsigned num_bits =
-                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
-
-            if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
-
-                bool pass = false;
-
-                switch (output_merger.depth_test_func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
-                    break;
-                }
-
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
-                    continue;
-                }
-            }
-
-            if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
-                output_merger.depth_write_enable) {
-
-                SetDepth(x >> 4, y >> 4, z);
-            }
-
-            // The stencil depth_pass action is executed even if depth testing is disabled
-            if (stencil_action_enable)
-                UpdateStencil(stencil_test.action_depth_pass);
-
-            auto dest = GetPixel(x >> 4, y >> 4);
-            Common::Vec4<u8> blend_output = combiner_output;
-
-            if (output_merger.alphablend_enable) {
-                auto params = output_merger.alpha_blending;
-
-                auto LookupFactor = [&](unsigned channel,
-                                        FramebufferRegs::BlendFactor factor) -> u8 {
-                    DEBUG_ASSERT(channel < 4);
-
-                    const Common::Vec4<u8> blend_const =
-                        Common::MakeVec(output_merger.blend_const.r.Value(),
-                                        output_merger.blend_const.g.Value(),
-                                        output_merger.blend_const.b.Value(),
-                                        output_merger.blend_const.a.Value())
-                            .Cast<u8>();
-
-                    switch (factor) {
-                    case FramebufferRegs::BlendFactor::Zero:
-                        return 0;
-
-                    case FramebufferRegs::BlendFactor::One:
-                        return 255;
-
-                    case FramebufferRegs::BlendFactor::SourceColor:
-                        return combiner_output[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusSourceColor:
-                        return 255 - combiner_output[channel];
-
-                    case FramebufferRegs::BlendFactor::DestColor:
-                        return dest[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusDestColor:
-                        return 255 - dest[channel];
-
-                    case FramebufferRegs::BlendFactor::SourceAlpha:
-                        return combiner_output.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusSourceAlpha:
-                        return 255 - combiner_output.a();
-
-                    case FramebufferRegs::BlendFactor::DestAlpha:
-                        return dest.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusDestAlpha:
-                        return 255 - dest.a();
-
-                    case FramebufferRegs::BlendFactor::ConstantColor:
-                        return blend_const[channel];
-
-                    case FramebufferRegs::BlendFactor::OneMinusConstantColor:
-                        return 255 - blend_const[channel];
-
-                    case FramebufferRegs::BlendFactor::ConstantAlpha:
-                        return blend_const.a();
-
-                    case FramebufferRegs::BlendFactor::OneMinusConstantAlpha:
-                        return 255 - blend_const.a();
-
-                    case FramebufferRegs::BlendFactor::SourceAlphaSaturate:
-                        // Returns 1.0 for the alpha channel
-                        if (channel == 3)
-                            return 255;
-                        return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
-
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", static_cast<u32>(factor));
-                        UNIMPLEMENTED();
-                        break;
-                    }
-
-                    return combiner_output[channel];
-                };
-
-                auto srcfactor = Common::MakeVec(LookupFactor(0, params.factor_source_rgb),
-                                                 LookupFactor(1, params.factor_source_rgb),
-                                                 LookupFactor(2, params.factor_source_rgb),
-                                                 LookupFactor(3, params.factor_source_a));
-
-                auto dstfactor = Common::MakeVec(LookupFactor(0, params.factor_dest_rgb),
-                                                 LookupFactor(1, params.factor_dest_rgb),
-                                                 LookupFactor(2, params.factor_dest_rgb),
-                                                 LookupFactor(3, params.factor_dest_a));
-
-                blend_output = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor,
-                                                     params.blend_equation_rgb);
-                blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest,
-                                                         dstfactor, params.blend_equation_a)
-                                       .a();
-            } else {
-                blend_output =
-                    Common::MakeVec(LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
-                                    LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
-                                    LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
-                                    LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
+            // The texture environment and the output merger run once the span is complete
+            tev_inputs.primary_color.Set(span_index, primary_color);
+            tev_inputs.primary_fragment_color.Set(span_index, primary_fragment_color);
+            tev_inputs.secondary_fragment_color.Set(span_index, secondary_fragment_color);
+            for (std::size_t i = 0; i < tev_inputs.texture_color.size(); ++i) {
+                tev_inputs.texture_color[i].Set(span_index, texture_color[i]);
             }
-
-            const Common::Vec4<u8> result = {
-                output_merger.red_enable ? blend_output.r() : dest.r(),
-                output_merger.green_enable ? blend_output.g() : dest.g(),
-                output_merger.blue_enable ? blend_output.b() : dest.b(),
-                output_merger.alpha_enable ? blend_output.a() : dest.a(),
-            };
-
-            if (regs.framebuffer.framebuffer.allow_color_write != 0)
-                DrawPixel(x >> 4, y >> 4, result);
+            depths[span_index] = depth;
+            span_mask |= 1u << span_index;
         }
+        MergeSpan(y);
     }
 }
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const TevProgram& tev_program) {
+    ProcessTriangleInternal(v0, v1, v2, tev_program, nullptr);
+}
+
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const TevProgram& tev_program, const Common::Rectangle<u32>& tile) {
+    ProcessTriangleInternal(v0, v1, v2, tev_program, &tile);
+}
+
+Common::Rectangle<u32> GetTriangleBounds(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+    const u32 x[3] = {FloatToFix(v0.screenpos.x), FloatToFix(v1.screenpos.x),
+                      FloatToFix(v2.screenpos.x)};
+    const u32 y[3] = {FloatToFix(v0.screenpos.y), FloatToFix(v1.screenpos.y),
+                      FloatToFix(v2.screenpos.y)};
+    return {std::min({x[0], x[1], x[2]}) >> 4, std::min({y[0], y[1], y[2]}) >> 4,
+            (std::max({x[0], x[1], x[2]}) + Fix12P4::FracMask()) >> 4,
+            (std::max({y[0], y[1], y[2]}) + Fix12P4::FracMask()) >> 4};
 }
 
 } // namespace Pica::Rasterizer
@@ -4,10 +4,13 @@
 
 #pragma once
 
+#include "common/math_util.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Rasterizer {
 
+class TevProgram;
+
 struct Vertex : Shader::OutputVertex {
     Vertex(const OutputVertex& v) : OutputVertex(v) {}
 
@@ -39,6 +42,25 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+/**
+ * Rasterizes a triangle with the current PICA state. tev_program has to be the texture
+ * environment and output merger program for that state.
+ */
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const TevProgram& tev_program);
+
+/**
+ * Same as above, but only touches the pixels inside the given rectangle (in pixels, with right
+ * and bottom being exclusive). Rasterizing a triangle once for each tile of a grid gives exactly
+ * the same result as rasterizing it as a whole.
+ */
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const TevProgram& tev_program, const Common::Rectangle<u32>& tile);
+
+/**
+ * Returns a rectangle (in pixels, with right and bottom being exclusive) containing every pixel
+ * that ProcessTriangle may touch for the given triangle.
+ */
+Common::Rectangle<u32> GetTriangleBounds(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
 } // namespace Pica::Rasterizer
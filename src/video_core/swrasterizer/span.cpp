@@ -0,0 +1,46 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/swrasterizer/span.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+namespace Pica::Rasterizer {
+
+void ComputeSpanCoverage(const EdgeFunctions& edges, u32 x, u32 y, u32 count,
+                         SpanCoverage& coverage) {
+    coverage.mask = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const u32 pixel_x = x + (i << 4);
+        bool covered = true;
+        for (std::size_t edge = 0; edge < 3; ++edge) {
+            // Calculate in unsigned arithmetic so that overflow wraps around
+            const u32 w = static_cast<u32>(edges.bias[edge]) +
+                          static_cast<u32>(edges.delta_x[edge]) *
+                              (y - static_cast<u32>(edges.start_y[edge])) -
+                          static_cast<u32>(edges.delta_y[edge]) *
+                              (pixel_x - static_cast<u32>(edges.start_x[edge]));
+            coverage.weights[edge][i] = static_cast<s32>(w);
+            covered &= static_cast<s32>(w) >= 0;
+        }
+        coverage.mask |= static_cast<u32>(covered) << i;
+    }
+}
+
+SpanCoverageFunction GetSpanCoverageFunction() {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.avx2) {
+        return ComputeSpanCoverageAVX2;
+    }
+    if (caps.sse4_1) {
+        return ComputeSpanCoverageSSE41;
+    }
+#endif
+    return ComputeSpanCoverage;
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,96 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+
+namespace Pica::Rasterizer {
+
+/// Maximum number of horizontally adjacent pixels which are rasterized together
+constexpr u32 SpanSize = 8;
+
+/// Returns a mask with the bits of the first count pixels of a span set
+constexpr u32 SpanMask(u32 count) {
+    return (1u << count) - 1;
+}
+
+/**
+ * Colors of a span of pixels. Each channel is stored separately, so that operations on the
+ * whole span are done one channel at a time over consecutive values and can be vectorized.
+ */
+struct SpanColors {
+    using Channel = std::array<u8, SpanSize>;
+
+    Common::Vec4<u8> Get(std::size_t pixel) const {
+        return {channels[0][pixel], channels[1][pixel], channels[2][pixel], channels[3][pixel]};
+    }
+
+    void Set(std::size_t pixel, const Common::Vec4<u8>& color) {
+        for (std::size_t channel = 0; channel < 4; ++channel) {
+            channels[channel][pixel] = color[channel];
+        }
+    }
+
+    /// Sets all pixels to the same color
+    void Fill(const Common::Vec4<u8>& color) {
+        for (std::size_t channel = 0; channel < 4; ++channel) {
+            channels[channel].fill(color[channel]);
+        }
+    }
+
+    alignas(16) std::array<Channel, 4> channels;
+};
+
+/**
+ * The three edge functions of a triangle, in 12.4 fixed point rasterizer coordinates. Edge i
+ * evaluates to bias + delta_x * (y - start_y) - delta_y * (x - start_x), which is the signed
+ * area of the triangle spanned by the edge and the point (x, y) plus the fill rule bias.
+ * Like the scalar rasterizer, all calculations wrap around on overflow.
+ */
+struct EdgeFunctions {
+    std::array<s32, 3> start_x;
+    std::array<s32, 3> start_y;
+    std::array<s32, 3> delta_x;
+    std::array<s32, 3> delta_y;
+    std::array<s32, 3> bias;
+};
+
+/// Barycentric weights of a span of pixels, along with which of them the triangle covers
+struct SpanCoverage {
+    alignas(32) std::array<std::array<s32, SpanSize>, 3> weights;
+    /// Bit i is set if pixel i of the span is covered, i.e. none of its weights are negative
+    u32 mask;
+};
+
+using SpanCoverageFunction = void (*)(const EdgeFunctions& edges, u32 x, u32 y, u32 count,
+                                      SpanCoverage& coverage);
+
+/**
+ * Evaluates the edge functions for a horizontal span of pixels.
+ * @param x,y Rasterizer coordinates of the center of the first pixel of the span
+ * @param count Number of pixels in the span, at most SpanSize. Pixel centers are 0x10 apart.
+ * @param coverage Receives the weights and coverage mask of the span. Weights of pixels past
+ *                 the end of the span are undefined.
+ */
+void ComputeSpanCoverage(const EdgeFunctions& edges, u32 x, u32 y, u32 count,
+                         SpanCoverage& coverage);
+
+#ifdef ARCHITECTURE_x86_64
+/// SSE4.1 version of ComputeSpanCoverage, evaluating four pixels per instruction.
+void ComputeSpanCoverageSSE41(const EdgeFunctions& edges, u32 x, u32 y, u32 count,
+                              SpanCoverage& coverage);
+
+/// AVX2 version of ComputeSpanCoverage, evaluating eight pixels per instruction.
+void ComputeSpanCoverageAVX2(const EdgeFunctions& edges, u32 x, u32 y, u32 count,
+                             SpanCoverage& coverage);
+#endif // ARCHITECTURE_x86_64
+
+/// Returns the fastest version of ComputeSpanCoverage that the host CPU supports.
+SpanCoverageFunction GetSpanCoverageFunction();
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,71 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <immintrin.h>
+#include "video_core/swrasterizer/span.h"
+
+// The functions below are only called after checking for CPU support, so they are compiled for
+// their instruction set without requiring it from the rest of the build.
+#ifdef _MSC_VER
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Pica::Rasterizer {
+
+/// Returns the value of the edge function at x = start_x for the given row.
+static u32 EvaluateRow(const EdgeFunctions& edges, std::size_t edge, u32 y) {
+    return static_cast<u32>(edges.bias[edge]) +
+           static_cast<u32>(edges.delta_x[edge]) * (y - static_cast<u32>(edges.start_y[edge]));
+}
+
+TARGET_SSE41 void ComputeSpanCoverageSSE41(const EdgeFunctions& edges, u32 x, u32 y, u32 count,
+                                           SpanCoverage& coverage) {
+    static_assert(SpanSize % 4 == 0);
+
+    u32 mask = 0;
+    for (u32 i = 0; i < SpanSize; i += 4) {
+        const u32 first_x = x + (i << 4);
+        const __m128i pixel_x =
+            _mm_setr_epi32(first_x, first_x + 0x10, first_x + 0x20, first_x + 0x30);
+        __m128i any_negative = _mm_setzero_si128();
+        for (std::size_t edge = 0; edge < 3; ++edge) {
+            const __m128i row = _mm_set1_epi32(EvaluateRow(edges, edge, y));
+            const __m128i offset_x = _mm_sub_epi32(pixel_x, _mm_set1_epi32(edges.start_x[edge]));
+            const __m128i w = _mm_sub_epi32(
+                row, _mm_mullo_epi32(_mm_set1_epi32(edges.delta_y[edge]), offset_x));
+            _mm_store_si128(reinterpret_cast<__m128i*>(&coverage.weights[edge][i]), w);
+            any_negative = _mm_or_si128(any_negative, w);
+        }
+        const u32 negative = _mm_movemask_ps(_mm_castsi128_ps(any_negative));
+        mask |= (~negative & 0xF) << i;
+    }
+    coverage.mask = mask & SpanMask(count);
+}
+
+TARGET_AVX2 void ComputeSpanCoverageAVX2(const EdgeFunctions& edges, u32 x, u32 y, u32 count,
+                                         SpanCoverage& coverage) {
+    static_assert(SpanSize == 8);
+
+    const __m256i pixel_x =
+        _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0x00, 0x10, 0x20, 0x30, 0x40,
+                                                                 0x50, 0x60, 0x70));
+    __m256i any_negative = _mm256_setzero_si256();
+    for (std::size_t edge = 0; edge < 3; ++edge) {
+        const __m256i row = _mm256_set1_epi32(EvaluateRow(edges, edge, y));
+        const __m256i offset_x =
+            _mm256_sub_epi32(pixel_x, _mm256_set1_epi32(edges.start_x[edge]));
+        const __m256i w = _mm256_sub_epi32(
+            row, _mm256_mullo_epi32(_mm256_set1_epi32(edges.delta_y[edge]), offset_x));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(coverage.weights[edge].data()), w);
+        any_negative = _mm256_or_si256(any_negative, w);
+    }
+    const u32 negative = _mm256_movemask_ps(_mm256_castsi256_ps(any_negative));
+    coverage.mask = ~negative & SpanMask(count);
+}
+
+} // namespace Pica::Rasterizer
@@ -2,15 +2,67 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <thread>
+#include "common/logging/log.h"
+#include "core/settings.h"
+#include "video_core/pica_state.h"
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/swrasterizer/tile_binner.h"
 
 namespace VideoCore {
 
+SWRasterizer::SWRasterizer() {
+    if (Settings::values.use_multithreaded_sw_rasterizer) {
+        const std::size_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        LOG_INFO(Render_Software, "Rasterizing on {} threads", num_threads);
+        binner = std::make_unique<Pica::Rasterizer::TileBinner>(num_threads);
+    }
+}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    if (tev_program == nullptr) {
+        tev_program = &tev_programs.Get(Pica::g_state.regs);
+    }
+    Pica::Clipper::ProcessTriangle(v0, v1, v2, *tev_program, binner.get());
+}
+
+void SWRasterizer::DrawTriangles() {
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    // Queued triangles have to be rasterized with the state they were submitted with
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::FlushAll() {
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::ClearAll(bool flush) {
+    FlushBinnedTriangles();
+}
+
+void SWRasterizer::FlushBinnedTriangles() {
+    if (binner) {
+        binner->Flush();
+    }
+    // The registers may change before the next triangle, so its program is looked up again
+    tev_program = nullptr;
 }
 
 } // namespace VideoCore
@@ -4,25 +4,46 @@
 
 #pragma once
 
+#include <memory>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/swrasterizer/tev_program.h"
 
 namespace Pica::Shader {
 struct OutputVertex;
 } // namespace Pica::Shader
 
+namespace Pica::Rasterizer {
+class TileBinner;
+} // namespace Pica::Rasterizer
+
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
+    void DrawTriangles() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
     void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
-    void ClearAll(bool flush) override {}
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void ClearAll(bool flush) override;
+
+private:
+    /// Rasterizes the triangles queued in the tile binner, if there is one.
+    void FlushBinnedTriangles();
+
+    /// Only present when multi-threaded rasterization is enabled
+    std::unique_ptr<Pica::Rasterizer::TileBinner> binner;
+
+    Pica::Rasterizer::TevProgramCache tev_programs;
+    /// Program of the triangles added since the last flush, which all share the same registers
+    const Pica::Rasterizer::TevProgram* tev_program = nullptr;
 };
 
 } // namespace VideoCore
@@ -0,0 +1,910 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <unordered_map>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/tev_program.h"
+#include "video_core/swrasterizer/texturing.h"
+
+namespace Pica::Rasterizer {
+
+using TevStageConfig = TexturingRegs::TevStageConfig;
+using CompareFunc = FramebufferRegs::CompareFunc;
+
+// Masks of the reference values, which are uniforms
+constexpr u32 AlphaTestRefMask = 0xFF00;
+constexpr u32 StencilRefMask = 0xFF0000;
+
+TevUniforms::TevUniforms(const Regs& full_regs) {
+    const auto& regs = full_regs.texturing;
+    const auto tev_stages = regs.GetTevStages();
+    for (std::size_t i = 0; i < tev_stages.size(); ++i) {
+        const auto& stage = tev_stages[i];
+        const_color[i] = Common::MakeVec(stage.const_r.Value(), stage.const_g.Value(),
+                                         stage.const_b.Value(), stage.const_a.Value())
+                             .Cast<u8>();
+    }
+    buffer_color = Common::MakeVec(regs.tev_combiner_buffer_color.r.Value(),
+                                   regs.tev_combiner_buffer_color.g.Value(),
+                                   regs.tev_combiner_buffer_color.b.Value(),
+                                   regs.tev_combiner_buffer_color.a.Value())
+                       .Cast<u8>();
+
+    const auto& output_merger = full_regs.framebuffer.output_merger;
+    alpha_test_ref = static_cast<u8>(output_merger.alpha_test.ref);
+    stencil_ref = static_cast<u8>(output_merger.stencil_test.reference_value);
+    blend_const = Common::MakeVec(output_merger.blend_const.r.Value(),
+                                  output_merger.blend_const.g.Value(),
+                                  output_merger.blend_const.b.Value(),
+                                  output_merger.blend_const.a.Value())
+                      .Cast<u8>();
+}
+
+TevConfig::TevConfig(const Regs& full_regs) {
+    const auto& regs = full_regs.texturing;
+    const auto tev_stages = regs.GetTevStages();
+    for (std::size_t i = 0; i < tev_stages.size(); ++i) {
+        const auto& stage = tev_stages[i];
+        state.stages[i].sources_raw = stage.sources_raw;
+        state.stages[i].modifiers_raw = stage.modifiers_raw;
+        state.stages[i].ops_raw = stage.ops_raw;
+        state.stages[i].scales_raw = stage.scales_raw;
+    }
+    state.update_mask_rgb = regs.tev_combiner_buffer_input.update_mask_rgb;
+    state.update_mask_a = regs.tev_combiner_buffer_input.update_mask_a;
+
+    const auto& reg_array = full_regs.reg_array;
+    state.blend_mode = reg_array[PICA_REG_INDEX(framebuffer.output_merger.alphablend_enable)];
+    state.alpha_blending = reg_array[PICA_REG_INDEX(framebuffer.output_merger.alpha_blending)];
+    state.logic_op = reg_array[PICA_REG_INDEX(framebuffer.output_merger.logic_op)];
+    state.alpha_test =
+        reg_array[PICA_REG_INDEX(framebuffer.output_merger.alpha_test)] & ~AlphaTestRefMask;
+    state.stencil_func =
+        full_regs.framebuffer.output_merger.stencil_test.raw_func & ~StencilRefMask;
+    state.stencil_op = full_regs.framebuffer.output_merger.stencil_test.raw_op;
+    state.depth_color_mask =
+        reg_array[PICA_REG_INDEX(framebuffer.output_merger.depth_test_enable)];
+    state.depth_format = reg_array[PICA_REG_INDEX(framebuffer.framebuffer.depth_format)];
+}
+
+static bool IsPassThroughTevStage(const TevStageConfig& stage) {
+    return (stage.color_op == TevStageConfig::Operation::Replace &&
+            stage.alpha_op == TevStageConfig::Operation::Replace &&
+            stage.color_source1 == TevStageConfig::Source::Previous &&
+            stage.alpha_source1 == TevStageConfig::Source::Previous &&
+            stage.color_modifier1 == TevStageConfig::ColorModifier::SourceColor &&
+            stage.alpha_modifier1 == TevStageConfig::AlphaModifier::SourceAlpha &&
+            stage.GetColorMultiplier() == 1 && stage.GetAlphaMultiplier() == 1);
+}
+
+TevProgram::TevProgram(const TevConfig& config) {
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        TevStageConfig stage_config;
+        stage_config.sources_raw = config.state.stages[i].sources_raw;
+        stage_config.modifiers_raw = config.state.stages[i].modifiers_raw;
+        stage_config.ops_raw = config.state.stages[i].ops_raw;
+        stage_config.const_color = 0;
+        stage_config.scales_raw = config.state.stages[i].scales_raw;
+
+        auto& stage = stages[i];
+        stage.pass_through = IsPassThroughTevStage(stage_config);
+        stage.dot3_rgba = stage_config.color_op == TevStageConfig::Operation::Dot3_RGBA;
+        stage.update_buffer_color = i < 4 && (config.state.update_mask_rgb & (1 << i));
+        stage.update_buffer_alpha = i < 4 && (config.state.update_mask_a & (1 << i));
+        stage.color_sources = {GetSlot(stage_config.color_source1),
+                               GetSlot(stage_config.color_source2),
+                               GetSlot(stage_config.color_source3)};
+        stage.alpha_sources = {GetSlot(stage_config.alpha_source1),
+                               GetSlot(stage_config.alpha_source2),
+                               GetSlot(stage_config.alpha_source3)};
+        stage.color_modifiers = {stage_config.color_modifier1, stage_config.color_modifier2,
+                                 stage_config.color_modifier3};
+        stage.alpha_modifiers = {stage_config.alpha_modifier1, stage_config.alpha_modifier2,
+                                 stage_config.alpha_modifier3};
+        stage.color_op = stage_config.color_op;
+        stage.alpha_op = stage_config.alpha_op;
+        stage.color_multiplier = stage_config.GetColorMultiplier();
+        stage.alpha_multiplier = stage_config.GetAlphaMultiplier();
+
+        // Stages after the last one that changes the output can't affect the result
+        if (!stage.pass_through) {
+            num_stages = i + 1;
+        }
+    }
+
+    // Put the output merger registers back in place to decode them with their fields
+    Regs regs{};
+    auto& reg_array = regs.reg_array;
+    reg_array[PICA_REG_INDEX(framebuffer.output_merger.alphablend_enable)] =
+        config.state.blend_mode;
+    reg_array[PICA_REG_INDEX(framebuffer.output_merger.alpha_blending)] =
+        config.state.alpha_blending;
+    reg_array[PICA_REG_INDEX(framebuffer.output_merger.logic_op)] = config.state.logic_op;
+    reg_array[PICA_REG_INDEX(framebuffer.output_merger.alpha_test)] = config.state.alpha_test;
+    regs.framebuffer.output_merger.stencil_test.raw_func = config.state.stencil_func;
+    regs.framebuffer.output_merger.stencil_test.raw_op = config.state.stencil_op;
+    reg_array[PICA_REG_INDEX(framebuffer.output_merger.depth_test_enable)] =
+        config.state.depth_color_mask;
+    reg_array[PICA_REG_INDEX(framebuffer.framebuffer.depth_format)] = config.state.depth_format;
+    const auto& output_merger = regs.framebuffer.output_merger;
+
+    alpha_test_func = output_merger.alpha_test.enable ? output_merger.alpha_test.func.Value()
+                                                      : CompareFunc::Always;
+
+    const auto& stencil_test = output_merger.stencil_test;
+    stencil_enable =
+        stencil_test.enable &&
+        regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
+    stencil_func = stencil_test.func;
+    stencil_write_mask = static_cast<u8>(stencil_test.write_mask);
+    stencil_input_mask = static_cast<u8>(stencil_test.input_mask);
+    stencil_actions = {stencil_test.action_stencil_fail, stencil_test.action_depth_fail,
+                       stencil_test.action_depth_pass};
+
+    depth_test_enable = output_merger.depth_test_enable != 0;
+    depth_test_func = output_merger.depth_test_func;
+    depth_write_enable = output_merger.depth_write_enable != 0;
+
+    alphablend_enable = output_merger.alphablend_enable != 0;
+    const auto& params = output_merger.alpha_blending;
+    blend_equation_rgb = params.blend_equation_rgb;
+    blend_equation_a = params.blend_equation_a;
+    for (std::size_t channel = 0; channel < 3; ++channel) {
+        source_factors[channel] = GetBlendFactor(params.factor_source_rgb, channel);
+        dest_factors[channel] = GetBlendFactor(params.factor_dest_rgb, channel);
+    }
+    source_factors[3] = GetBlendFactor(params.factor_source_a, 3);
+    dest_factors[3] = GetBlendFactor(params.factor_dest_a, 3);
+    logic_op = output_merger.logic_op;
+    color_write_enable = {output_merger.red_enable != 0, output_merger.green_enable != 0,
+                          output_merger.blue_enable != 0, output_merger.alpha_enable != 0};
+}
+
+TevProgram::Slot TevProgram::GetSlot(TevStageConfig::Source source) {
+    using Source = TevStageConfig::Source;
+
+    switch (source) {
+    case Source::PrimaryColor:
+        return PrimaryColor;
+    case Source::PrimaryFragmentColor:
+        return PrimaryFragmentColor;
+    case Source::SecondaryFragmentColor:
+        return SecondaryFragmentColor;
+    case Source::Texture0:
+        return Texture0;
+    case Source::Texture1:
+        return Texture1;
+    case Source::Texture2:
+        return Texture2;
+    case Source::Texture3:
+        return Texture3;
+    case Source::PreviousBuffer:
+        return PreviousBuffer;
+    case Source::Constant:
+        return Constant;
+    case Source::Previous:
+        return Previous;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner source {}", static_cast<u32>(source));
+        return Zero;
+    }
+}
+
+TevProgram::BlendFactor TevProgram::GetBlendFactor(FramebufferRegs::BlendFactor factor,
+                                                   std::size_t channel) {
+    using Factor = FramebufferRegs::BlendFactor;
+
+    switch (factor) {
+    case Factor::Zero:
+        return {FactorSource::Zero, false, false};
+    case Factor::One:
+        return {FactorSource::Zero, false, true};
+    case Factor::SourceColor:
+        return {FactorSource::Source, false, false};
+    case Factor::OneMinusSourceColor:
+        return {FactorSource::Source, false, true};
+    case Factor::DestColor:
+        return {FactorSource::Dest, false, false};
+    case Factor::OneMinusDestColor:
+        return {FactorSource::Dest, false, true};
+    case Factor::SourceAlpha:
+        return {FactorSource::Source, true, false};
+    case Factor::OneMinusSourceAlpha:
+        return {FactorSource::Source, true, true};
+    case Factor::DestAlpha:
+        return {FactorSource::Dest, true, false};
+    case Factor::OneMinusDestAlpha:
+        return {FactorSource::Dest, true, true};
+    case Factor::ConstantColor:
+        return {FactorSource::Constant, false, false};
+    case Factor::OneMinusConstantColor:
+        return {FactorSource::Constant, false, true};
+    case Factor::ConstantAlpha:
+        return {FactorSource::Constant, true, false};
+    case Factor::OneMinusConstantAlpha:
+        return {FactorSource::Constant, true, true};
+    case Factor::SourceAlphaSaturate:
+        // Returns 1.0 for the alpha channel
+        if (channel == 3) {
+            return {FactorSource::Zero, false, true};
+        }
+        return {FactorSource::SourceAlphaSaturate, false, false};
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown blend factor {:x}", static_cast<u32>(factor));
+        UNIMPLEMENTED();
+        return {FactorSource::Source, false, false};
+    }
+}
+
+bool TevProgram::Compare(CompareFunc func, u32 value, u32 ref) {
+    switch (func) {
+    case CompareFunc::Never:
+        return false;
+    case CompareFunc::Always:
+        return true;
+    case CompareFunc::Equal:
+        return value == ref;
+    case CompareFunc::NotEqual:
+        return value != ref;
+    case CompareFunc::LessThan:
+        return value < ref;
+    case CompareFunc::LessThanOrEqual:
+        return value <= ref;
+    case CompareFunc::GreaterThan:
+        return value > ref;
+    case CompareFunc::GreaterThanOrEqual:
+        return value >= ref;
+    }
+    return false;
+}
+
+Common::Vec4<u8> TevProgram::Run(const TevInputs& inputs, const TevUniforms& uniforms) const {
+    std::array<Common::Vec4<u8>, NumSlots> slots;
+    slots[PrimaryColor] = inputs.primary_color;
+    slots[PrimaryFragmentColor] = inputs.primary_fragment_color;
+    slots[SecondaryFragmentColor] = inputs.secondary_fragment_color;
+    slots[Texture0] = inputs.texture_color[0];
+    slots[Texture1] = inputs.texture_color[1];
+    slots[Texture2] = inputs.texture_color[2];
+    slots[Texture3] = inputs.texture_color[3];
+    slots[PreviousBuffer] = {0, 0, 0, 0};
+    slots[Previous] = {0, 0, 0, 0};
+    slots[Zero] = {0, 0, 0, 0};
+
+    Common::Vec4<u8> next_combiner_buffer = uniforms.buffer_color;
+    auto& combiner_output = slots[Previous];
+
+    for (std::size_t i = 0; i < num_stages; ++i) {
+        const auto& stage = stages[i];
+
+        if (!stage.pass_through) {
+            slots[Constant] = uniforms.const_color[i];
+
+            // The color result is kept in a temporary until alpha combining has been done, in
+            // case the alpha combiner reads the previous stage's color.
+            const Common::Vec3<u8> color_result[3] = {
+                GetColorModifier(stage.color_modifiers[0], slots[stage.color_sources[0]]),
+                GetColorModifier(stage.color_modifiers[1], slots[stage.color_sources[1]]),
+                GetColorModifier(stage.color_modifiers[2], slots[stage.color_sources[2]]),
+            };
+            const auto color_output = ColorCombine(stage.color_op, color_result);
+
+            u8 alpha_output;
+            if (stage.dot3_rgba) {
+                // result of Dot3_RGBA operation is also placed to the alpha component
+                alpha_output = color_output.x;
+            } else {
+                const std::array<u8, 3> alpha_result = {{
+                    GetAlphaModifier(stage.alpha_modifiers[0], slots[stage.alpha_sources[0]]),
+                    GetAlphaModifier(stage.alpha_modifiers[1], slots[stage.alpha_sources[1]]),
+                    GetAlphaModifier(stage.alpha_modifiers[2], slots[stage.alpha_sources[2]]),
+                }};
+                alpha_output = AlphaCombine(stage.alpha_op, alpha_result);
+            }
+
+            combiner_output[0] = std::min(255u, color_output.r() * stage.color_multiplier);
+            combiner_output[1] = std::min(255u, color_output.g() * stage.color_multiplier);
+            combiner_output[2] = std::min(255u, color_output.b() * stage.color_multiplier);
+            combiner_output[3] = std::min(255u, alpha_output * stage.alpha_multiplier);
+        }
+
+        slots[PreviousBuffer] = next_combiner_buffer;
+
+        if (stage.update_buffer_color) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+
+        if (stage.update_buffer_alpha) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+
+    return combiner_output;
+}
+
+bool TevProgram::AlphaTest(u8 alpha, const TevUniforms& uniforms) const {
+    return Compare(alpha_test_func, alpha, uniforms.alpha_test_ref);
+}
+
+bool TevProgram::StencilTest(u8 stencil, const TevUniforms& uniforms) const {
+    // The reference value is compared against the stored one, unlike in the other tests
+    return Compare(stencil_func, uniforms.stencil_ref & stencil_input_mask,
+                   stencil & stencil_input_mask);
+}
+
+u8 TevProgram::UpdateStencil(StencilOp op, u8 old_stencil, const TevUniforms& uniforms) const {
+    const u8 new_stencil = PerformStencilAction(stencil_actions[static_cast<std::size_t>(op)],
+                                                old_stencil, uniforms.stencil_ref);
+    return (new_stencil & stencil_write_mask) | (old_stencil & ~stencil_write_mask);
+}
+
+bool TevProgram::DepthTest(u32 z, u32 ref_z) const {
+    return Compare(depth_test_func, z, ref_z);
+}
+
+u8 TevProgram::GetBlendFactorValue(const BlendFactor& factor, std::size_t channel,
+                                   const Common::Vec4<u8>& source, const Common::Vec4<u8>& dest,
+                                   const TevUniforms& uniforms) const {
+    const std::size_t read_channel = factor.alpha ? 3 : channel;
+    u8 value = 0;
+    switch (factor.source) {
+    case FactorSource::Zero:
+        break;
+    case FactorSource::Source:
+        value = source[read_channel];
+        break;
+    case FactorSource::Dest:
+        value = dest[read_channel];
+        break;
+    case FactorSource::Constant:
+        value = uniforms.blend_const[read_channel];
+        break;
+    case FactorSource::SourceAlphaSaturate:
+        value = std::min(source.a(), static_cast<u8>(255 - dest.a()));
+        break;
+    }
+    return factor.one_minus ? 255 - value : value;
+}
+
+Common::Vec4<u8> TevProgram::Blend(const Common::Vec4<u8>& source, const Common::Vec4<u8>& dest,
+                                   const TevUniforms& uniforms) const {
+    Common::Vec4<u8> blend_output;
+    if (alphablend_enable) {
+        Common::Vec4<u8> source_factor;
+        Common::Vec4<u8> dest_factor;
+        for (std::size_t channel = 0; channel < 4; ++channel) {
+            source_factor[channel] =
+                GetBlendFactorValue(source_factors[channel], channel, source, dest, uniforms);
+            dest_factor[channel] =
+                GetBlendFactorValue(dest_factors[channel], channel, source, dest, uniforms);
+        }
+
+        blend_output =
+            EvaluateBlendEquation(source, source_factor, dest, dest_factor, blend_equation_rgb);
+        blend_output.a() =
+            EvaluateBlendEquation(source, source_factor, dest, dest_factor, blend_equation_a).a();
+    } else {
+        for (std::size_t channel = 0; channel < 4; ++channel) {
+            blend_output[channel] = LogicOp(source[channel], dest[channel], logic_op);
+        }
+    }
+
+    for (std::size_t channel = 0; channel < 4; ++channel) {
+        if (!color_write_enable[channel]) {
+            blend_output[channel] = dest[channel];
+        }
+    }
+    return blend_output;
+}
+
+using ColorChannels = std::array<SpanColors::Channel, 3>;
+
+/// Sets each value of a span channel to the result of function for its pixel
+template <typename Function>
+static void ForEachPixel(SpanColors::Channel& output, Function function) {
+    for (std::size_t i = 0; i < SpanSize; ++i) {
+        output[i] = static_cast<u8>(function(i));
+    }
+}
+
+/// Sets each value of the color channels of a span to the result of function for its channel
+/// and pixel
+template <typename Function>
+static void ForEachPixel(ColorChannels& output, Function function) {
+    for (std::size_t channel = 0; channel < 3; ++channel) {
+        for (std::size_t i = 0; i < SpanSize; ++i) {
+            output[channel][i] = static_cast<u8>(function(channel, i));
+        }
+    }
+}
+
+/// Copies a channel of a span, inverting it for the "one minus" modifiers
+static void CopyChannel(const SpanColors::Channel& input, bool one_minus,
+                        SpanColors::Channel& output) {
+    if (one_minus) {
+        ForEachPixel(output, [&](std::size_t i) { return 255 - input[i]; });
+    } else {
+        output = input;
+    }
+}
+
+/// Span version of GetColorModifier
+static void ModifyColorSpan(TevStageConfig::ColorModifier modifier, const SpanColors& values,
+                            ColorChannels& output) {
+    using ColorModifier = TevStageConfig::ColorModifier;
+
+    // The channel of the values that each of the output channels is taken from
+    std::array<std::size_t, 3> channels{};
+    switch (modifier) {
+    case ColorModifier::SourceColor:
+    case ColorModifier::OneMinusSourceColor:
+        channels = {0, 1, 2};
+        break;
+    case ColorModifier::SourceAlpha:
+    case ColorModifier::OneMinusSourceAlpha:
+        channels = {3, 3, 3};
+        break;
+    case ColorModifier::SourceRed:
+    case ColorModifier::OneMinusSourceRed:
+        channels = {0, 0, 0};
+        break;
+    case ColorModifier::SourceGreen:
+    case ColorModifier::OneMinusSourceGreen:
+        channels = {1, 1, 1};
+        break;
+    case ColorModifier::SourceBlue:
+    case ColorModifier::OneMinusSourceBlue:
+        channels = {2, 2, 2};
+        break;
+    default:
+        UNREACHABLE();
+    }
+
+    // The "one minus" modifiers are the odd ones
+    const bool one_minus = (static_cast<u32>(modifier) & 1) != 0;
+    for (std::size_t channel = 0; channel < 3; ++channel) {
+        CopyChannel(values.channels[channels[channel]], one_minus, output[channel]);
+    }
+}
+
+/// Span version of GetAlphaModifier
+static void ModifyAlphaSpan(TevStageConfig::AlphaModifier modifier, const SpanColors& values,
+                            SpanColors::Channel& output) {
+    using AlphaModifier = TevStageConfig::AlphaModifier;
+
+    std::size_t channel = 0;
+    switch (modifier) {
+    case AlphaModifier::SourceAlpha:
+    case AlphaModifier::OneMinusSourceAlpha:
+        channel = 3;
+        break;
+    case AlphaModifier::SourceRed:
+    case AlphaModifier::OneMinusSourceRed:
+        channel = 0;
+        break;
+    case AlphaModifier::SourceGreen:
+    case AlphaModifier::OneMinusSourceGreen:
+        channel = 1;
+        break;
+    case AlphaModifier::SourceBlue:
+    case AlphaModifier::OneMinusSourceBlue:
+        channel = 2;
+        break;
+    default:
+        UNREACHABLE();
+    }
+
+    const bool one_minus = (static_cast<u32>(modifier) & 1) != 0;
+    CopyChannel(values.channels[channel], one_minus, output);
+}
+
+/// Span version of ColorCombine
+static void ColorCombineSpan(TevStageConfig::Operation op, const std::array<ColorChannels, 3>& in,
+                             ColorChannels& output) {
+    using Operation = TevStageConfig::Operation;
+
+    switch (op) {
+    case Operation::Replace:
+        output = in[0];
+        break;
+    case Operation::Modulate:
+        ForEachPixel(output, [&](std::size_t c, std::size_t i) {
+            return in[0][c][i] * in[1][c][i] / 255;
+        });
+        break;
+    case Operation::Add:
+        ForEachPixel(output, [&](std::size_t c, std::size_t i) {
+            return std::min(255, in[0][c][i] + in[1][c][i]);
+        });
+        break;
+    case Operation::AddSigned:
+        ForEachPixel(output, [&](std::size_t c, std::size_t i) {
+            return std::clamp(in[0][c][i] + in[1][c][i] - 128, 0, 255);
+        });
+        break;
+    case Operation::Lerp:
+        ForEachPixel(output, [&](std::size_t c, std::size_t i) {
+            return (in[0][c][i] * in[2][c][i] + in[1][c][i] * (255 - in[2][c][i])) / 255;
+        });
+        break;
+    case Operation::Subtract:
+        ForEachPixel(output, [&](std::size_t c, std::size_t i) {
+            return std::max(0, in[0][c][i] - in[1][c][i]);
+        });
+        break;
+    case Operation::MultiplyThenAdd:
+        ForEachPixel(output, [&](std::size_t c, std::size_t i) {
+            return std::min(255, (in[0][c][i] * in[1][c][i] + 255 * in[2][c][i]) / 255);
+        });
+        break;
+    case Operation::AddThenMultiply:
+        ForEachPixel(output, [&](std::size_t c, std::size_t i) {
+            return std::min(255, in[0][c][i] + in[1][c][i]) * in[2][c][i] / 255;
+        });
+        break;
+    case Operation::Dot3_RGB:
+    case Operation::Dot3_RGBA:
+        ForEachPixel(output[0], [&](std::size_t i) {
+            int result = 0;
+            for (std::size_t c = 0; c < 3; ++c) {
+                result += ((in[0][c][i] * 2 - 255) * (in[1][c][i] * 2 - 255) + 128) / 256;
+            }
+            return std::clamp(result, 0, 255);
+        });
+        output[1] = output[0];
+        output[2] = output[0];
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner operation {}", static_cast<int>(op));
+        UNIMPLEMENTED();
+        for (auto& channel : output) {
+            channel.fill(0);
+        }
+        break;
+    }
+}
+
+/// Span version of AlphaCombine
+static void AlphaCombineSpan(TevStageConfig::Operation op,
+                             const std::array<SpanColors::Channel, 3>& in,
+                             SpanColors::Channel& output) {
+    using Operation = TevStageConfig::Operation;
+
+    switch (op) {
+    case Operation::Replace:
+        output = in[0];
+        break;
+    case Operation::Modulate:
+        ForEachPixel(output, [&](std::size_t i) { return in[0][i] * in[1][i] / 255; });
+        break;
+    case Operation::Add:
+        ForEachPixel(output, [&](std::size_t i) { return std::min(255, in[0][i] + in[1][i]); });
+        break;
+    case Operation::AddSigned:
+        ForEachPixel(output,
+                     [&](std::size_t i) { return std::clamp(in[0][i] + in[1][i] - 128, 0, 255); });
+        break;
+    case Operation::Lerp:
+        ForEachPixel(output, [&](std::size_t i) {
+            return (in[0][i] * in[2][i] + in[1][i] * (255 - in[2][i])) / 255;
+        });
+        break;
+    case Operation::Subtract:
+        ForEachPixel(output, [&](std::size_t i) { return std::max(0, in[0][i] - in[1][i]); });
+        break;
+    case Operation::MultiplyThenAdd:
+        ForEachPixel(output, [&](std::size_t i) {
+            return std::min(255, (in[0][i] * in[1][i] + 255 * in[2][i]) / 255);
+        });
+        break;
+    case Operation::AddThenMultiply:
+        ForEachPixel(output, [&](std::size_t i) {
+            return std::min(255, in[0][i] + in[1][i]) * in[2][i] / 255;
+        });
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown alpha combiner operation {}", static_cast<int>(op));
+        UNIMPLEMENTED();
+        output.fill(0);
+        break;
+    }
+}
+
+void TevProgram::RunSpan(const SpanTevInputs& inputs, const TevUniforms& uniforms,
+                         SpanColors& output) const {
+    SpanColors constant;
+    SpanColors previous_buffer;
+    SpanColors zero;
+    previous_buffer.Fill({0, 0, 0, 0});
+    output.Fill({0, 0, 0, 0});
+    zero.Fill({0, 0, 0, 0});
+
+    std::array<const SpanColors*, NumSlots> slots;
+    slots[PrimaryColor] = &inputs.primary_color;
+    slots[PrimaryFragmentColor] = &inputs.primary_fragment_color;
+    slots[SecondaryFragmentColor] = &inputs.secondary_fragment_color;
+    slots[Texture0] = &inputs.texture_color[0];
+    slots[Texture1] = &inputs.texture_color[1];
+    slots[Texture2] = &inputs.texture_color[2];
+    slots[Texture3] = &inputs.texture_color[3];
+    slots[PreviousBuffer] = &previous_buffer;
+    slots[Constant] = &constant;
+    slots[Previous] = &output;
+    slots[Zero] = &zero;
+
+    SpanColors next_combiner_buffer;
+    next_combiner_buffer.Fill(uniforms.buffer_color);
+
+    for (std::size_t stage_index = 0; stage_index < num_stages; ++stage_index) {
+        const auto& stage = stages[stage_index];
+
+        if (!stage.pass_through) {
+            constant.Fill(uniforms.const_color[stage_index]);
+
+            // Both results are kept in temporaries until the stage is done, in case the
+            // combiners read the previous stage's output.
+            std::array<ColorChannels, 3> color_inputs;
+            for (std::size_t i = 0; i < 3; ++i) {
+                ModifyColorSpan(stage.color_modifiers[i], *slots[stage.color_sources[i]],
+                                color_inputs[i]);
+            }
+            ColorChannels color_output;
+            ColorCombineSpan(stage.color_op, color_inputs, color_output);
+
+            SpanColors::Channel alpha_output;
+            if (stage.dot3_rgba) {
+                // result of Dot3_RGBA operation is also placed to the alpha component
+                alpha_output = color_output[0];
+            } else {
+                std::array<SpanColors::Channel, 3> alpha_inputs;
+                for (std::size_t i = 0; i < 3; ++i) {
+                    ModifyAlphaSpan(stage.alpha_modifiers[i], *slots[stage.alpha_sources[i]],
+                                    alpha_inputs[i]);
+                }
+                AlphaCombineSpan(stage.alpha_op, alpha_inputs, alpha_output);
+            }
+
+            for (std::size_t channel = 0; channel < 3; ++channel) {
+                ForEachPixel(output.channels[channel], [&](std::size_t i) {
+                    return std::min(255u, color_output[channel][i] * stage.color_multiplier);
+                });
+            }
+            ForEachPixel(output.channels[3], [&](std::size_t i) {
+                return std::min(255u, alpha_output[i] * stage.alpha_multiplier);
+            });
+        }
+
+        previous_buffer = next_combiner_buffer;
+
+        if (stage.update_buffer_color) {
+            for (std::size_t channel = 0; channel < 3; ++channel) {
+                next_combiner_buffer.channels[channel] = output.channels[channel];
+            }
+        }
+
+        if (stage.update_buffer_alpha) {
+            next_combiner_buffer.channels[3] = output.channels[3];
+        }
+    }
+}
+
+/// Returns the mask of the pixels of a span for which the comparison passes
+template <typename T>
+static u32 CompareSpan(CompareFunc func, const std::array<T, SpanSize>& values,
+                       const std::array<T, SpanSize>& refs) {
+    const auto MaskOf = [](auto predicate) {
+        u32 mask = 0;
+        for (std::size_t i = 0; i < SpanSize; ++i) {
+            mask |= static_cast<u32>(predicate(i)) << i;
+        }
+        return mask;
+    };
+
+    switch (func) {
+    case CompareFunc::Never:
+        return 0;
+    case CompareFunc::Always:
+        return SpanMask(SpanSize);
+    case CompareFunc::Equal:
+        return MaskOf([&](std::size_t i) { return values[i] == refs[i]; });
+    case CompareFunc::NotEqual:
+        return MaskOf([&](std::size_t i) { return values[i] != refs[i]; });
+    case CompareFunc::LessThan:
+        return MaskOf([&](std::size_t i) { return values[i] < refs[i]; });
+    case CompareFunc::LessThanOrEqual:
+        return MaskOf([&](std::size_t i) { return values[i] <= refs[i]; });
+    case CompareFunc::GreaterThan:
+        return MaskOf([&](std::size_t i) { return values[i] > refs[i]; });
+    case CompareFunc::GreaterThanOrEqual:
+        return MaskOf([&](std::size_t i) { return values[i] >= refs[i]; });
+    }
+    return 0;
+}
+
+u32 TevProgram::AlphaTestSpan(const SpanColors::Channel& alpha,
+                              const TevUniforms& uniforms) const {
+    SpanColors::Channel refs;
+    refs.fill(uniforms.alpha_test_ref);
+    return CompareSpan(alpha_test_func, alpha, refs);
+}
+
+u32 TevProgram::DepthTestSpan(const std::array<u32, SpanSize>& z,
+                              const std::array<u32, SpanSize>& ref_z) const {
+    return CompareSpan(depth_test_func, z, ref_z);
+}
+
+void TevProgram::GetBlendFactorSpan(const BlendFactor& factor, std::size_t channel,
+                                    const SpanColors& source, const SpanColors& dest,
+                                    const TevUniforms& uniforms,
+                                    SpanColors::Channel& output) const {
+    const std::size_t read_channel = factor.alpha ? 3 : channel;
+    switch (factor.source) {
+    case FactorSource::Zero:
+        output.fill(0);
+        break;
+    case FactorSource::Source:
+        output = source.channels[read_channel];
+        break;
+    case FactorSource::Dest:
+        output = dest.channels[read_channel];
+        break;
+    case FactorSource::Constant:
+        output.fill(uniforms.blend_const[read_channel]);
+        break;
+    case FactorSource::SourceAlphaSaturate:
+        ForEachPixel(output, [&](std::size_t i) {
+            return std::min(source.channels[3][i], static_cast<u8>(255 - dest.channels[3][i]));
+        });
+        break;
+    }
+    if (factor.one_minus) {
+        CopyChannel(output, true, output);
+    }
+}
+
+/// Span version of EvaluateBlendEquation, for a single channel
+static void BlendChannelSpan(FramebufferRegs::BlendEquation equation,
+                             const SpanColors::Channel& source,
+                             const SpanColors::Channel& source_factor,
+                             const SpanColors::Channel& dest,
+                             const SpanColors::Channel& dest_factor,
+                             SpanColors::Channel& output) {
+    using BlendEquation = FramebufferRegs::BlendEquation;
+
+    switch (equation) {
+    case BlendEquation::Add:
+        ForEachPixel(output, [&](std::size_t i) {
+            return std::clamp((source[i] * source_factor[i] + dest[i] * dest_factor[i]) / 255, 0,
+                              255);
+        });
+        break;
+    case BlendEquation::Subtract:
+        ForEachPixel(output, [&](std::size_t i) {
+            return std::clamp((source[i] * source_factor[i] - dest[i] * dest_factor[i]) / 255, 0,
+                              255);
+        });
+        break;
+    case BlendEquation::ReverseSubtract:
+        ForEachPixel(output, [&](std::size_t i) {
+            return std::clamp((dest[i] * dest_factor[i] - source[i] * source_factor[i]) / 255, 0,
+                              255);
+        });
+        break;
+    case BlendEquation::Min:
+        ForEachPixel(output, [&](std::size_t i) { return std::min(source[i], dest[i]); });
+        break;
+    case BlendEquation::Max:
+        ForEachPixel(output, [&](std::size_t i) { return std::max(source[i], dest[i]); });
+        break;
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation 0x{:x}", static_cast<u8>(equation));
+        UNIMPLEMENTED();
+        output.fill(0);
+        break;
+    }
+}
+
+/// Span version of LogicOp, for a single channel
+static void LogicOpSpan(FramebufferRegs::LogicOp op, const SpanColors::Channel& src,
+                        const SpanColors::Channel& dest, SpanColors::Channel& output) {
+    using Op = FramebufferRegs::LogicOp;
+
+    switch (op) {
+    case Op::Clear:
+        output.fill(0);
+        break;
+    case Op::And:
+        ForEachPixel(output, [&](std::size_t i) { return src[i] & dest[i]; });
+        break;
+    case Op::AndReverse:
+        ForEachPixel(output, [&](std::size_t i) { return src[i] & ~dest[i]; });
+        break;
+    case Op::Copy:
+        output = src;
+        break;
+    case Op::Set:
+        output.fill(255);
+        break;
+    case Op::CopyInverted:
+        ForEachPixel(output, [&](std::size_t i) { return ~src[i]; });
+        break;
+    case Op::NoOp:
+        output = dest;
+        break;
+    case Op::Invert:
+        ForEachPixel(output, [&](std::size_t i) { return ~dest[i]; });
+        break;
+    case Op::Nand:
+        ForEachPixel(output, [&](std::size_t i) { return ~(src[i] & dest[i]); });
+        break;
+    case Op::Or:
+        ForEachPixel(output, [&](std::size_t i) { return src[i] | dest[i]; });
+        break;
+    case Op::Nor:
+        ForEachPixel(output, [&](std::size_t i) { return ~(src[i] | dest[i]); });
+        break;
+    case Op::Xor:
+        ForEachPixel(output, [&](std::size_t i) { return src[i] ^ dest[i]; });
+        break;
+    case Op::Equiv:
+        ForEachPixel(output, [&](std::size_t i) { return ~(src[i] ^ dest[i]); });
+        break;
+    case Op::AndInverted:
+        ForEachPixel(output, [&](std::size_t i) { return ~src[i] & dest[i]; });
+        break;
+    case Op::OrReverse:
+        ForEachPixel(output, [&](std::size_t i) { return src[i] | ~dest[i]; });
+        break;
+    case Op::OrInverted:
+        ForEachPixel(output, [&](std::size_t i) { return ~src[i] | dest[i]; });
+        break;
+    }
+}
+
+void TevProgram::BlendSpan(const SpanColors& source, const SpanColors& dest,
+                           const TevUniforms& uniforms, SpanColors& output) const {
+    for (std::size_t channel = 0; channel < 4; ++channel) {
+        auto& result = output.channels[channel];
+        if (!color_write_enable[channel]) {
+            result = dest.channels[channel];
+        } else if (alphablend_enable) {
+            SpanColors::Channel source_factor;
+            SpanColors::Channel dest_factor;
+            GetBlendFactorSpan(source_factors[channel], channel, source, dest, uniforms,
+                               source_factor);
+            GetBlendFactorSpan(dest_factors[channel], channel, source, dest, uniforms,
+                               dest_factor);
+            BlendChannelSpan(channel == 3 ? blend_equation_a : blend_equation_rgb,
+                             source.channels[channel], source_factor, dest.channels[channel],
+                             dest_factor, result);
+        } else {
+            LogicOpSpan(logic_op, source.channels[channel], dest.channels[channel], result);
+        }
+    }
+}
+
+MICROPROFILE_DEFINE(GPU_TevProgram, "GPU", "Build TEV Program", MP_RGB(100, 100, 255));
+
+const TevProgram& TevProgramCache::Get(const Regs& regs) {
+    const TevConfig config(regs);
+
+    auto iter = programs.find(config);
+    if (iter == programs.end()) {
+        MICROPROFILE_SCOPE(GPU_TevProgram);
+        if (programs.size() >= MaxPrograms) {
+            LOG_DEBUG(Render_Software, "Dropping {} cached TEV programs", programs.size());
+            programs.clear();
+        }
+        iter = programs.emplace(config, TevProgram(config)).first;
+    }
+    return iter->second;
+}
+
+} // namespace Pica::Rasterizer
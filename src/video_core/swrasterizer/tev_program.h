@@ -0,0 +1,259 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/regs.h"
+#include "video_core/swrasterizer/span.h"
+
+namespace Pica::Rasterizer {
+
+/// Per-fragment values that texture environment stages can use as a source
+struct TevInputs {
+    Common::Vec4<u8> primary_color;
+    Common::Vec4<u8> primary_fragment_color;
+    Common::Vec4<u8> secondary_fragment_color;
+    std::array<Common::Vec4<u8>, 4> texture_color;
+};
+
+/// TevInputs of a span of fragments
+struct SpanTevInputs {
+    SpanColors primary_color;
+    SpanColors primary_fragment_color;
+    SpanColors secondary_fragment_color;
+    std::array<SpanColors, 4> texture_color;
+};
+
+/// Texture environment and fragment operation values which are not part of a program, so they
+/// can change without requiring a new one. These are read once per triangle.
+struct TevUniforms {
+    explicit TevUniforms(const Regs& regs);
+
+    std::array<Common::Vec4<u8>, 6> const_color;
+    Common::Vec4<u8> buffer_color;
+    u8 alpha_test_ref;
+    u8 stencil_ref;
+    Common::Vec4<u8> blend_const;
+};
+
+// Doesn't include const_color, the reference values and the blend color, which are passed in
+// through TevUniforms instead
+struct TevConfigState {
+    struct {
+        u32 sources_raw;
+        u32 modifiers_raw;
+        u32 ops_raw;
+        u32 scales_raw;
+    } stages[6];
+    u32 update_mask_rgb;
+    u32 update_mask_a;
+    // Raw output merger registers
+    u32 blend_mode;
+    u32 alpha_blending;
+    u32 logic_op;
+    u32 alpha_test;
+    u32 stencil_func;
+    u32 stencil_op;
+    u32 depth_color_mask;
+    u32 depth_format;
+};
+
+/// The parts of the PICA registers that a TevProgram is built from.
+struct TevConfig : Common::HashableStruct<TevConfigState> {
+    explicit TevConfig(const Regs& regs);
+};
+
+/**
+ * The texture environment and output merger configuration, decoded once into a form that is
+ * cheap to evaluate for every fragment: sources are resolved to input slots, scales are unpacked,
+ * pass-through stages are skipped and trailing pass-through stages are dropped entirely. Disabled
+ * tests are turned into ones that always pass, and blend factors are resolved to the value they
+ * read.
+ */
+class TevProgram {
+public:
+    /// The stencil actions, by what happened to the fragment
+    enum class StencilOp {
+        StencilFail,
+        DepthFail,
+        DepthPass,
+    };
+
+    explicit TevProgram(const TevConfig& config);
+
+    /// Runs the texture environment for a single fragment and returns the combiner output.
+    Common::Vec4<u8> Run(const TevInputs& inputs, const TevUniforms& uniforms) const;
+
+    /// Returns whether a fragment with the given combiner output alpha passes the alpha test.
+    bool AlphaTest(u8 alpha, const TevUniforms& uniforms) const;
+
+    /// Returns whether the stencil buffer is tested and updated.
+    bool IsStencilEnabled() const {
+        return stencil_enable;
+    }
+
+    /// Returns whether a fragment passes the stencil test against the stored stencil value.
+    bool StencilTest(u8 stencil, const TevUniforms& uniforms) const;
+
+    /// Returns the stencil value to store after the given stencil action of a fragment.
+    u8 UpdateStencil(StencilOp op, u8 old_stencil, const TevUniforms& uniforms) const;
+
+    bool IsDepthTestEnabled() const {
+        return depth_test_enable;
+    }
+
+    bool IsDepthWriteEnabled() const {
+        return depth_write_enable;
+    }
+
+    /// Returns whether a fragment of depth z passes the depth test against the stored depth.
+    bool DepthTest(u32 z, u32 ref_z) const;
+
+    /// Blends the fragment color with the color in the framebuffer, keeping the channels which
+    /// are not written.
+    Common::Vec4<u8> Blend(const Common::Vec4<u8>& source, const Common::Vec4<u8>& dest,
+                           const TevUniforms& uniforms) const;
+
+    // The functions below process a whole span of fragments at once, one stage at a time, and
+    // give the same results as the functions above for each of the fragments. Results of
+    // pixels which are not part of the span are unspecified.
+
+    /// Runs the texture environment for a span of fragments.
+    void RunSpan(const SpanTevInputs& inputs, const TevUniforms& uniforms,
+                 SpanColors& output) const;
+
+    /// Returns the mask of the fragments of a span which pass the alpha test.
+    u32 AlphaTestSpan(const SpanColors::Channel& alpha, const TevUniforms& uniforms) const;
+
+    /// Returns the mask of the fragments of a span which pass the depth test.
+    u32 DepthTestSpan(const std::array<u32, SpanSize>& z,
+                      const std::array<u32, SpanSize>& ref_z) const;
+
+    /// Blends a span of fragment colors with the colors in the framebuffer.
+    void BlendSpan(const SpanColors& source, const SpanColors& dest, const TevUniforms& uniforms,
+                   SpanColors& output) const;
+
+private:
+    /// Where a stage reads each of its sources from
+    enum Slot : u8 {
+        PrimaryColor,
+        PrimaryFragmentColor,
+        SecondaryFragmentColor,
+        Texture0,
+        Texture1,
+        Texture2,
+        Texture3,
+        PreviousBuffer,
+        Constant,
+        Previous,
+        /// Unknown sources read all zeroes
+        Zero,
+        NumSlots,
+    };
+
+    struct Stage {
+        bool pass_through;
+        bool dot3_rgba;
+        bool update_buffer_color;
+        bool update_buffer_alpha;
+        std::array<Slot, 3> color_sources;
+        std::array<Slot, 3> alpha_sources;
+        std::array<TexturingRegs::TevStageConfig::ColorModifier, 3> color_modifiers;
+        std::array<TexturingRegs::TevStageConfig::AlphaModifier, 3> alpha_modifiers;
+        TexturingRegs::TevStageConfig::Operation color_op;
+        TexturingRegs::TevStageConfig::Operation alpha_op;
+        unsigned color_multiplier;
+        unsigned alpha_multiplier;
+    };
+
+    /// What a blend factor is read from
+    enum class FactorSource : u8 {
+        Zero,
+        Source,
+        Dest,
+        Constant,
+        SourceAlphaSaturate,
+    };
+
+    struct BlendFactor {
+        FactorSource source;
+        /// Whether the alpha channel of the source is read instead of the blended channel
+        bool alpha;
+        bool one_minus;
+    };
+
+    static Slot GetSlot(TexturingRegs::TevStageConfig::Source source);
+    static BlendFactor GetBlendFactor(FramebufferRegs::BlendFactor factor, std::size_t channel);
+    static bool Compare(FramebufferRegs::CompareFunc func, u32 value, u32 ref);
+
+    u8 GetBlendFactorValue(const BlendFactor& factor, std::size_t channel,
+                           const Common::Vec4<u8>& source, const Common::Vec4<u8>& dest,
+                           const TevUniforms& uniforms) const;
+    void GetBlendFactorSpan(const BlendFactor& factor, std::size_t channel,
+                            const SpanColors& source, const SpanColors& dest,
+                            const TevUniforms& uniforms, SpanColors::Channel& output) const;
+
+    std::array<Stage, 6> stages;
+    std::size_t num_stages = 0;
+
+    FramebufferRegs::CompareFunc alpha_test_func;
+    bool stencil_enable;
+    FramebufferRegs::CompareFunc stencil_func;
+    u8 stencil_write_mask;
+    u8 stencil_input_mask;
+    std::array<FramebufferRegs::StencilAction, 3> stencil_actions;
+    bool depth_test_enable;
+    FramebufferRegs::CompareFunc depth_test_func;
+    bool depth_write_enable;
+    bool alphablend_enable;
+    FramebufferRegs::BlendEquation blend_equation_rgb;
+    FramebufferRegs::BlendEquation blend_equation_a;
+    /// The source and destination factors of each channel
+    std::array<BlendFactor, 4> source_factors;
+    std::array<BlendFactor, 4> dest_factors;
+    FramebufferRegs::LogicOp logic_op;
+    std::array<bool, 4> color_write_enable;
+};
+
+} // namespace Pica::Rasterizer
+
+namespace std {
+template <>
+struct hash<Pica::Rasterizer::TevConfig> {
+    std::size_t operator()(const Pica::Rasterizer::TevConfig& k) const noexcept {
+        return k.Hash();
+    }
+};
+} // namespace std
+
+namespace Pica::Rasterizer {
+
+/**
+ * The programs built by a rasterizer, by configuration. It is not synchronized, so each
+ * rasterizer owns one and looks programs up before handing triangles to other threads.
+ */
+class TevProgramCache {
+public:
+    /**
+     * Returns the program for the current texture environment and output merger configuration,
+     * building it the first time the configuration is seen. The program stays valid until the
+     * next call.
+     */
+    const TevProgram& Get(const Regs& regs);
+
+private:
+    /// Number of programs kept before the cache is emptied to make room for a new one
+    static constexpr std::size_t MaxPrograms = 256;
+
+    std::unordered_map<TevConfig, TevProgram> programs;
+};
+
+} // namespace Pica::Rasterizer
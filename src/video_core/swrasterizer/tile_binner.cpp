@@ -0,0 +1,85 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/microprofile.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/tile_binner.h"
+
+namespace Pica::Rasterizer {
+
+/// Rasterizer coordinates are 12.4 fixed point, so no pixel lies beyond this
+constexpr u32 MaxCoordinate = 0x1000;
+
+MICROPROFILE_DEFINE(GPU_TileBinning, "GPU", "Tile Binning", MP_RGB(70, 70, 240));
+
+TileBinner::TileBinner(std::size_t num_threads) : pool(num_threads) {}
+
+TileBinner::~TileBinner() = default;
+
+void TileBinner::AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                             const TevProgram& tev_program) {
+    if (triangles.empty()) {
+        ResizeGrid();
+    }
+
+    const auto bounds = GetTriangleBounds(v0, v1, v2);
+    if (bounds.left >= bounds.right || bounds.top >= bounds.bottom) {
+        return;
+    }
+
+    const u32 index = static_cast<u32>(triangles.size());
+    triangles.push_back({{v0, v1, v2}, &tev_program});
+
+    // The last row and column of tiles extend to the end of the coordinate space, so triangles
+    // reaching outside of the framebuffer are still rasterized exactly like in the serial path.
+    const u32 first_x = std::min(bounds.left / TileSize, tiles_x - 1);
+    const u32 last_x = std::min((bounds.right - 1) / TileSize, tiles_x - 1);
+    const u32 first_y = std::min(bounds.top / TileSize, tiles_y - 1);
+    const u32 last_y = std::min((bounds.bottom - 1) / TileSize, tiles_y - 1);
+    for (u32 y = first_y; y <= last_y; ++y) {
+        for (u32 x = first_x; x <= last_x; ++x) {
+            tiles[y * tiles_x + x].push_back(index);
+        }
+    }
+}
+
+void TileBinner::Flush() {
+    if (triangles.empty()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_TileBinning);
+    pool.ParallelFor(tiles.size(), [this](std::size_t index) {
+        auto& tile = tiles[index];
+        if (tile.empty()) {
+            return;
+        }
+        const auto rect = GetTileRect(static_cast<u32>(index % tiles_x),
+                                      static_cast<u32>(index / tiles_x));
+        for (const u32 triangle : tile) {
+            const auto& [vertices, tev_program] = triangles[triangle];
+            ProcessTriangle(vertices[0], vertices[1], vertices[2], *tev_program, rect);
+        }
+        tile.clear();
+    });
+    triangles.clear();
+}
+
+void TileBinner::ResizeGrid() {
+    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+    const u32 width = std::clamp<u32>(framebuffer.GetWidth(), 1, MaxCoordinate);
+    const u32 height = std::clamp<u32>(framebuffer.GetHeight(), 1, MaxCoordinate);
+    tiles_x = (width + TileSize - 1) / TileSize;
+    tiles_y = (height + TileSize - 1) / TileSize;
+    tiles.resize(tiles_x * tiles_y);
+}
+
+Common::Rectangle<u32> TileBinner::GetTileRect(u32 tile_x, u32 tile_y) const {
+    const u32 right = tile_x + 1 == tiles_x ? MaxCoordinate : (tile_x + 1) * TileSize;
+    const u32 bottom = tile_y + 1 == tiles_y ? MaxCoordinate : (tile_y + 1) * TileSize;
+    return {tile_x * TileSize, tile_y * TileSize, right, bottom};
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,60 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "common/thread_pool.h"
+#include "video_core/swrasterizer/rasterizer.h"
+
+namespace Pica::Rasterizer {
+
+/**
+ * Collects the triangles of a draw batch into screen space tiles and rasterizes the tiles in
+ * parallel. Every pixel belongs to exactly one tile and each tile processes its triangles in
+ * submission order, so the output is identical to rasterizing the triangles one after another.
+ *
+ * Rasterization reads the PICA state, so the batch has to be flushed before it changes.
+ */
+class TileBinner : NonCopyable {
+public:
+    explicit TileBinner(std::size_t num_threads);
+    ~TileBinner();
+
+    /// Queues a clipped triangle for rasterization. The program has to outlive the next Flush.
+    void AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     const TevProgram& tev_program);
+
+    /// Rasterizes all the queued triangles and waits for them to complete.
+    void Flush();
+
+private:
+    /// Width and height of a tile, in pixels
+    static constexpr u32 TileSize = 32;
+
+    /// Sets up the tile grid to cover the current framebuffer.
+    void ResizeGrid();
+
+    /// Returns the pixels covered by the tile at the given grid position.
+    Common::Rectangle<u32> GetTileRect(u32 tile_x, u32 tile_y) const;
+
+    Common::ThreadPool pool;
+
+    struct Triangle {
+        std::array<Vertex, 3> vertices;
+        const TevProgram* tev_program;
+    };
+
+    std::vector<Triangle> triangles;
+    /// Indices into triangles of the triangles touching each tile, in submission order
+    std::vector<std::vector<u32>> tiles;
+    u32 tiles_x = 0;
+    u32 tiles_y = 0;
+};
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,63 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "video_core/vertex_cache.h"
+
+namespace Pica {
+
+VertexCache::VertexCache(std::size_t num_entries)
+    : sets(num_entries / Ways), outputs(num_entries), set_mask(num_entries / Ways - 1) {
+    ASSERT_MSG(num_entries >= Ways && (num_entries & (num_entries - 1)) == 0,
+               "Vertex cache size must be a power of two");
+    for (auto& set : sets) {
+        set.generations.fill(0);
+        set.next_victim = 0;
+    }
+}
+
+VertexCache::~VertexCache() = default;
+
+const Shader::AttributeBuffer* VertexCache::Lookup(u32 vertex) const {
+    // Indices of neighbouring vertices tend to be close, so the low bits spread them evenly
+    const std::size_t set_index = vertex & set_mask;
+    const Set& set = sets[set_index];
+    for (std::size_t way = 0; way < Ways; ++way) {
+        if (set.generations[way] == generation && set.vertices[way] == vertex) {
+            return &outputs[set_index * Ways + way];
+        }
+    }
+    return nullptr;
+}
+
+void VertexCache::Insert(u32 vertex, const Shader::AttributeBuffer& output) {
+    const std::size_t set_index = vertex & set_mask;
+    Set& set = sets[set_index];
+
+    // Fill empty entries first, then replace the entries round-robin
+    std::size_t way = 0;
+    while (way < Ways && set.generations[way] == generation) {
+        ++way;
+    }
+    if (way == Ways) {
+        way = set.next_victim;
+        set.next_victim = (set.next_victim + 1) % Ways;
+    }
+
+    set.vertices[way] = vertex;
+    set.generations[way] = generation;
+    outputs[set_index * Ways + way] = output;
+}
+
+void VertexCache::Invalidate() {
+    if (++generation == 0) {
+        // Entries from the generation before the wrap-around would be valid again
+        for (auto& set : sets) {
+            set.generations.fill(0);
+        }
+        generation = 1;
+    }
+}
+
+} // namespace Pica
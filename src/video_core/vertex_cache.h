@@ -0,0 +1,52 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica {
+
+/**
+ * Set-associative cache of vertex shader outputs, looked up by vertex index. It stays valid across
+ * draws until Invalidate is called, which has to happen whenever the vertex input or the vertex
+ * shader configuration changes.
+ */
+class VertexCache {
+public:
+    /// Number of entries which vertices with the same set index compete for
+    static constexpr std::size_t Ways = 4;
+
+    /// @param num_entries Total number of vertices to cache. Must be a power of two.
+    explicit VertexCache(std::size_t num_entries);
+    ~VertexCache();
+
+    /// Returns the cached shader output of the vertex, or nullptr if it is not cached.
+    const Shader::AttributeBuffer* Lookup(u32 vertex) const;
+
+    /// Caches the shader output of a vertex, evicting an older vertex if its set is full.
+    void Insert(u32 vertex, const Shader::AttributeBuffer& output);
+
+    /// Drops all the cached vertices.
+    void Invalidate();
+
+private:
+    struct Set {
+        std::array<u32, Ways> vertices;
+        /// An entry is only valid while its generation matches the current one
+        std::array<u32, Ways> generations;
+        u32 next_victim;
+    };
+
+    std::vector<Set> sets;
+    std::vector<Shader::AttributeBuffer> outputs;
+    std::size_t set_mask;
+    u32 generation = 1;
+};
+
+} // namespace Pica
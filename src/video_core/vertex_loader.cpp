@@ -1,10 +1,12 @@
-#include <memory>
+#include <cstring>
+#include <unordered_map>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
@@ -17,17 +19,59 @@
 
 namespace Pica {
 
+VertexLoaderConfig::VertexLoaderConfig(const PipelineRegs& regs) {
+    const auto& attribute_config = regs.vertex_attributes;
+    static_assert(sizeof(attribute_config) == sizeof(u32) + sizeof(state.attribute_format) +
+                                                  sizeof(attribute_config.attribute_loaders),
+                  "VertexLoaderConfigState does not match the vertex attribute registers");
+    static_assert(sizeof(attribute_config.attribute_loaders[0]) ==
+                      sizeof(u32) + sizeof(state.loader_components[0]),
+                  "VertexLoaderConfigState does not match the attribute loader registers");
+
+    std::memcpy(state.attribute_format,
+                reinterpret_cast<const u8*>(&attribute_config) + sizeof(u32),
+                sizeof(state.attribute_format));
+    for (std::size_t loader = 0; loader < 12; ++loader) {
+        std::memcpy(state.loader_components[loader],
+                    reinterpret_cast<const u8*>(&attribute_config.attribute_loaders[loader]) +
+                        sizeof(u32),
+                    sizeof(state.loader_components[loader]));
+    }
+}
+
+template <typename T, u32 NumElements>
+static void LoadAttribute(const u8* source, Common::Vec4<float24>& output) {
+    for (u32 comp = 0; comp < NumElements; ++comp) {
+        T value;
+        std::memcpy(&value, source + comp * sizeof(T), sizeof(T));
+        output[comp] = float24::FromFloat32(static_cast<float>(value));
+    }
+
+    // Default attribute values set if array elements have < 4 components. This
+    // is *not* carried over from the default attribute settings even if they're
+    // enabled for this attribute.
+    for (u32 comp = NumElements; comp < 4; ++comp) {
+        output[comp] = comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
+    }
+}
+
+template <typename T>
+static constexpr std::array<void (*)(const u8*, Common::Vec4<float24>&), 4> LoadFunctions = {
+    LoadAttribute<T, 1>, LoadAttribute<T, 2>, LoadAttribute<T, 3>, LoadAttribute<T, 4>};
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
     const auto& attribute_config = regs.vertex_attributes;
     num_total_attributes = attribute_config.GetNumTotalAttributes();
 
-    boost::fill(vertex_attribute_sources, 0xdeadbeef);
+    std::array<u32, 16> vertex_attribute_loaders{};
+    std::array<u32, 16> vertex_attribute_sources;
+    std::array<u32, 16> vertex_attribute_strides{};
+    std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
+    std::array<u32, 16> vertex_attribute_elements{};
 
-    for (int i = 0; i < 16; i++) {
-        vertex_attribute_is_default[i] = attribute_config.IsDefaultAttribute(i);
-    }
+    boost::fill(vertex_attribute_sources, 0xdeadbeef);
 
     // Setup attribute data from loaders
     for (int loader = 0; loader < 12; ++loader) {
@@ -48,7 +92,8 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
             if (attribute_index < 12) {
                 offset = Common::AlignUp(offset,
                                          attribute_config.GetElementSizeInBytes(attribute_index));
-                vertex_attribute_sources[attribute_index] = loader_config.data_offset + offset;
+                vertex_attribute_loaders[attribute_index] = loader;
+                vertex_attribute_sources[attribute_index] = offset;
                 vertex_attribute_strides[attribute_index] =
                     static_cast<u32>(loader_config.byte_count);
                 vertex_attribute_formats[attribute_index] =
@@ -68,96 +113,111 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
         }
     }
 
-    is_setup = true;
-}
-
-void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
-                              Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
-    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
-
     for (int i = 0; i < num_total_attributes; ++i) {
-        if (vertex_attribute_elements[i] != 0) {
-            // Load per-vertex data from the loader arrays
-            u32 source_addr =
-                base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
-
-            if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(
-                    source_addr,
-                    vertex_attribute_elements[i] *
-                        ((vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
-                             ? 4
-                             : (vertex_attribute_formats[i] ==
-                                PipelineRegs::VertexAttributeFormat::SHORT)
-                                   ? 2
-                                   : 1));
-            }
+        const u32 elements = vertex_attribute_elements[i];
+        if (elements != 0) {
+            auto& attribute = array_attributes[num_array_attributes++];
+            attribute.index = i;
+            attribute.loader = vertex_attribute_loaders[i];
+            attribute.source = vertex_attribute_sources[i];
+            attribute.stride = vertex_attribute_strides[i];
+            attribute.size = elements * attribute_config.GetElementSizeInBytes(i);
 
             switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::BYTE:
+                attribute.load = LoadFunctions<s8>[elements - 1];
                 break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::UBYTE:
+                attribute.load = LoadFunctions<u8>[elements - 1];
                 break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::SHORT:
+                attribute.load = LoadFunctions<s16>[elements - 1];
                 break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::FLOAT:
+                attribute.load = LoadFunctions<float>[elements - 1];
                 break;
             }
-            }
-
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-            }
-
-            LOG_TRACE(HW_GPU,
-                      "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
-                      "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
-                      vertex_attribute_elements[i], i, vertex, index, base_address,
-                      vertex_attribute_sources[i], vertex_attribute_strides[i] * vertex,
-                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else if (vertex_attribute_is_default[i]) {
-            // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.input_default_attributes.attr[i];
-            LOG_TRACE(
-                HW_GPU,
-                "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})", i,
-                vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
+        } else if (attribute_config.IsDefaultAttribute(i)) {
+            default_attributes[num_default_attributes++] = i;
         } else {
             // TODO(yuriks): In this case, no data gets loaded and the vertex
             // remains with the last value it had. This isn't currently maintained
             // as global state, however, and so won't work in Citra yet.
         }
     }
+
+    is_setup = true;
+}
+
+void VertexLoader::LoadVertices(const PipelineRegs& regs, const unsigned int* vertices,
+                                std::size_t count, Shader::AttributeBuffer* inputs,
+                                DebugUtils::MemoryAccessTracker& memory_accesses) const {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+
+    const bool track_accesses = g_debug_context && g_debug_context->recorder;
+    const auto& attribute_config = regs.vertex_attributes;
+    const u32 base_address = attribute_config.GetPhysicalBaseAddress();
+
+    for (std::size_t a = 0; a < num_array_attributes; ++a) {
+        const auto& attribute = array_attributes[a];
+        const u32 data_offset = attribute_config.attribute_loaders[attribute.loader].data_offset;
+        const u32 array_address = base_address + data_offset + attribute.source;
+
+        // Look the array up once instead of once per vertex. Vertices which don't lie within the
+        // same memory region as the start of the array are looked up separately.
+        const MemoryRef array = VideoCore::g_memory->GetPhysicalRef(array_address);
+
+        for (std::size_t v = 0; v < count; ++v) {
+            const u32 offset = attribute.stride * vertices[v];
+            const u8* source =
+                static_cast<std::size_t>(offset) + attribute.size <= array.GetSize()
+                    ? array.GetPtr() + offset
+                    : VideoCore::g_memory->GetPhysicalPointer(array_address + offset);
+
+            if (track_accesses) {
+                memory_accesses.AddAccess(array_address + offset, attribute.size);
+            }
+
+            auto& attr = inputs[v].attr[attribute.index];
+            attribute.load(source, attr);
+
+            LOG_TRACE(HW_GPU,
+                      "Loaded attribute {:x} for vertex {:x} from 0x{:08x} + 0x{:08x} + "
+                      "0x{:04x}: {} {} {} {}",
+                      attribute.index, vertices[v], base_address, data_offset + attribute.source,
+                      offset, attr[0].ToFloat32(), attr[1].ToFloat32(), attr[2].ToFloat32(),
+                      attr[3].ToFloat32());
+        }
+    }
+
+    // Load the default attributes if we're configured to do so
+    for (std::size_t d = 0; d < num_default_attributes; ++d) {
+        const u32 i = default_attributes[d];
+        for (std::size_t v = 0; v < count; ++v) {
+            inputs[v].attr[i] = g_state.input_default_attributes.attr[i];
+        }
+    }
+}
+
+MICROPROFILE_DEFINE(GPU_VertexLoaderSetup, "GPU", "Vertex Loader Setup", MP_RGB(50, 150, 240));
+
+const VertexLoader& GetVertexLoader(const PipelineRegs& regs) {
+    // Games only use a handful of layouts, so this is rarely reached
+    constexpr std::size_t MaxLoaders = 64;
+    static std::unordered_map<VertexLoaderConfig, VertexLoader> cache;
+
+    const VertexLoaderConfig config(regs);
+
+    auto iter = cache.find(config);
+    if (iter == cache.end()) {
+        MICROPROFILE_SCOPE(GPU_VertexLoaderSetup);
+        if (cache.size() >= MaxLoaders) {
+            LOG_DEBUG(HW_GPU, "Dropping {} cached vertex loaders", cache.size());
+            cache.clear();
+        }
+        iter = cache.emplace(config, VertexLoader(regs)).first;
+    }
+    return iter->second;
 }
 
 } // namespace Pica
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <functional>
 #include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -14,6 +19,18 @@ namespace Shader {
 struct AttributeBuffer;
 }
 
+// The vertex attribute registers, except for the base address and the loader data offsets. Those
+// only move the attribute arrays and are read when loading vertices.
+struct VertexLoaderConfigState {
+    u32 attribute_format[2];
+    u32 loader_components[12][2];
+};
+
+/// The parts of the PICA registers that a VertexLoader is set up from.
+struct VertexLoaderConfig : Common::HashableStruct<VertexLoaderConfigState> {
+    explicit VertexLoaderConfig(const PipelineRegs& regs);
+};
+
 class VertexLoader {
 public:
     VertexLoader() = default;
@@ -22,21 +39,61 @@ public:
     }
 
     void Setup(const PipelineRegs& regs);
-    void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
-                    DebugUtils::MemoryAccessTracker& memory_accesses);
+
+    /**
+     * Loads the input attributes of several vertices at once. Each array attribute is converted
+     * for all the vertices with a loader specialised for its format and element count.
+     * @param regs Registers holding the base address and the data offsets of the loaders
+     * @param vertices Vertex numbers (indices into the attribute arrays) to load
+     * @param count Number of vertices to load
+     * @param inputs Attribute buffers to load the vertices into, one per vertex
+     */
+    void LoadVertices(const PipelineRegs& regs, const unsigned int* vertices, std::size_t count,
+                      Shader::AttributeBuffer* inputs,
+                      DebugUtils::MemoryAccessTracker& memory_accesses) const;
 
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
 private:
-    std::array<u32, 16> vertex_attribute_sources;
-    std::array<u32, 16> vertex_attribute_strides{};
-    std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
-    std::array<u32, 16> vertex_attribute_elements{};
-    std::array<bool, 16> vertex_attribute_is_default;
+    /// Converts the elements of one attribute at source into output
+    using LoadFunction = void (*)(const u8* source, Common::Vec4<float24>& output);
+
+    struct ArrayAttribute {
+        u32 index;
+        /// Loader the attribute is read by
+        u32 loader;
+        /// Offset of the attribute from the data offset of its loader
+        u32 source;
+        u32 stride;
+        /// Size of the attribute data of one vertex, in bytes
+        u32 size;
+        LoadFunction load;
+    };
+
+    std::array<ArrayAttribute, 16> array_attributes;
+    std::size_t num_array_attributes = 0;
+    std::array<u32, 16> default_attributes;
+    std::size_t num_default_attributes = 0;
     int num_total_attributes = 0;
     bool is_setup = false;
 };
 
+/**
+ * Returns the loader for the current vertex attribute configuration, setting it up the first time
+ * the configuration is seen. The loader stays valid until the next call. Only to be called from
+ * the GPU thread.
+ */
+const VertexLoader& GetVertexLoader(const PipelineRegs& regs);
+
 } // namespace Pica
+
+namespace std {
+template <>
+struct hash<Pica::VertexLoaderConfig> {
+    std::size_t operator()(const Pica::VertexLoaderConfig& k) const noexcept {
+        return k.Hash();
+    }
+};
+} // namespace std
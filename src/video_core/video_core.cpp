@@ -6,9 +6,11 @@
 #include "common/archives.h"
 #include "common/logging/log.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_null/renderer_null.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
@@ -19,6 +21,7 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+std::unique_ptr<GPUThread> g_gpu_thread;  ///< Asynchronous GPU worker, null if disabled
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
@@ -45,7 +48,11 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
 
     OpenGL::GLES = Settings::values.use_gles;
 
-    g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    if (Settings::values.use_null_renderer) {
+        g_renderer = std::make_unique<RendererNull>(emu_window);
+    } else {
+        g_renderer = std::make_unique<OpenGL::RendererOpenGL>(emu_window);
+    }
     ResultStatus result = g_renderer->Init();
 
     if (result != ResultStatus::Success) {
@@ -54,11 +61,18 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
         LOG_DEBUG(Render, "initialized OK");
     }
 
+    if (Settings::values.use_asynchronous_gpu_emulation) {
+        g_gpu_thread = std::make_unique<GPUThread>();
+    }
+
     return result;
 }
 
 /// Shutdown the video core
 void Shutdown() {
+    // Drain any in-flight GPU work before tearing down the state it operates on
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer->ShutDown();
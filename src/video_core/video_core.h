@@ -24,7 +24,10 @@ class MemorySystem;
 
 namespace VideoCore {
 
+class GPUThread;
+
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+extern std::unique_ptr<GPUThread> g_gpu_thread;  ///< Asynchronous GPU worker, null if disabled
 
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)